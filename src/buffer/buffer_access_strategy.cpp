@@ -0,0 +1,48 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.cpp
+//
+// Identification: src/buffer/buffer_access_strategy.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_access_strategy.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+BufferAccessStrategy::BufferAccessStrategy(size_t ring_size) : ring_size_(ring_size) {
+  BUSTUB_ASSERT(ring_size > 0, "A ring needs at least one frame");
+}
+
+auto BufferAccessStrategy::GetRing(uint32_t instance_index) -> Ring & {
+  if (instance_index >= rings_.size()) {
+    rings_.resize(instance_index + 1);
+  }
+  return rings_[instance_index];
+}
+
+auto BufferAccessStrategy::GetRecycleCandidate(uint32_t instance_index) -> page_id_t {
+  auto &ring = GetRing(instance_index);
+  if (ring.page_ids_.size() < ring_size_) {
+    return INVALID_PAGE_ID;
+  }
+  return ring.page_ids_[ring.current_];
+}
+
+void BufferAccessStrategy::AddToRing(uint32_t instance_index, page_id_t page_id) {
+  auto &ring = GetRing(instance_index);
+  if (ring.page_ids_.size() < ring_size_) {
+    ring.page_ids_.push_back(page_id);
+    return;
+  }
+  ring.page_ids_[ring.current_] = page_id;
+  ring.current_ = (ring.current_ + 1) % ring_size_;
+}
+
+}  // namespace bustub
@@ -0,0 +1,55 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_manager.cpp
+//
+// Identification: src/buffer/buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_manager.h"
+
+#include <cstdio>
+#include <fstream>
+#include <utility>
+
+namespace bustub {
+
+auto BufferPoolManager::SaveResidentPages(const std::string &file_name) -> bool {
+  std::vector<page_id_t> page_ids;
+  GetResidentPgsImp(&page_ids);
+  // Write a new file and move it over the old one, so that a crash never leaves a truncated list behind
+  auto tmp_file_name = file_name + ".tmp";
+  {
+    std::ofstream out(tmp_file_name, std::ios::trunc);
+    for (auto page_id : page_ids) {
+      out << page_id << '\n';
+    }
+    out.flush();
+    if (!out) {
+      return false;
+    }
+  }
+  return std::rename(tmp_file_name.c_str(), file_name.c_str()) == 0;
+}
+
+auto BufferPoolManager::WarmUp(const std::string &file_name) -> bool {
+  std::ifstream in(file_name);
+  if (!in.is_open()) {
+    return false;
+  }
+  std::vector<page_id_t> page_ids;
+  page_id_t page_id;
+  while (in >> page_id) {
+    if (page_id != INVALID_PAGE_ID) {
+      page_ids.push_back(page_id);
+    }
+  }
+  WarmUpPgImp(std::move(page_ids));
+  return true;
+}
+
+}  // namespace bustub
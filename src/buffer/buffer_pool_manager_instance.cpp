@@ -12,29 +12,80 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdlib>
+#include <cstring>
+#include <future>  // NOLINT
+#include <map>
+#include <new>
+#include <utility>
+
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "common/exception.h"
 #include "common/macros.h"
 
 namespace bustub {
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
-                                                     LogManager *log_manager)
-    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager) {}
+                                                     LogManager *log_manager, ReplacerType replacer_type,
+                                                     FrameAllocation frame_allocation)
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager, replacer_type, PageRouting::MODULO,
+                                frame_allocation) {}
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                                                     DiskManager *disk_manager, LogManager *log_manager)
+                                                     DiskManager *disk_manager, LogManager *log_manager,
+                                                     ReplacerType replacer_type, PageRouting routing,
+                                                     FrameAllocation frame_allocation)
     : pool_size_(pool_size),
       num_instances_(num_instances),
       instance_index_(instance_index),
-      next_page_id_(instance_index),
+      routing_(routing),
       disk_manager_(disk_manager),
-      log_manager_(log_manager) {
+      log_manager_(log_manager),
+      page_table_(PAGE_TABLE_SHARDS),
+      num_unpinned_frames_(pool_size) {
   BUSTUB_ASSERT(num_instances > 0, "If BPI is not part of a pool, then the pool size should just be 1");
   BUSTUB_ASSERT(
       instance_index < num_instances,
       "BPI index cannot be greater than the number of BPIs in the pool. In non-parallel case, index should just be 1.");
+  static_assert((PAGE_TABLE_SHARDS & (PAGE_TABLE_SHARDS - 1)) == 0, "PAGE_TABLE_SHARDS must be a power of 2");
+  // New pages continue after the ones already in the database file, with the first id routed to this BPI
+  auto num_pages = static_cast<page_id_t>(disk_manager_->GetNumPages());
+  auto step = static_cast<page_id_t>(num_instances_);
+  auto index = static_cast<page_id_t>(instance_index_);
+  next_page_id_ = routing_ == PageRouting::MODULO ? (num_pages - index + step - 1) / step * step + index : num_pages;
   // We allocate a consecutive memory space for the buffer pool.
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size);
+  if (frame_allocation == FrameAllocation::ARENA) {
+    // Spread the instances of a parallel BPM over the NUMA nodes
+    int numa_node = num_instances > 1 ? static_cast<int>(instance_index % FrameArena::GetNumNumaNodes()) : -1;
+    arena_ = std::make_unique<FrameArena>(pool_size_, numa_node);
+    pages_ = arena_->GetFrames();
+  } else {
+    // The page data is one block too, aligned like the arena's so that O_DIRECT can read into it
+    frame_data_ = static_cast<char *>(aligned_alloc(DiskManager::DIRECT_IO_ALIGNMENT, pool_size_ * PAGE_SIZE));
+    if (frame_data_ == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "can't allocate the buffer pool frames");
+    }
+    memset(frame_data_, 0, pool_size_ * PAGE_SIZE);
+    pages_ = static_cast<Page *>(::operator new(pool_size_ * sizeof(Page)));
+    for (size_t i = 0; i < pool_size_; ++i) {
+      new (&pages_[i]) Page(frame_data_ + i * PAGE_SIZE);
+    }
+  }
+  switch (replacer_type) {
+    case ReplacerType::LRU:
+      replacer_ = new LRUReplacer(pool_size);
+      break;
+    case ReplacerType::CLOCK:
+      replacer_ = new ClockReplacer(pool_size);
+      break;
+    case ReplacerType::LRU_K:
+      replacer_ = new LRUKReplacer(pool_size);
+      break;
+  }
 
   // Initially, every page is in the free list.
   for (size_t i = 0; i < pool_size_; ++i) {
@@ -43,82 +94,174 @@ BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t
 }
 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
-  delete[] pages_;
+  StopBackgroundWriter();
+  StopWarmUp();
+  StopPrefetcher();
+  if (arena_ == nullptr) {
+    for (size_t i = 0; i < pool_size_; ++i) {
+      pages_[i].~Page();
+    }
+    ::operator delete(pages_);
+    free(frame_data_);
+  }
   delete replacer_;
 }
 
+auto BufferPoolManagerInstance::GetShard(page_id_t page_id) -> PageTableShard & {
+  // Multiplicative hashing, so that page ids striding by num_instances_ still spread over all shards
+  auto hash = static_cast<uint32_t>(page_id) * 2654435769U;
+  return page_table_[(hash >> 16) & (PAGE_TABLE_SHARDS - 1)];
+}
+
+auto BufferPoolManagerInstance::LockLatch(std::mutex *latch) -> std::unique_lock<std::mutex> {
+  // Only read the clock when the latch is contended, an uncontended acquisition costs no more than before
+  std::unique_lock lock(*latch, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    auto start = std::chrono::steady_clock::now();
+    lock.lock();
+    latch_wait_ns_.Add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+  }
+  return lock;
+}
+
+auto BufferPoolManagerInstance::GetStats() -> BufferPoolStats {
+  BufferPoolStats stats;
+  // Hits are counted after fetches, so loading them first keeps misses from going negative
+  stats.hits_ = num_hits_.Load();
+  stats.fetches_ = num_fetches_.Load();
+  stats.misses_ = stats.fetches_ - stats.hits_;
+  stats.evictions_ = num_evictions_.Load();
+  stats.dirty_evictions_ = num_foreground_flushes_.Load();
+  stats.background_flushes_ = num_background_flushes_.Load();
+  stats.ring_recycles_ = num_ring_recycles_.Load();
+  stats.prefetches_ = num_prefetches_.Load();
+  stats.pin_failures_ = num_pin_failures_.Load();
+  stats.latch_wait_ns_ = latch_wait_ns_.Load();
+  return stats;
+}
+
 auto BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) -> bool {
   // Make sure you call DiskManager::WritePage!
-  std::scoped_lock guard(latch_);
-  if (!FindPg(page_id)) {
-    return false;
+  auto guard = LockLatch(&latch_);
+  Page *page;
+  {
+    auto &shard = GetShard(page_id);
+    std::scoped_lock shard_guard(shard.latch_);
+    auto it = shard.table_.find(page_id);
+    if (it == shard.table_.end()) {
+      return false;
+    }
+    page = &pages_[it->second];
   }
-  auto frame_id = page_table_[page_id];
-  auto page = &pages_[frame_id];
+  // Holding latch_ keeps the frame from being reassigned while we write it out
   FlushPg(page);
   return true;
 }
 
-bool BufferPoolManagerInstance::FindPg(page_id_t page_id) { return page_table_.count(page_id) != 0; }
-
-void BufferPoolManagerInstance::FlushPg(Page *page) {
-  if (page->IsDirty()) {
+auto BufferPoolManagerInstance::FlushPg(Page *page) -> bool {
+  // Clear the flag before writing: a concurrent unpin marking the page dirty again will get it flushed next time
+  if (page->is_dirty_.exchange(false)) {
+    num_dirty_--;
     disk_manager_->WritePage(page->GetPageId(), page->GetData());
-    page->is_dirty_ = false;
+    return true;
   }
+  return false;
 }
 
 void BufferPoolManagerInstance::FlushAllPgsImp() {
   // You can do it!
-  std::scoped_lock guard(latch_);
-  for (const auto &e : page_table_) {
-    auto page = &pages_[e.second];
-    FlushPg(page);
+  auto guard = LockLatch(&latch_);
+  // Frames only change owner under latch_, so every frame holding a valid page id is resident
+  for (size_t i = 0; i < pool_size_; i++) {
+    auto page = &pages_[i];
+    if (page->GetPageId() != INVALID_PAGE_ID) {
+      FlushPg(page);
+    }
   }
 }
 
-auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
+auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id, BufferAccessStrategy *strategy) -> Page * {
   // 0.   Make sure you call AllocatePage!
   // 1.   If all the pages in the buffer pool are pinned, return nullptr.
   // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
   // 3.   Update P's metadata, zero out memory and add P to the page table.
   // 4.   Set the page ID output parameter. Return a pointer to P.
-  std::scoped_lock guard(latch_);
-  if (AllPgsPinned()) {
-    return nullptr;
-  }
-
+  auto guard = LockLatch(&latch_);
   frame_id_t frame_id;
-  if (!GetFrameId(&frame_id)) {
+  if (AllPgsPinned() || !GetFrameId(&frame_id, strategy)) {
+    num_pin_failures_.Add();
     return nullptr;
   }
 
   auto new_page_id = AllocatePage();
   auto page = &pages_[frame_id];
   ResetPg(page, new_page_id, 1);
-  replacer_->Pin(frame_id);
-  page_table_[new_page_id] = frame_id;
+  auto &shard = GetShard(new_page_id);
+  {
+    std::scoped_lock shard_guard(shard.latch_);
+    shard.table_[new_page_id] = frame_id;
+    replacer_->Pin(frame_id);
+  }
+  if (strategy != nullptr) {
+    strategy->AddToRing(instance_index_, new_page_id);
+  }
   *page_id = new_page_id;
   return page;
 }
 
-bool BufferPoolManagerInstance::AllPgsPinned() {
-  if (page_table_.size() < pool_size_) {
-    return false;
-  }
-
-  return std::all_of(page_table_.begin(), page_table_.end(),
-                     [&](const auto &e) { return pages_[e.second].GetPinCount() > 0; });
-}
+bool BufferPoolManagerInstance::AllPgsPinned() { return num_unpinned_frames_ == 0; }
 
 void BufferPoolManagerInstance::ResetPg(Page *page, page_id_t page_id, int pin_count) {
   page->page_id_ = page_id;
-  page->pin_count_ = pin_count;
-  page->is_dirty_ = false;
+  if (page->pin_count_.exchange(pin_count) == 0 && pin_count > 0) {
+    num_unpinned_frames_--;
+  }
+  if (page->is_dirty_.exchange(false)) {
+    num_dirty_--;
+  }
   page->ResetMemory();
 }
 
-auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
+void BufferPoolManagerInstance::ReleaseFrame(Page *page) {
+  ResetPg(page);
+  num_unpinned_frames_++;
+  free_list_.emplace_back(static_cast<frame_id_t>(page - pages_));
+}
+
+auto BufferPoolManagerInstance::PinResidentPg(page_id_t page_id) -> Page * {
+  auto &shard = GetShard(page_id);
+  auto guard = LockLatch(&shard.latch_);
+  auto it = shard.table_.find(page_id);
+  if (it == shard.table_.end()) {
+    return nullptr;
+  }
+  auto page = &pages_[it->second];
+  // Only the first pin takes the frame out of the replacer
+  if (page->pin_count_++ == 0) {
+    num_unpinned_frames_--;
+    replacer_->Pin(it->second);
+  }
+  return page;
+}
+
+auto BufferPoolManagerInstance::PeekResidentPg(page_id_t page_id) -> Page * {
+  auto &shard = GetShard(page_id);
+  std::scoped_lock guard(shard.latch_);
+  auto it = shard.table_.find(page_id);
+  if (it == shard.table_.end()) {
+    return nullptr;
+  }
+  // Pin the frame without telling the replacer, looking at a page is not an access to it. Evictions re-check the
+  // pin count, and the last unpin puts the frame back into the replacer if an eviction took it out meanwhile.
+  auto page = &pages_[it->second];
+  if (page->pin_count_++ == 0) {
+    num_unpinned_frames_--;
+  }
+  return page;
+}
+
+auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
   // 1.     Search the page table for the requested page (P).
   // 1.1    If P exists, pin it and return it immediately.
   // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
@@ -126,39 +269,205 @@ auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
   // 2.     If R is dirty, write it back to the disk.
   // 3.     Delete R from the page table and insert P.
   // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-  std::scoped_lock guard(latch_);
-  if (FindPg(page_id)) {
-    auto frame_id = page_table_[page_id];
-    auto page = &pages_[frame_id];
-    page->pin_count_++;
-    replacer_->Pin(frame_id);
+  num_fetches_.Add();
+  // Hits only touch the page table shard of page_id
+  if (auto page = PinResidentPg(page_id); page != nullptr) {
+    num_hits_.Add();
+    return page;
+  }
+
+  auto lock = LockLatch(&latch_);
+  WaitForPrefetch(&lock, page_id);
+  // Another miss on the same page may have read it in while we were waiting for latch_
+  if (auto page = PinResidentPg(page_id); page != nullptr) {
+    num_hits_.Add();
     return page;
   }
   frame_id_t frame_id;
-  if (!GetFrameId(&frame_id)) {
+  if (!GetFrameId(&frame_id, strategy)) {
+    num_pin_failures_.Add();
     return nullptr;
   }
 
-  page_table_[page_id] = frame_id;
   auto page = &pages_[frame_id];
   ResetPg(page, page_id, 1);
-  replacer_->Pin(frame_id);
-  disk_manager_->ReadPage(page_id, page->GetData());
+  if (!disk_manager_->ReadPage(page_id, page->GetData())) {
+    // A corrupted page must not be handed out, nor cached for the next fetch to hit
+    ReleaseFrame(page);
+    return nullptr;
+  }
+  // Publish the frame only once its content is in place, hits must never observe a half-read page
+  auto &shard = GetShard(page_id);
+  {
+    std::scoped_lock shard_guard(shard.latch_);
+    shard.table_[page_id] = frame_id;
+    replacer_->Pin(frame_id);
+  }
+  if (strategy != nullptr) {
+    strategy->AddToRing(instance_index_, page_id);
+  }
   return page;
 }
 
-bool BufferPoolManagerInstance::GetFrameId(frame_id_t *frame_id) {
+auto BufferPoolManagerInstance::FetchPgsImp(const std::vector<page_id_t> &page_ids, std::vector<Page *> *pages)
+    -> bool {
+  pages->assign(page_ids.size(), nullptr);
+  bool all_fetched = true;
+  bool any_miss = false;
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    num_fetches_.Add();
+    (*pages)[i] = PinResidentPg(page_ids[i]);
+    if ((*pages)[i] != nullptr) {
+      num_hits_.Add();
+    } else {
+      any_miss = true;
+    }
+  }
+  if (!any_miss) {
+    return true;
+  }
+
+  // Reserve frames for all the misses under a single acquisition of latch_. The frames are only published once the
+  // whole batch is read in, ordered by page id so that consecutive pages end up in one disk request.
+  auto lock = LockLatch(&latch_);
+  // Waiting releases latch_, so wait for all the pages being read ahead before reserving any frame: another miss
+  // must not read in a page this batch has already reserved a frame for
+  prefetch_cv_.wait(lock, [&] {
+    for (size_t i = 0; i < page_ids.size(); i++) {
+      if ((*pages)[i] == nullptr && prefetching_.count(page_ids[i]) != 0) {
+        return false;
+      }
+    }
+    return true;
+  });
+  std::map<page_id_t, Page *> to_read;
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    if ((*pages)[i] != nullptr) {
+      continue;
+    }
+    auto page_id = page_ids[i];
+    if (auto it = to_read.find(page_id); it != to_read.end()) {
+      it->second->pin_count_++;
+      (*pages)[i] = it->second;
+      continue;
+    }
+    if (auto page = PinResidentPg(page_id); page != nullptr) {
+      num_hits_.Add();
+      (*pages)[i] = page;
+      continue;
+    }
+    frame_id_t frame_id;
+    if (!GetFrameId(&frame_id, nullptr)) {
+      num_pin_failures_.Add();
+      all_fetched = false;
+      continue;
+    }
+    auto page = &pages_[frame_id];
+    ResetPg(page, page_id, 1);
+    to_read[page_id] = page;
+    (*pages)[i] = page;
+  }
+
+  std::vector<char *> buffers;
+  std::vector<std::pair<page_id_t, size_t>> failed_runs;
+  for (auto it = to_read.begin(); it != to_read.end();) {
+    auto first_page_id = it->first;
+    buffers.clear();
+    for (; it != to_read.end() && it->first == first_page_id + static_cast<page_id_t>(buffers.size()); ++it) {
+      buffers.push_back(it->second->GetData());
+    }
+    if (!disk_manager_->ReadPages(first_page_id, buffers.size(), buffers.data())) {
+      failed_runs.emplace_back(first_page_id, buffers.size());
+    }
+  }
+  // Read the runs which failed again page by page, to tell the corrupted pages from the good ones
+  for (auto [first_page_id, num_pages] : failed_runs) {
+    for (auto page_id = first_page_id; page_id < first_page_id + static_cast<page_id_t>(num_pages); page_id++) {
+      auto page = to_read[page_id];
+      if (disk_manager_->ReadPage(page_id, page->GetData())) {
+        continue;
+      }
+      std::replace(pages->begin(), pages->end(), page, static_cast<Page *>(nullptr));
+      to_read.erase(page_id);
+      ReleaseFrame(page);
+      all_fetched = false;
+    }
+  }
+  for (const auto &[page_id, page] : to_read) {
+    auto frame_id = static_cast<frame_id_t>(page - pages_);
+    auto &shard = GetShard(page_id);
+    std::scoped_lock shard_guard(shard.latch_);
+    shard.table_[page_id] = frame_id;
+    replacer_->Pin(frame_id);
+  }
+  return all_fetched;
+}
+
+bool BufferPoolManagerInstance::GetFrameId(frame_id_t *frame_id, BufferAccessStrategy *strategy) {
+  // A bulk operation recycles the frames of its own ring first, so that it does not push anyone else's pages out
+  if (strategy != nullptr && RecycleRingFrame(strategy->GetRecycleCandidate(instance_index_), frame_id)) {
+    return true;
+  }
   if (!free_list_.empty()) {
     *frame_id = free_list_.front();
     free_list_.pop_front();
     return true;
   }
-  if (!replacer_->Victim(frame_id)) {
+  while (true) {
+    bool skipped_cleaning = false;
+    while (replacer_->Victim(frame_id)) {
+      auto page = &pages_[*frame_id];
+      auto &shard = GetShard(page->GetPageId());
+      {
+        std::scoped_lock shard_guard(shard.latch_);
+        // A hit may have pinned the victim after the replacer handed it out. Leave it be, its last unpin puts it
+        // back into the replacer.
+        if (page->GetPinCount() > 0) {
+          continue;
+        }
+        // The background writer puts the frame back into the replacer once its write completed
+        if (IsBeingCleaned(*frame_id)) {
+          skipped_cleaning = true;
+          continue;
+        }
+        shard.table_.erase(page->GetPageId());
+      }
+      // The page is unreachable now, so it can be written out without holding the shard latch
+      num_evictions_.Add();
+      if (FlushPg(page)) {
+        num_foreground_flushes_.Add();
+      }
+      return true;
+    }
+    if (!skipped_cleaning) {
+      return false;
+    }
+    // Only frames being written out are left, they are evictable as soon as the writes completed
+    WaitForCleaning();
+  }
+}
+
+auto BufferPoolManagerInstance::RecycleRingFrame(page_id_t page_id, frame_id_t *frame_id) -> bool {
+  if (page_id == INVALID_PAGE_ID) {
     return false;
   }
-  auto page = &pages_[*frame_id];
-  FlushPg(page);
-  page_table_.erase(page->GetPageId());
+  auto &shard = GetShard(page_id);
+  {
+    std::scoped_lock shard_guard(shard.latch_);
+    auto it = shard.table_.find(page_id);
+    // The page may have been evicted since, be in use by someone else or be being written out
+    if (it == shard.table_.end() || pages_[it->second].GetPinCount() > 0 || IsBeingCleaned(it->second)) {
+      return false;
+    }
+    *frame_id = it->second;
+    shard.table_.erase(it);
+    replacer_->Pin(*frame_id);
+  }
+  num_evictions_.Add();
+  num_ring_recycles_.Add();
+  if (FlushPg(&pages_[*frame_id])) {
+    num_foreground_flushes_.Add();
+  }
   return true;
 }
 
@@ -168,19 +477,38 @@ auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
   // 1.   If P does not exist, return true.
   // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
   // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
-  std::scoped_lock guard(latch_);
-  if (!FindPg(page_id)) {
-    return true;
+  auto lock = LockLatch(&latch_);
+  WaitForPrefetch(&lock, page_id);
+  frame_id_t frame_id;
+  {
+    auto &shard = GetShard(page_id);
+    std::unique_lock shard_lock(shard.latch_);
+    while (true) {
+      auto it = shard.table_.find(page_id);
+      if (it == shard.table_.end()) {
+        // Not in the buffer pool, but on disk still
+        DeallocatePage(page_id);
+        return true;
+      }
+      frame_id = it->second;
+      if (pages_[frame_id].GetPinCount() > 0) {
+        return false;
+      }
+      if (!IsBeingCleaned(frame_id)) {
+        shard.table_.erase(it);
+        break;
+      }
+      // The background writer puts the frame back into the replacer once done, it must not be free by then
+      shard_lock.unlock();
+      WaitForCleaning();
+      shard_lock.lock();
+    }
+    // The frame goes to the free list, it must not be handed out by the replacer as well
+    replacer_->Pin(frame_id);
   }
 
-  auto frame_id = page_table_[page_id];
   auto page = &pages_[frame_id];
-  if (page->GetPinCount() > 0) {
-    return false;
-  }
-
   FlushPg(page);
-  page_table_.erase(page_id);
   ResetPg(page);
   free_list_.emplace_back(frame_id);
 
@@ -189,34 +517,399 @@ auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
 }
 
 auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
-  std::scoped_lock guard(latch_);
-  if (!FindPg(page_id)) {
+  auto &shard = GetShard(page_id);
+  auto guard = LockLatch(&shard.latch_);
+  auto it = shard.table_.find(page_id);
+  if (it == shard.table_.end()) {
     return false;
   }
-  auto frame_id = page_table_[page_id];
+  auto frame_id = it->second;
   auto page = &pages_[frame_id];
   if (page->GetPinCount() <= 0) {
     return false;
   }
-  if (is_dirty) {
-    page->is_dirty_ = true;
+  if (is_dirty && !page->is_dirty_.exchange(true)) {
+    num_dirty_++;
+    if (DirtyRatio() > bg_writer_dirty_ratio_high_) {
+      bg_writer_cv_.notify_one();
+    }
   }
-  page->pin_count_--;
-  if (page->GetPinCount() == 0) {
+  if (--page->pin_count_ == 0) {
+    num_unpinned_frames_++;
     replacer_->Unpin(frame_id);
   }
   return true;
 }
 
+void BufferPoolManagerInstance::RunBackgroundWriter(double dirty_ratio_low, double dirty_ratio_high) {
+  std::scoped_lock guard(bg_writer_latch_);
+  if (bg_writer_running_) {
+    return;
+  }
+  bg_writer_dirty_ratio_low_ = dirty_ratio_low;
+  bg_writer_dirty_ratio_high_ = dirty_ratio_high;
+  bg_writer_running_ = true;
+  if (async_disk_manager_ == nullptr) {
+    async_disk_manager_ = std::make_unique<AsyncDiskManager>(disk_manager_);
+  }
+  bg_writer_thread_ = std::thread(&BufferPoolManagerInstance::BackgroundWriterLoop, this);
+}
+
+void BufferPoolManagerInstance::StopBackgroundWriter() {
+  {
+    std::scoped_lock guard(bg_writer_latch_);
+    if (!bg_writer_running_) {
+      return;
+    }
+    bg_writer_running_ = false;
+    bg_writer_dirty_ratio_high_ = 1.0;
+  }
+  bg_writer_cv_.notify_one();
+  bg_writer_thread_.join();
+}
+
+void BufferPoolManagerInstance::BackgroundWriterLoop() {
+  std::unique_lock<std::mutex> lock(bg_writer_latch_);
+  bool made_progress = false;
+  while (bg_writer_running_) {
+    // Keep cleaning right away while above the high watermark, unless the last round could not clean anything
+    if (!made_progress || DirtyRatio() <= bg_writer_dirty_ratio_high_) {
+      bg_writer_cv_.wait_for(lock, bg_writer_interval);
+    }
+    made_progress = false;
+    if (bg_writer_running_ && DirtyRatio() > bg_writer_dirty_ratio_low_) {
+      lock.unlock();
+      made_progress = CleanFrames() > 0;
+      lock.lock();
+    }
+  }
+}
+
+auto BufferPoolManagerInstance::CleanFrames() -> size_t {
+  // Snapshot the frames closest to eviction. Frames only change owner under latch_, so the page ids are consistent.
+  std::vector<frame_id_t> frame_ids;
+  std::vector<page_id_t> page_ids;
+  {
+    auto guard = LockLatch(&latch_);
+    replacer_->PeekVictims(BG_WRITER_MAX_PAGES, &frame_ids);
+    for (auto frame_id : frame_ids) {
+      page_ids.push_back(pages_[frame_id].GetPageId());
+    }
+  }
+
+  auto release = [&](frame_id_t frame_id, page_id_t page_id) {
+    {
+      std::scoped_lock shard_guard(GetShard(page_id).latch_);
+      {
+        std::scoped_lock cleaning_guard(cleaning_latch_);
+        cleaning_.erase(frame_id);
+      }
+      // A no-op unless an eviction skipped the frame meanwhile, which took it out of the replacer
+      if (pages_[frame_id].GetPinCount() == 0) {
+        replacer_->Unpin(frame_id);
+      }
+    }
+    cleaning_cv_.notify_all();
+  };
+
+  // Queue the writes of all the dirty frames first, then hand them to the disk together and wait for them
+  std::vector<std::pair<size_t, std::future<bool>>> writes;
+  for (size_t i = 0; i < frame_ids.size() && DirtyRatio() > bg_writer_dirty_ratio_low_; i++) {
+    auto frame_id = frame_ids[i];
+    auto page = &pages_[frame_id];
+    {
+      auto &shard = GetShard(page_ids[i]);
+      std::scoped_lock shard_guard(shard.latch_);
+      auto it = shard.table_.find(page_ids[i]);
+      if (it == shard.table_.end() || it->second != frame_id || page->GetPinCount() > 0 || !page->IsDirty()) {
+        continue;
+      }
+      // Keep the frame from being evicted while being written out. It is not pinned, so it still counts as
+      // unpinned for new pages and stays in the replacer, where cleaning does not move it away from the tail.
+      std::scoped_lock cleaning_guard(cleaning_latch_);
+      cleaning_.insert(frame_id);
+    }
+
+    // Waiting for a latch could deadlock with a thread which holds it and waits for the frames queued before to be
+    // cleaned. A latched page is in use and not about to be evicted anyway, skip it.
+    if (!page->TryRLatch()) {
+      release(frame_id, page_ids[i]);
+      continue;
+    }
+    if (!page->is_dirty_.exchange(false)) {
+      page->RUnlatch();
+      release(frame_id, page_ids[i]);
+      continue;
+    }
+    num_dirty_--;
+    // The write goes out from a copy taken before WritePageAsync returns, writers to the page need not wait for it
+    writes.emplace_back(i, async_disk_manager_->WritePageAsync(page_ids[i], page->GetData()));
+    page->RUnlatch();
+  }
+  async_disk_manager_->Submit();
+
+  size_t num_cleaned = 0;
+  for (auto &[i, write] : writes) {
+    auto page = &pages_[frame_ids[i]];
+    if (write.get()) {
+      num_background_flushes_.Add();
+      num_cleaned++;
+    } else if (!page->is_dirty_.exchange(true)) {
+      // Keep the page dirty, so that its eviction tries again
+      num_dirty_++;
+    }
+    release(frame_ids[i], page_ids[i]);
+  }
+  return num_cleaned;
+}
+
+auto BufferPoolManagerInstance::IsBeingCleaned(frame_id_t frame_id) -> bool {
+  std::scoped_lock guard(cleaning_latch_);
+  return cleaning_.count(frame_id) != 0;
+}
+
+void BufferPoolManagerInstance::WaitForCleaning() {
+  std::unique_lock lock(cleaning_latch_);
+  cleaning_cv_.wait(lock, [&] { return cleaning_.empty(); });
+}
+
+void BufferPoolManagerInstance::WaitForPrefetch(std::unique_lock<std::mutex> *lock, page_id_t page_id) {
+  // A page being read ahead is resident shortly, wait for it rather than reading it a second time
+  prefetch_cv_.wait(*lock, [&] { return prefetching_.count(page_id) == 0; });
+}
+
+void BufferPoolManagerInstance::PrefetchPgImp(page_id_t page_id, size_t num_pages, size_t next_page_id_offset) {
+  if (page_id == INVALID_PAGE_ID || num_pages == 0) {
+    return;
+  }
+  std::scoped_lock guard(prefetch_latch_);
+  // Read-ahead is only a hint, drop it rather than queueing up stale requests
+  if (prefetch_stopped_ || prefetch_queue_.size() >= PREFETCH_QUEUE_SIZE) {
+    return;
+  }
+  if (!prefetch_running_) {
+    prefetch_running_ = true;
+    prefetch_thread_ = std::thread(&BufferPoolManagerInstance::PrefetchLoop, this);
+  }
+  prefetch_queue_.push_back({page_id, num_pages, next_page_id_offset});
+  prefetch_queue_cv_.notify_one();
+}
+
+void BufferPoolManagerInstance::StopPrefetcher() {
+  {
+    std::scoped_lock guard(prefetch_latch_);
+    prefetch_stopped_ = true;
+    if (!prefetch_running_) {
+      return;
+    }
+    prefetch_running_ = false;
+  }
+  prefetch_queue_cv_.notify_one();
+  prefetch_thread_.join();
+}
+
+void BufferPoolManagerInstance::PrefetchLoop() {
+  std::unique_lock<std::mutex> lock(prefetch_latch_);
+  while (true) {
+    prefetch_queue_cv_.wait(lock, [&] { return !prefetch_running_ || !prefetch_queue_.empty(); });
+    if (!prefetch_running_) {
+      return;
+    }
+    auto request = prefetch_queue_.front();
+    prefetch_queue_.pop_front();
+    lock.unlock();
+
+    auto page = PeekResidentPg(request.page_id_);
+    if (page == nullptr) {
+      page = ReadAheadPg(request.page_id_);
+    }
+    if (page != nullptr) {
+      page_id_t next_page_id = INVALID_PAGE_ID;
+      if (request.num_pages_ > 1) {
+        page->RLatch();
+        memcpy(&next_page_id, page->GetData() + request.next_page_id_offset_, sizeof(page_id_t));
+        page->RUnlatch();
+      }
+      UnpinPgImp(request.page_id_, false);
+      // The next page of the chain may belong to another instance of the parallel BPM
+      if (next_page_id != INVALID_PAGE_ID) {
+        prefetch_router_->PrefetchRange(next_page_id, request.num_pages_ - 1, request.next_page_id_offset_);
+      }
+    }
+    lock.lock();
+  }
+}
+
+auto BufferPoolManagerInstance::ReadAheadPg(page_id_t page_id, bool warm_up) -> Page * {
+  frame_id_t frame_id;
+  Page *page;
+  {
+    auto guard = LockLatch(&latch_);
+    if (prefetching_.count(page_id) > 0) {
+      return nullptr;
+    }
+    if (page = PeekResidentPg(page_id); page != nullptr) {
+      return page;
+    }
+    // Warming up only fills free frames, read-ahead recycles its own ring
+    if (warm_up ? free_list_.empty() : !GetFrameId(&frame_id, &prefetch_strategy_)) {
+      return nullptr;
+    }
+    if (warm_up) {
+      frame_id = free_list_.front();
+      free_list_.pop_front();
+    }
+    page = &pages_[frame_id];
+    ResetPg(page, page_id, 1);
+    prefetching_.insert(page_id);
+  }
+
+  // The frame is reserved but unreachable, so the read does not need to hold latch_
+  bool read = disk_manager_->ReadPage(page_id, page->GetData());
+  {
+    auto guard = LockLatch(&latch_);
+    if (!read) {
+      // Leave the corrupted page to the fetch waiting for it, which fails on it in turn
+      ReleaseFrame(page);
+      prefetching_.erase(page_id);
+      guard.unlock();
+      prefetch_cv_.notify_all();
+      return nullptr;
+    }
+    auto &shard = GetShard(page_id);
+    {
+      // Not an access yet: the frame enters the replacer on unpin, without a reference to the page
+      std::scoped_lock shard_guard(shard.latch_);
+      shard.table_[page_id] = frame_id;
+    }
+    if (!warm_up) {
+      prefetch_strategy_.AddToRing(instance_index_, page_id);
+    }
+    prefetching_.erase(page_id);
+  }
+  prefetch_cv_.notify_all();
+  num_prefetches_.Add();
+  return page;
+}
+
+void BufferPoolManagerInstance::GetResidentPgsImp(std::vector<page_id_t> *page_ids) {
+  // Frames only change owner under latch_. The replacer holds the unpinned frames, the rest are in use right now.
+  auto guard = LockLatch(&latch_);
+  std::vector<frame_id_t> victims;
+  replacer_->PeekVictims(pool_size_, &victims);
+  std::vector<bool> listed(pool_size_, false);
+  for (auto frame_id : victims) {
+    listed[frame_id] = true;
+  }
+  for (size_t i = 0; i < pool_size_; i++) {
+    if (!listed[i] && pages_[i].GetPageId() != INVALID_PAGE_ID && pages_[i].GetPinCount() > 0) {
+      page_ids->push_back(pages_[i].GetPageId());
+    }
+  }
+  for (auto it = victims.rbegin(); it != victims.rend(); ++it) {
+    if (pages_[*it].GetPageId() != INVALID_PAGE_ID) {
+      page_ids->push_back(pages_[*it].GetPageId());
+    }
+  }
+}
+
+void BufferPoolManagerInstance::WarmUpPgImp(std::vector<page_id_t> page_ids) {
+  std::scoped_lock guard(warm_up_latch_);
+  StopWarmUp();
+  warm_up_stopped_ = false;
+  warm_up_thread_ = std::thread(&BufferPoolManagerInstance::WarmUpLoop, this, std::move(page_ids));
+}
+
+void BufferPoolManagerInstance::StopWarmUp() {
+  warm_up_stopped_ = true;
+  if (warm_up_thread_.joinable()) {
+    warm_up_thread_.join();
+  }
+}
+
+void BufferPoolManagerInstance::WarmUpLoop(std::vector<page_id_t> page_ids) {
+  // Keep the most recently used pages which fit, then read them in page id order so that the reads are sequential
+  size_t num_free_frames;
+  {
+    auto guard = LockLatch(&latch_);
+    num_free_frames = free_list_.size();
+  }
+  if (page_ids.size() > num_free_frames) {
+    page_ids.resize(num_free_frames);
+  }
+  std::sort(page_ids.begin(), page_ids.end());
+  for (auto page_id : page_ids) {
+    if (warm_up_stopped_) {
+      return;
+    }
+    if (auto page = PeekResidentPg(page_id); page != nullptr) {
+      UnpinPgImp(page_id, false);
+      continue;
+    }
+    // The frames may have been taken by the workload meanwhile, stop rather than evict its pages
+    if (ReadAheadPg(page_id, true) == nullptr) {
+      auto guard = LockLatch(&latch_);
+      if (free_list_.empty()) {
+        return;
+      }
+      continue;
+    }
+    UnpinPgImp(page_id, false);
+  }
+}
+
+auto BufferPoolManagerInstance::GetNumResidentPages() -> size_t {
+  size_t num_resident_pages = 0;
+  for (auto &shard : page_table_) {
+    std::scoped_lock guard(shard.latch_);
+    num_resident_pages += shard.table_.size();
+  }
+  return num_resident_pages;
+}
+
+auto BufferPoolManagerInstance::GetInstanceIndex(page_id_t page_id, uint32_t num_instances, PageRouting routing)
+    -> uint32_t {
+  if (routing == PageRouting::MODULO) {
+    return page_id % num_instances;
+  }
+  // The MurmurHash3 finalizer. It has to differ from the page table shard hash, or else the pages routed to a BPI
+  // would all end up in the same few shards.
+  auto hash = static_cast<uint32_t>(page_id);
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6bU;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35U;
+  hash ^= hash >> 16;
+  return hash % num_instances;
+}
+
 auto BufferPoolManagerInstance::AllocatePage() -> page_id_t {
-  const page_id_t next_page_id = next_page_id_;
-  next_page_id_ += num_instances_;
+  // Fill the holes of the file before growing it
+  auto free_page_id = disk_manager_->AllocateFreePage(
+      [this](page_id_t page_id) { return GetInstanceIndex(page_id, num_instances_, routing_) == instance_index_; });
+  if (free_page_id != INVALID_PAGE_ID) {
+    return free_page_id;
+  }
+  // Page ids routed to this BPI are evenly strided under MODULO routing, under HASH routing skip the others' ids
+  const page_id_t step = routing_ == PageRouting::MODULO ? num_instances_ : 1;
+  page_id_t next_page_id;
+  do {
+    next_page_id = next_page_id_.fetch_add(step);
+  } while (GetInstanceIndex(next_page_id, num_instances_, routing_) != instance_index_);
   ValidatePageId(next_page_id);
   return next_page_id;
 }
 
+void BufferPoolManagerInstance::DeallocatePage(page_id_t page_id) {
+  if (page_id < 0 || page_id >= next_page_id_.load() ||
+      GetInstanceIndex(page_id, num_instances_, routing_) != instance_index_) {
+    return;
+  }
+  disk_manager_->DeallocatePage(page_id);
+}
+
 void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
-  assert(page_id % num_instances_ == instance_index_);  // allocated pages mod back to this BPI
+  assert(GetInstanceIndex(page_id, num_instances_, routing_) == instance_index_);  // allocated pages route to this BPI
 }
 
 }  // namespace bustub
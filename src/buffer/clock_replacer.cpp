@@ -12,18 +12,65 @@
 
 #include "buffer/clock_replacer.h"
 
+#include <algorithm>
+
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages)
+    : num_pages_(num_pages), states_(std::make_unique<std::atomic<uint8_t>[]>(num_pages)) {
+  for (size_t i = 0; i < num_pages_; i++) {
+    states_[i] = ABSENT;
+  }
+}
 
 ClockReplacer::~ClockReplacer() = default;
 
-auto ClockReplacer::Victim(frame_id_t *frame_id) -> bool { return false; }
+auto ClockReplacer::Victim(frame_id_t *frame_id) -> bool {
+  // Two sweeps are enough to clear every reference bit and find a victim, the third one gives some slack for frames
+  // concurrently leaving and re-entering the replacer
+  for (size_t i = 0; i < 3 * num_pages_ && size_ > 0; i++) {
+    auto idx = clock_hand_.fetch_add(1) % num_pages_;
+    auto state = states_[idx].load();
+    if (state == REFERENCED) {
+      // Second chance, losing the race against Pin or another sweeper is fine
+      states_[idx].compare_exchange_strong(state, UNREFERENCED);
+    } else if (state == UNREFERENCED && states_[idx].compare_exchange_strong(state, ABSENT)) {
+      size_--;
+      *frame_id = static_cast<frame_id_t>(idx);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ClockReplacer::Pin(frame_id_t frame_id) {
+  // frame被引用，从clock_replacer删除
+  if (states_[frame_id].exchange(ABSENT) != ABSENT) {
+    size_--;
+  }
+}
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+  // frame没被引用，加入clock_replacer等待被换出；已在其中的frame保持原状态
+  uint8_t expected = ABSENT;
+  if (states_[frame_id].compare_exchange_strong(expected, REFERENCED)) {
+    size_++;
+  }
+}
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+auto ClockReplacer::Size() -> size_t { return std::max<int64_t>(size_, 0); }
 
-auto ClockReplacer::Size() -> size_t { return 0; }
+void ClockReplacer::PeekVictims(size_t max_frames, std::vector<frame_id_t> *frame_ids) {
+  // Frames the hand will take on its first sweep, then the ones which only lose their reference bit on it
+  auto hand = clock_hand_.load();
+  for (auto wanted : {UNREFERENCED, REFERENCED}) {
+    for (size_t i = 0; i < num_pages_ && frame_ids->size() < max_frames; i++) {
+      auto idx = (hand + i) % num_pages_;
+      if (states_[idx] == wanted) {
+        frame_ids->push_back(static_cast<frame_id_t>(idx));
+      }
+    }
+  }
+}
 
 }  // namespace bustub
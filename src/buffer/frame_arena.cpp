@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include <cstdint>
+#include <fstream>
+#include <new>
+#include <string>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+namespace {
+
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+/** MPOL_PREFERRED from <numaif.h>: allocate on the given node, fall back to the others when it runs out of memory */
+constexpr int MPOL_PREFERRED_NODE = 1;
+
+auto RoundUp(size_t size, size_t alignment) -> size_t { return (size + alignment - 1) / alignment * alignment; }
+
+/** Map an anonymous region aligned to a huge page, using reserved huge pages if there are any. */
+auto MapAligned(size_t size, bool *huge_pages) -> void * {
+#ifdef MAP_HUGETLB
+  void *huge = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (huge != MAP_FAILED) {
+    *huge_pages = true;
+    return huge;
+  }
+#endif
+  // No huge pages reserved: over-allocate and trim, so that transparent huge pages can back the whole region
+  *huge_pages = false;
+  void *memory = mmap(nullptr, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    return nullptr;
+  }
+  auto begin = reinterpret_cast<uintptr_t>(memory);
+  auto aligned = RoundUp(begin, HUGE_PAGE_SIZE);
+  if (aligned > begin) {
+    munmap(memory, aligned - begin);
+  }
+  if (begin + HUGE_PAGE_SIZE > aligned) {
+    munmap(reinterpret_cast<void *>(aligned + size), begin + HUGE_PAGE_SIZE - aligned);
+  }
+#ifdef MADV_HUGEPAGE
+  madvise(reinterpret_cast<void *>(aligned), size, MADV_HUGEPAGE);
+#endif
+  return reinterpret_cast<void *>(aligned);
+}
+
+/** Ask the kernel to place the region on a NUMA node. It is only a preference, failures are ignored. */
+void BindToNumaNode(void *memory, size_t size, int numa_node) {
+#if defined(__linux__) && defined(SYS_mbind)
+  constexpr int max_node = 64;
+  if (numa_node < 0 || numa_node >= max_node) {
+    return;
+  }
+  uint64_t node_mask = 1ULL << numa_node;
+  if (syscall(SYS_mbind, memory, size, MPOL_PREFERRED_NODE, &node_mask, max_node + 1, 0) != 0) {
+    LOG_DEBUG("Could not bind the frame arena to NUMA node %d", numa_node);
+  }
+#endif
+}
+
+}  // namespace
+
+FrameArena::FrameArena(size_t num_frames, int numa_node)
+    : num_frames_(num_frames), size_(RoundUp(num_frames * (PAGE_SIZE + sizeof(Page)), HUGE_PAGE_SIZE)) {
+  void *memory = MapAligned(size_, &huge_pages_);
+  if (memory == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "can't map the frame arena");
+  }
+  // Bind before constructing the frames, memory is placed on the node that first touches it
+  BindToNumaNode(memory, size_, numa_node);
+  memory_ = static_cast<char *>(memory);
+  // The mapping is zeroed already, so is the page data
+  frames_ = reinterpret_cast<Page *>(memory_ + num_frames_ * PAGE_SIZE);
+  for (size_t i = 0; i < num_frames_; i++) {
+    new (&frames_[i]) Page(memory_ + i * PAGE_SIZE);
+  }
+}
+
+FrameArena::~FrameArena() {
+  for (size_t i = 0; i < num_frames_; i++) {
+    frames_[i].~Page();
+  }
+  munmap(memory_, size_);
+}
+
+auto FrameArena::GetNumNumaNodes() -> int {
+  // The online nodes are listed as ranges, e.g. "0-1"; the last number is the highest node
+  std::ifstream online("/sys/devices/system/node/online");
+  std::string nodes;
+  if (!(online >> nodes) || nodes.empty()) {
+    return 1;
+  }
+  auto last = nodes.find_last_of(",-");
+  try {
+    return std::stoi(last == std::string::npos ? nodes : nodes.substr(last + 1)) + 1;
+  } catch (const std::exception &) {
+    return 1;
+  }
+}
+
+}  // namespace bustub
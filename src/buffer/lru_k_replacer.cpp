@@ -0,0 +1,89 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.cpp
+//
+// Identification: src/buffer/lru_k_replacer.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+namespace bustub {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k, size_t correlated_period)
+    : k_(k), correlated_period_(correlated_period), frames_(num_pages) {}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+auto LRUKReplacer::Victim(frame_id_t *frame_id) -> bool {
+  std::scoped_lock guard(latch_);
+  if (evictable_.empty()) {
+    return false;
+  }
+  *frame_id = evictable_.begin()->second;
+  evictable_.erase(evictable_.begin());
+  // The frame will hold another page, its history does not apply anymore
+  frames_[*frame_id] = FrameHistory();
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  // frame被引用，记录访问历史，并从lru_k_replacer删除
+  std::scoped_lock guard(latch_);
+  auto &frame = frames_[frame_id];
+  if (frame.evictable_) {
+    evictable_.erase(GetEvictionKey(frame_id));
+    frame.evictable_ = false;
+  }
+  RecordAccess(frame_id);
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  // frame没被引用，加入lru_k_replacer等待被换出
+  std::scoped_lock guard(latch_);
+  auto &frame = frames_[frame_id];
+  if (frame.evictable_) {
+    return;
+  }
+  if (frame.accesses_.empty()) {
+    RecordAccess(frame_id);
+  }
+  frame.evictable_ = true;
+  evictable_.insert(GetEvictionKey(frame_id));
+}
+
+auto LRUKReplacer::Size() -> size_t {
+  std::scoped_lock guard(latch_);
+  return evictable_.size();
+}
+
+void LRUKReplacer::PeekVictims(size_t max_frames, std::vector<frame_id_t> *frame_ids) {
+  std::scoped_lock guard(latch_);
+  for (auto it = evictable_.begin(); it != evictable_.end() && frame_ids->size() < max_frames; ++it) {
+    frame_ids->push_back(it->second);
+  }
+}
+
+void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+  auto now = ++current_timestamp_;
+  auto &accesses = frames_[frame_id].accesses_;
+  if (!accesses.empty() && now - accesses.front() <= correlated_period_) {
+    accesses.front() = now;
+    return;
+  }
+  accesses.push_front(now);
+  if (accesses.size() > k_) {
+    accesses.pop_back();
+  }
+}
+
+auto LRUKReplacer::GetEvictionKey(frame_id_t frame_id) -> EvictionKey {
+  const auto &accesses = frames_[frame_id].accesses_;
+  return {{accesses.size() >= k_, accesses.back()}, frame_id};
+}
+
+}  // namespace bustub
@@ -62,4 +62,11 @@ auto LRUReplacer::Size() -> size_t {
   return recent_.size();
 }
 
+void LRUReplacer::PeekVictims(size_t max_frames, std::vector<frame_id_t> *frame_ids) {
+  std::scoped_lock guard(latch_);
+  for (auto it = recent_.rbegin(); it != recent_.rend() && frame_ids->size() < max_frames; ++it) {
+    frame_ids->push_back(*it);
+  }
+}
+
 }  // namespace bustub
@@ -0,0 +1,169 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// mmap_buffer_pool_manager.cpp
+//
+// Identification: src/buffer/mmap_buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/mmap_buffer_pool_manager.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "storage/disk/compressed_page_store.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+MmapBufferPoolManager::MmapBufferPoolManager(const std::string &db_file) {
+  fd_ = open(db_file.c_str(), O_RDONLY);
+  if (fd_ < 0) {
+    throw Exception("can't open db file");
+  }
+  if (CompressedPageStore::IsCompressedFile(fd_)) {
+    close(fd_);
+    throw Exception("can't map a compressed db file");
+  }
+  struct stat stat_buf;
+  if (fstat(fd_, &stat_buf) != 0) {
+    close(fd_);
+    throw Exception("can't stat db file");
+  }
+  // A trailing partial page was never written completely, leave it out
+  num_pages_ = static_cast<size_t>(stat_buf.st_size) / PAGE_SIZE;
+  if (num_pages_ > 0) {
+    void *data = mmap(nullptr, num_pages_ * PAGE_SIZE, PROT_READ, MAP_SHARED, fd_, 0);
+    if (data == MAP_FAILED) {
+      close(fd_);
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "can't map db file");
+    }
+    data_ = static_cast<char *>(data);
+  }
+  views_ = std::make_unique<std::atomic<Page *>[]>(num_pages_);
+}
+
+MmapBufferPoolManager::~MmapBufferPoolManager() {
+  for (size_t i = 0; i < num_pages_; i++) {
+    delete views_[i].load();
+  }
+  if (data_ != nullptr) {
+    munmap(data_, num_pages_ * PAGE_SIZE);
+  }
+  close(fd_);
+}
+
+auto MmapBufferPoolManager::GetStats() -> BufferPoolStats {
+  BufferPoolStats stats;
+  // Every page is resident, a fetch is either a hit or fails before it is counted
+  stats.fetches_ = num_fetches_.Load();
+  stats.hits_ = stats.fetches_;
+  stats.prefetches_ = num_prefetches_.Load();
+  return stats;
+}
+
+auto MmapBufferPoolManager::GetView(page_id_t page_id) -> Page * {
+  auto &slot = views_[page_id];
+  Page *page = slot.load(std::memory_order_acquire);
+  if (page != nullptr) {
+    return page;
+  }
+  // The page is verified once, when its view is created. A corrupted page gets no view, it fails every fetch.
+  auto data = data_ + static_cast<size_t>(page_id) * PAGE_SIZE;
+  if (!DiskManager::ChecksumMatches(data)) {
+    LOG_WARN("checksum mismatch, page %d is corrupted", page_id);
+    return nullptr;
+  }
+  // Views are cheap, racing threads each create one and all but the first throw theirs away
+  auto view = std::unique_ptr<Page>(new Page(data));
+  view->page_id_ = page_id;
+  if (slot.compare_exchange_strong(page, view.get(), std::memory_order_acq_rel)) {
+    page = view.release();
+  }
+  return page;
+}
+
+auto MmapBufferPoolManager::FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+  if (page_id < 0 || static_cast<size_t>(page_id) >= num_pages_) {
+    return nullptr;
+  }
+  auto page = GetView(page_id);
+  if (page == nullptr) {
+    return nullptr;
+  }
+  num_fetches_.Add();
+  page->pin_count_++;
+  return page;
+}
+
+auto MmapBufferPoolManager::FetchPgsImp(const std::vector<page_id_t> &page_ids, std::vector<Page *> *pages) -> bool {
+  pages->assign(page_ids.size(), nullptr);
+  bool all_fetched = true;
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    (*pages)[i] = FetchPgImp(page_ids[i], nullptr);
+    all_fetched = all_fetched && (*pages)[i] != nullptr;
+  }
+  return all_fetched;
+}
+
+auto MmapBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
+  if (page_id < 0 || static_cast<size_t>(page_id) >= num_pages_) {
+    return false;
+  }
+  auto page = views_[page_id].load(std::memory_order_acquire);
+  if (page == nullptr) {
+    return false;
+  }
+  int pin_count = page->pin_count_.load();
+  do {
+    if (pin_count <= 0) {
+      return false;
+    }
+  } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count - 1));
+  return true;
+}
+
+auto MmapBufferPoolManager::FlushPgImp(page_id_t page_id) -> bool {
+  return page_id >= 0 && static_cast<size_t>(page_id) < num_pages_;
+}
+
+auto MmapBufferPoolManager::NewPgImp(page_id_t *page_id, BufferAccessStrategy *strategy) -> Page * {
+  *page_id = INVALID_PAGE_ID;
+  return nullptr;
+}
+
+auto MmapBufferPoolManager::DeletePgImp(page_id_t page_id) -> bool {
+  return page_id < 0 || static_cast<size_t>(page_id) >= num_pages_;
+}
+
+void MmapBufferPoolManager::WarmUpPgImp(std::vector<page_id_t> page_ids) {
+  for (auto page_id : page_ids) {
+    AdviseWillNeed(page_id, 1);
+  }
+}
+
+void MmapBufferPoolManager::PrefetchPgImp(page_id_t page_id, size_t num_pages, size_t next_page_id_offset) {
+  AdviseWillNeed(page_id, num_pages);
+}
+
+void MmapBufferPoolManager::AdviseWillNeed(page_id_t page_id, size_t num_pages) {
+  if (page_id < 0 || static_cast<size_t>(page_id) >= num_pages_ || num_pages == 0) {
+    return;
+  }
+  num_pages = std::min(num_pages, num_pages_ - page_id);
+  // The kernel starts reading in the background and returns right away
+  madvise(data_ + static_cast<size_t>(page_id) * PAGE_SIZE, num_pages * PAGE_SIZE, MADV_WILLNEED);
+  num_prefetches_.Add(num_pages);
+}
+
+}  // namespace bustub
@@ -12,35 +12,102 @@
 
 #include "buffer/parallel_buffer_pool_manager.h"
 
-#include "buffer/buffer_pool_manager_instance.h"
+#include <algorithm>
+#include <utility>
 
 namespace bustub {
 
 ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
-                                                     LogManager *log_manager) {
+                                                     LogManager *log_manager, ReplacerType replacer_type,
+                                                     PageRouting routing, FrameAllocation frame_allocation)
+    : routing_(routing) {
   // Allocate and create individual BufferPoolManagerInstances
   for (size_t i = 0; i < num_instances; i++) {
-    v_.emplace_back(
-        std::make_unique<BufferPoolManagerInstance>(pool_size, num_instances, i, disk_manager, log_manager));
+    v_.emplace_back(std::make_unique<BufferPoolManagerInstance>(pool_size, num_instances, i, disk_manager,
+                                                                log_manager, replacer_type, routing,
+                                                                frame_allocation));
+    // Read-ahead along a chain of pages continues in whichever instance owns the next page
+    v_.back()->prefetch_router_ = this;
   }
 }
 
 // Update constructor to destruct all BufferPoolManagerInstances and deallocate any associated memory
-ParallelBufferPoolManager::~ParallelBufferPoolManager() = default;
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  // Instances hand read-ahead requests to each other, stop all of them before any goes away
+  for (auto &instance : v_) {
+    instance->StopPrefetcher();
+  }
+}
 
 auto ParallelBufferPoolManager::GetPoolSize() -> size_t {
   // Get size of all BufferPoolManagerInstances
   return v_[0]->GetPoolSize() * v_.size();
 }
 
+auto ParallelBufferPoolManager::GetStats() -> BufferPoolStats {
+  BufferPoolStats stats;
+  for (auto &instance : v_) {
+    stats += instance->GetStats();
+  }
+  return stats;
+}
+
+void ParallelBufferPoolManager::RunBackgroundWriter(double dirty_ratio_low, double dirty_ratio_high) {
+  for (auto &instance : v_) {
+    instance->RunBackgroundWriter(dirty_ratio_low, dirty_ratio_high);
+  }
+}
+
+void ParallelBufferPoolManager::StopBackgroundWriter() {
+  for (auto &instance : v_) {
+    instance->StopBackgroundWriter();
+  }
+}
+
 auto ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) -> BufferPoolManager * {
   // Get BufferPoolManager responsible for handling given page id. You can use this method in your other methods.
-  return v_[page_id % v_.size()].get();
+  return v_[BufferPoolManagerInstance::GetInstanceIndex(page_id, v_.size(), routing_)].get();
 }
 
-auto ParallelBufferPoolManager::FetchPgImp(page_id_t page_id) -> Page * {
+auto ParallelBufferPoolManager::GetInstanceOccupancy(size_t instance_index) -> double {
+  auto &instance = v_[instance_index];
+  return static_cast<double>(instance->GetNumResidentPages()) / instance->GetPoolSize();
+}
+
+auto ParallelBufferPoolManager::GetInstanceHitRate(size_t instance_index) -> double {
+  return v_[instance_index]->GetStats().HitRate();
+}
+
+auto ParallelBufferPoolManager::FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
   // Fetch page for page_id from responsible BufferPoolManagerInstance
-  return GetBufferPoolManager(page_id)->FetchPage(page_id);
+  return v_[BufferPoolManagerInstance::GetInstanceIndex(page_id, v_.size(), routing_)]->FetchPgImp(page_id, strategy);
+}
+
+auto ParallelBufferPoolManager::FetchPgsImp(const std::vector<page_id_t> &page_ids, std::vector<Page *> *pages)
+    -> bool {
+  // Split the batch by responsible BufferPoolManagerInstance, so that each of them handles its share in one go
+  std::vector<std::vector<size_t>> indexes(v_.size());
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    indexes[BufferPoolManagerInstance::GetInstanceIndex(page_ids[i], v_.size(), routing_)].push_back(i);
+  }
+  pages->assign(page_ids.size(), nullptr);
+  bool all_fetched = true;
+  std::vector<page_id_t> instance_page_ids;
+  std::vector<Page *> instance_pages;
+  for (size_t instance_index = 0; instance_index < v_.size(); instance_index++) {
+    if (indexes[instance_index].empty()) {
+      continue;
+    }
+    instance_page_ids.clear();
+    for (auto i : indexes[instance_index]) {
+      instance_page_ids.push_back(page_ids[i]);
+    }
+    all_fetched = v_[instance_index]->FetchPages(instance_page_ids, &instance_pages) && all_fetched;
+    for (size_t j = 0; j < instance_pages.size(); j++) {
+      (*pages)[indexes[instance_index][j]] = instance_pages[j];
+    }
+  }
+  return all_fetched;
 }
 
 auto ParallelBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
@@ -53,16 +120,17 @@ auto ParallelBufferPoolManager::FlushPgImp(page_id_t page_id) -> bool {
   return GetBufferPoolManager(page_id)->FlushPage(page_id);
 }
 
-auto ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) -> Page * {
+auto ParallelBufferPoolManager::NewPgImp(page_id_t *page_id, BufferAccessStrategy *strategy) -> Page * {
   // create new page. We will request page allocation in a round robin manner from the underlying
   // BufferPoolManagerInstances
   // 1.   From a starting index of the BPMIs, call NewPageImpl until either 1) success and return 2) looped around to
   // starting index and return nullptr
   // 2.   Bump the starting index (mod number of instances) to start search at a different BPMI each time this function
   // is called
+  // Concurrent calls each claim their own starting index
+  auto starting_index = starting_index_.fetch_add(1);
   for (size_t i = 0; i < v_.size(); i++) {
-    auto page = GetBufferPoolManager(starting_index_)->NewPage(page_id);
-    starting_index_ = (starting_index_ + 1) % v_.size();
+    auto page = v_[(starting_index + i) % v_.size()]->NewPgImp(page_id, strategy);
     if (page != nullptr) {
       return page;
     }
@@ -75,6 +143,40 @@ auto ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) -> bool {
   return GetBufferPoolManager(page_id)->DeletePage(page_id);
 }
 
+void ParallelBufferPoolManager::PrefetchPgImp(page_id_t page_id, size_t num_pages, size_t next_page_id_offset) {
+  // Read ahead through the responsible BufferPoolManagerInstance
+  if (page_id != INVALID_PAGE_ID) {
+    GetBufferPoolManager(page_id)->PrefetchRange(page_id, num_pages, next_page_id_offset);
+  }
+}
+
+void ParallelBufferPoolManager::GetResidentPgsImp(std::vector<page_id_t> *page_ids) {
+  // The instances do not share a clock, so take their pages rank by rank: the most recent page of each instance first
+  std::vector<std::vector<page_id_t>> instance_page_ids(v_.size());
+  size_t max_size = 0;
+  for (size_t i = 0; i < v_.size(); i++) {
+    v_[i]->GetResidentPgsImp(&instance_page_ids[i]);
+    max_size = std::max(max_size, instance_page_ids[i].size());
+  }
+  for (size_t rank = 0; rank < max_size; rank++) {
+    for (auto &ids : instance_page_ids) {
+      if (rank < ids.size()) {
+        page_ids->push_back(ids[rank]);
+      }
+    }
+  }
+}
+
+void ParallelBufferPoolManager::WarmUpPgImp(std::vector<page_id_t> page_ids) {
+  std::vector<std::vector<page_id_t>> instance_page_ids(v_.size());
+  for (auto page_id : page_ids) {
+    instance_page_ids[BufferPoolManagerInstance::GetInstanceIndex(page_id, v_.size(), routing_)].push_back(page_id);
+  }
+  for (size_t i = 0; i < v_.size(); i++) {
+    v_[i]->WarmUpPgImp(std::move(instance_page_ids[i]));
+  }
+}
+
 void ParallelBufferPoolManager::FlushAllPgsImp() {
   // flush all pages from all BufferPoolManagerInstances
   for (auto &instance : v_) {
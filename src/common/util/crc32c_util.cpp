@@ -0,0 +1,171 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c_util.cpp
+//
+// Identification: src/common/util/crc32c_util.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+
+#include "common/util/crc32c_util.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define BUSTUB_HAS_SSE42_CRC32
+#endif
+
+namespace bustub {
+
+namespace {
+
+/** The CRC32C polynomial, bit-reversed */
+constexpr uint32_t CRC32C_POLY = 0x82F63B78;
+
+/**
+ * Slicing-by-8 tables: tables_[0] is the classic byte-at-a-time table, tables_[k] advances the crc of a byte by k
+ * more zero bytes, so that eight bytes are folded in with eight independent lookups.
+ */
+struct Crc32cTables {
+  Crc32cTables() {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t crc = i;
+      for (int bit = 0; bit < 8; bit++) {
+        crc = (crc >> 1) ^ ((crc & 1) != 0 ? CRC32C_POLY : 0);
+      }
+      tables_[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+      for (int k = 1; k < 8; k++) {
+        tables_[k][i] = (tables_[k - 1][i] >> 8) ^ tables_[0][tables_[k - 1][i] & 0xFF];
+      }
+    }
+  }
+  uint32_t tables_[8][256];
+};
+
+auto GetTables() -> const Crc32cTables & {
+  static const Crc32cTables TABLES;
+  return TABLES;
+}
+
+auto ChecksumSoftware(uint32_t crc, const char *data, size_t length) -> uint32_t {
+  const auto &t = GetTables().tables_;
+  auto bytes = reinterpret_cast<const uint8_t *>(data);
+  while (length >= 8) {
+    uint32_t low;
+    uint32_t high;
+    memcpy(&low, bytes, 4);
+    memcpy(&high, bytes + 4, 4);
+    // Little endian: the first byte of the word is the lowest one
+    low ^= crc;
+    crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+          t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+    bytes += 8;
+    length -= 8;
+  }
+  while (length-- > 0) {
+    crc = (crc >> 8) ^ t[0][(crc ^ *bytes++) & 0xFF];
+  }
+  return crc;
+}
+
+#ifdef BUSTUB_HAS_SSE42_CRC32
+
+/** Length of each of the three stripes the hardware checksums in parallel */
+constexpr size_t STRIPE_SIZE = 256;
+
+/**
+ * The crc32 instruction has a latency of three cycles but a throughput of one per cycle, so three independent stripes
+ * are checksummed at once. shift_[k][n] advances the crc byte n << 8k over STRIPE_SIZE zero bytes, which is how the
+ * crc of one stripe is carried into the next.
+ */
+struct Crc32cShiftTable {
+  Crc32cShiftTable() {
+    const auto &t = GetTables().tables_;
+    for (int k = 0; k < 4; k++) {
+      for (uint32_t n = 0; n < 256; n++) {
+        uint32_t crc = n << (8 * k);
+        for (size_t i = 0; i < STRIPE_SIZE; i++) {
+          crc = (crc >> 8) ^ t[0][crc & 0xFF];
+        }
+        shift_[k][n] = crc;
+      }
+    }
+  }
+  auto Shift(uint32_t crc) const -> uint32_t {
+    return shift_[0][crc & 0xFF] ^ shift_[1][(crc >> 8) & 0xFF] ^ shift_[2][(crc >> 16) & 0xFF] ^ shift_[3][crc >> 24];
+  }
+  uint32_t shift_[4][256];
+};
+
+/** Compiled for SSE4.2 regardless of the target of the build, only called once the CPU is known to support it */
+__attribute__((target("sse4.2"))) auto ChecksumHardware(uint32_t crc, const char *data, size_t length) -> uint32_t {
+  static const Crc32cShiftTable SHIFT;
+  uint64_t crc0 = crc;
+  while (length >= 3 * STRIPE_SIZE) {
+    uint64_t crc1 = 0;
+    uint64_t crc2 = 0;
+    for (const char *end = data + STRIPE_SIZE; data < end; data += 8) {
+      uint64_t words[3];
+      memcpy(&words[0], data, 8);
+      memcpy(&words[1], data + STRIPE_SIZE, 8);
+      memcpy(&words[2], data + 2 * STRIPE_SIZE, 8);
+      crc0 = _mm_crc32_u64(crc0, words[0]);
+      crc1 = _mm_crc32_u64(crc1, words[1]);
+      crc2 = _mm_crc32_u64(crc2, words[2]);
+    }
+    crc0 = SHIFT.Shift(static_cast<uint32_t>(crc0)) ^ crc1;
+    crc0 = SHIFT.Shift(static_cast<uint32_t>(crc0)) ^ crc2;
+    data += 2 * STRIPE_SIZE;
+    length -= 3 * STRIPE_SIZE;
+  }
+  while (length >= 8) {
+    uint64_t word;
+    memcpy(&word, data, 8);
+    crc0 = _mm_crc32_u64(crc0, word);
+    data += 8;
+    length -= 8;
+  }
+  crc = static_cast<uint32_t>(crc0);
+  while (length-- > 0) {
+    crc = _mm_crc32_u8(crc, static_cast<uint8_t>(*data++));
+  }
+  return crc;
+}
+
+auto HasSse42() -> bool {
+  // The checks may run before the constructors of libgcc, __builtin_cpu_init makes them safe to call at any time
+  static const bool HAS_SSE42 = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2") != 0;
+  }();
+  return HAS_SSE42;
+}
+
+#endif
+
+}  // namespace
+
+auto Crc32cUtil::Checksum(const char *data, size_t length) -> uint32_t {
+#ifdef BUSTUB_HAS_SSE42_CRC32
+  if (HasSse42()) {
+    return ~ChecksumHardware(~0U, data, length);
+  }
+#endif
+  return ~ChecksumSoftware(~0U, data, length);
+}
+
+auto Crc32cUtil::IsHardwareAccelerated() -> bool {
+#ifdef BUSTUB_HAS_SSE42_CRC32
+  return HasSse42();
+#else
+  return false;
+#endif
+}
+
+}  // namespace bustub
@@ -0,0 +1,201 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz4_util.cpp
+//
+// Identification: src/common/util/lz4_util.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "common/util/lz4_util.h"
+
+namespace bustub {
+
+namespace {
+
+/** A match is at least this long, shorter ones do not pay for their token */
+constexpr size_t MIN_MATCH = 4;
+/** The format requires the last bytes of a block to be literals, and the last match to start before these */
+constexpr size_t LAST_LITERALS = 5;
+constexpr size_t MATCH_FIND_LIMIT = 12;
+/** Match candidates are found through a hash table of the 4-byte sequences seen so far */
+constexpr int HASH_BITS = 12;
+
+auto Read32(const uint8_t *p) -> uint32_t {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+auto Hash(uint32_t sequence) -> uint32_t { return (sequence * 2654435761U) >> (32 - HASH_BITS); }
+
+/** Writes the sequences of a block, failing once the output buffer is full */
+class Writer {
+ public:
+  Writer(char *dst, size_t capacity)
+      : op_(reinterpret_cast<uint8_t *>(dst)), begin_(op_), end_(reinterpret_cast<uint8_t *>(dst) + capacity) {}
+
+  /** Emit a sequence: literals followed by a match, or only literals if it is the last one */
+  auto Sequence(const uint8_t *literals, size_t num_literals, size_t offset, size_t match_length) -> bool {
+    auto token = op_;
+    if (!Put(0)) {
+      return false;
+    }
+    *token = static_cast<uint8_t>(std::min<size_t>(num_literals, 15) << 4);
+    if (num_literals >= 15 && !PutLength(num_literals - 15)) {
+      return false;
+    }
+    if (static_cast<size_t>(end_ - op_) < num_literals) {
+      return false;
+    }
+    memcpy(op_, literals, num_literals);
+    op_ += num_literals;
+    if (match_length == 0) {
+      return true;
+    }
+    if (!Put(static_cast<uint8_t>(offset & 0xFF)) || !Put(static_cast<uint8_t>(offset >> 8))) {
+      return false;
+    }
+    match_length -= MIN_MATCH;
+    *token |= static_cast<uint8_t>(std::min<size_t>(match_length, 15));
+    return match_length < 15 || PutLength(match_length - 15);
+  }
+
+  auto Size() const -> size_t { return op_ - begin_; }
+
+ private:
+  auto Put(uint8_t byte) -> bool {
+    if (op_ == end_) {
+      return false;
+    }
+    *op_++ = byte;
+    return true;
+  }
+
+  /** Lengths past the 4 bits of the token continue in bytes of 255, ended by a byte below 255 */
+  auto PutLength(size_t length) -> bool {
+    for (; length >= 255; length -= 255) {
+      if (!Put(255)) {
+        return false;
+      }
+    }
+    return Put(static_cast<uint8_t>(length));
+  }
+
+  uint8_t *op_;
+  uint8_t *begin_;
+  uint8_t *end_;
+};
+
+}  // namespace
+
+auto Lz4Util::Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity) -> size_t {
+  if (src_size > MAX_INPUT_SIZE) {
+    return 0;
+  }
+  auto in = reinterpret_cast<const uint8_t *>(src);
+  Writer writer(dst, dst_capacity);
+  size_t anchor = 0;
+  if (src_size > MATCH_FIND_LIMIT) {
+    // Positions are below 64 KB, the table stores them off by one so that 0 means empty
+    uint16_t table[1 << HASH_BITS] = {0};
+    size_t match_limit = src_size - LAST_LITERALS;
+    for (size_t ip = 0; ip < src_size - MATCH_FIND_LIMIT;) {
+      auto sequence = Read32(in + ip);
+      auto &slot = table[Hash(sequence)];
+      size_t ref = slot;
+      slot = static_cast<uint16_t>(ip + 1);
+      if (ref == 0 || Read32(in + ref - 1) != sequence) {
+        ip++;
+        continue;
+      }
+      ref--;
+      size_t length = MIN_MATCH;
+      while (ip + length < match_limit && in[ref + length] == in[ip + length]) {
+        length++;
+      }
+      if (!writer.Sequence(in + anchor, ip - anchor, ip - ref, length)) {
+        return 0;
+      }
+      ip += length;
+      anchor = ip;
+    }
+  }
+  if (!writer.Sequence(in + anchor, src_size - anchor, 0, 0)) {
+    return 0;
+  }
+  return writer.Size();
+}
+
+auto Lz4Util::Decompress(const char *src, size_t src_size, char *dst, size_t dst_capacity) -> int {
+  auto ip = reinterpret_cast<const uint8_t *>(src);
+  auto ip_end = ip + src_size;
+  auto op = reinterpret_cast<uint8_t *>(dst);
+  auto op_begin = op;
+  auto op_end = op + dst_capacity;
+  auto read_length = [&](size_t *length) {
+    uint8_t byte;
+    do {
+      if (ip == ip_end) {
+        return false;
+      }
+      byte = *ip++;
+      *length += byte;
+    } while (byte == 255);
+    return true;
+  };
+
+  while (ip < ip_end) {
+    uint8_t token = *ip++;
+    size_t num_literals = token >> 4;
+    if (num_literals == 15 && !read_length(&num_literals)) {
+      return -1;
+    }
+    if (static_cast<size_t>(ip_end - ip) < num_literals || static_cast<size_t>(op_end - op) < num_literals) {
+      return -1;
+    }
+    memcpy(op, ip, num_literals);
+    ip += num_literals;
+    op += num_literals;
+    // The last sequence has no match
+    if (ip == ip_end) {
+      break;
+    }
+    if (ip_end - ip < 2) {
+      return -1;
+    }
+    size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+    ip += 2;
+    size_t match_length = token & 0x0F;
+    if (match_length == 15 && !read_length(&match_length)) {
+      return -1;
+    }
+    match_length += MIN_MATCH;
+    if (offset == 0 || offset > static_cast<size_t>(op - op_begin) || static_cast<size_t>(op_end - op) < match_length) {
+      return -1;
+    }
+    const uint8_t *match = op - offset;
+    if (offset == 1) {
+      // A run of a single byte, e.g. the zero padding of a page
+      memset(op, *match, match_length);
+    } else if (offset >= match_length) {
+      memcpy(op, match, match_length);
+    } else {
+      // The match overlaps the bytes it produces, which repeat its first offset bytes
+      for (size_t i = 0; i < match_length; i++) {
+        op[i] = match[i];
+      }
+    }
+    op += match_length;
+  }
+  return static_cast<int>(op - op_begin);
+}
+
+}  // namespace bustub
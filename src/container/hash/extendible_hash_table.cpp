@@ -28,17 +28,15 @@ HASH_TABLE_TYPE::ExtendibleHashTable(const std::string &name, BufferPoolManager
     : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
   //  implement me!
   table_latch_.WLock();
-  auto dir_page = reinterpret_cast<HashTableDirectoryPage *>(buffer_pool_manager_->NewPage(&directory_page_id_));
-  page_id_t bucket_page_id;
-  auto page = buffer_pool_manager_->NewPage(&bucket_page_id);
-  page->WLatch();
-
-  dir_page->SetLocalDepth(0, 0);
-  dir_page->SetBucketPageId(0, bucket_page_id);
-
-  assert(buffer_pool_manager_->UnpinPage(bucket_page_id, true));
-  page->WUnlatch();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, true));
+  {
+    auto dir_guard = buffer_pool_manager_->NewPageGuarded(&directory_page_id_);
+    page_id_t bucket_page_id;
+    auto bucket_guard = buffer_pool_manager_->NewPageGuarded(&bucket_page_id);
+
+    auto dir_page = dir_guard.AsMut<HashTableDirectoryPage>();
+    dir_page->SetLocalDepth(0, 0);
+    dir_page->SetBucketPageId(0, bucket_page_id);
+  }
   table_latch_.WUnlock();
 }
 
@@ -69,13 +67,13 @@ inline auto HASH_TABLE_TYPE::KeyToPageId(KeyType key, HashTableDirectoryPage *di
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_TYPE::FetchDirectoryPage() -> HashTableDirectoryPage * {
-  return reinterpret_cast<HashTableDirectoryPage *>(buffer_pool_manager_->FetchPage(directory_page_id_));
+auto HASH_TABLE_TYPE::FetchDirectoryPage() -> BasicPageGuard {
+  return buffer_pool_manager_->FetchPageBasic(directory_page_id_);
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BUCKET_TYPE * {
-  return reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(buffer_pool_manager_->FetchPage(bucket_page_id));
+auto HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) -> BasicPageGuard {
+  return buffer_pool_manager_->FetchPageBasic(bucket_page_id);
 }
 
 /*****************************************************************************
@@ -84,17 +82,13 @@ auto HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BU
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool {
   table_latch_.RLock();
-  auto dir_page = FetchDirectoryPage();
-  auto bucket_page_id = KeyToPageId(key, dir_page);
-  auto bucket_page = FetchBucketPage(bucket_page_id);
-  auto page = reinterpret_cast<Page *>(bucket_page);
-  page->RLatch();
-
-  auto success = bucket_page->GetValue(key, comparator_, result);
-
-  assert(buffer_pool_manager_->UnpinPage(bucket_page_id, false));
-  page->RUnlatch();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false));
+  bool success;
+  {
+    BasicPageGuard dir_guard = FetchDirectoryPage();
+    auto dir_page = dir_guard.As<HashTableDirectoryPage>();
+    ReadPageGuard bucket_guard = FetchBucketPage(KeyToPageId(key, dir_page)).UpgradeRead();
+    success = bucket_guard.As<HASH_TABLE_BUCKET_TYPE>()->GetValue(key, comparator_, result);
+  }
   table_latch_.RUnlock();
   return success;
 }
@@ -105,18 +99,20 @@ auto HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
   table_latch_.RLock();
-  auto dir_page = FetchDirectoryPage();
-  auto bucket_page_id = KeyToPageId(key, dir_page);
-  auto bucket_page = FetchBucketPage(bucket_page_id);
-  auto page = reinterpret_cast<Page *>(bucket_page);
-  page->WLatch();
-
-  auto success = bucket_page->Insert(key, value, comparator_);
-  auto need_split = !success && bucket_page->IsFull();
-
-  assert(buffer_pool_manager_->UnpinPage(bucket_page_id, success));
-  page->WUnlatch();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false));
+  bool success;
+  bool need_split;
+  {
+    BasicPageGuard dir_guard = FetchDirectoryPage();
+    auto dir_page = dir_guard.As<HashTableDirectoryPage>();
+    WritePageGuard bucket_guard = FetchBucketPage(KeyToPageId(key, dir_page)).UpgradeWrite();
+    auto bucket_page = bucket_guard.As<HASH_TABLE_BUCKET_TYPE>();
+
+    success = bucket_page->Insert(key, value, comparator_);
+    need_split = !success && bucket_page->IsFull();
+    if (success) {
+      bucket_guard.SetDirty();
+    }
+  }
   table_latch_.RUnlock();
 
   if (need_split) {
@@ -128,57 +124,45 @@ auto HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
   table_latch_.WLock();
-  auto dir_page = FetchDirectoryPage();
-  auto bucket_idx = KeyToDirectoryIndex(key, dir_page);
-  auto bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
-  auto bucket_page = FetchBucketPage(bucket_page_id);
-  auto page = reinterpret_cast<Page *>(bucket_page);
-  page->WLatch();
-
-  if (bucket_page->IsFull()) {
-    // 获取原桶的所有值
-    auto vals = bucket_page->StealKVs();
-    // 按需将表项扩展一倍
-    if (dir_page->GetLocalDepth(bucket_idx) == dir_page->GetGlobalDepth()) {
-      dir_page->IncrGlobalDepth();
-      bucket_idx = KeyToDirectoryIndex(key, dir_page);
-    }
-    // 创建新桶
-    page_id_t new_bucket_page_id;
-    auto new_page = buffer_pool_manager_->NewPage(&new_bucket_page_id);
-    // 把一半指向原桶的表项指向新桶
-    auto common_bits = bucket_idx & dir_page->GetLocalDepthMask(bucket_idx);
-    auto dir_size = dir_page->Size();
-    auto higher_bit = 1 << dir_page->GetLocalDepth(bucket_idx);
-    for (auto i = common_bits; i < dir_size; i += higher_bit) {
-      if ((i & higher_bit) != (bucket_idx & higher_bit)) {  // split out
-        dir_page->SetBucketPageId(i, new_bucket_page_id);
+  {
+    BasicPageGuard dir_guard = FetchDirectoryPage();
+    auto dir_page = dir_guard.AsMut<HashTableDirectoryPage>();
+    auto bucket_idx = KeyToDirectoryIndex(key, dir_page);
+    WritePageGuard bucket_guard = FetchBucketPage(dir_page->GetBucketPageId(bucket_idx)).UpgradeWrite();
+    auto bucket_page = bucket_guard.AsMut<HASH_TABLE_BUCKET_TYPE>();
+
+    if (bucket_page->IsFull()) {
+      // 获取原桶的所有值
+      auto vals = bucket_page->StealKVs();
+      // 按需将表项扩展一倍
+      if (dir_page->GetLocalDepth(bucket_idx) == dir_page->GetGlobalDepth()) {
+        dir_page->IncrGlobalDepth();
+        bucket_idx = KeyToDirectoryIndex(key, dir_page);
       }
-      dir_page->IncrLocalDepth(i);
-    }
-    // 迁移旧桶值
-    auto new_local_depth_mask = dir_page->GetLocalDepthMask(bucket_idx);
-    auto new_bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(new_page);
-    HASH_TABLE_BUCKET_TYPE *b = nullptr;
-    new_page->WLatch();
-
-    for (const auto &e : vals) {
-      auto idx = Hash(e.first) & new_local_depth_mask;
-      if (idx == bucket_idx) {
-        b = bucket_page;
-      } else {
-        b = new_bucket_page;
+      // 创建新桶
+      page_id_t new_bucket_page_id;
+      auto new_bucket_guard = buffer_pool_manager_->NewPageGuarded(&new_bucket_page_id).UpgradeWrite();
+      // 把一半指向原桶的表项指向新桶
+      auto common_bits = bucket_idx & dir_page->GetLocalDepthMask(bucket_idx);
+      auto dir_size = dir_page->Size();
+      auto higher_bit = 1 << dir_page->GetLocalDepth(bucket_idx);
+      for (auto i = common_bits; i < dir_size; i += higher_bit) {
+        if ((i & higher_bit) != (bucket_idx & higher_bit)) {  // split out
+          dir_page->SetBucketPageId(i, new_bucket_page_id);
+        }
+        dir_page->IncrLocalDepth(i);
+      }
+      // 迁移旧桶值
+      auto new_local_depth_mask = dir_page->GetLocalDepthMask(bucket_idx);
+      auto new_bucket_page = new_bucket_guard.AsMut<HASH_TABLE_BUCKET_TYPE>();
+      for (const auto &e : vals) {
+        auto idx = Hash(e.first) & new_local_depth_mask;
+        auto b = idx == bucket_idx ? bucket_page : new_bucket_page;
+        [[maybe_unused]] auto inserted = b->Insert(e.first, e.second, comparator_);
+        assert(inserted);
       }
-      assert(b->Insert(e.first, e.second, comparator_));
     }
-
-    assert(buffer_pool_manager_->UnpinPage(new_bucket_page_id, true));
-    new_page->WUnlatch();
   }
-
-  assert(buffer_pool_manager_->UnpinPage(bucket_page_id, true));
-  page->WUnlatch();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, true));
   table_latch_.WUnlock();
 
   return Insert(transaction, key, value);
@@ -190,19 +174,21 @@ auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
   table_latch_.RLock();
-  auto dir_page = FetchDirectoryPage();
-  auto bucket_idx = KeyToDirectoryIndex(key, dir_page);
-  auto bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
-  auto bucket_page = FetchBucketPage(bucket_page_id);
-  auto page = reinterpret_cast<Page *>(bucket_page);
-  page->WLatch();
-
-  auto success = bucket_page->Remove(key, value, comparator_);
-  auto need_merge = NeedMerge(bucket_idx, bucket_page, dir_page);
+  bool success;
+  bool need_merge;
+  {
+    BasicPageGuard dir_guard = FetchDirectoryPage();
+    auto dir_page = dir_guard.As<HashTableDirectoryPage>();
+    auto bucket_idx = KeyToDirectoryIndex(key, dir_page);
+    WritePageGuard bucket_guard = FetchBucketPage(dir_page->GetBucketPageId(bucket_idx)).UpgradeWrite();
+    auto bucket_page = bucket_guard.As<HASH_TABLE_BUCKET_TYPE>();
 
-  assert(buffer_pool_manager_->UnpinPage(bucket_page_id, success));
-  page->WUnlatch();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false));
+    success = bucket_page->Remove(key, value, comparator_);
+    need_merge = NeedMerge(bucket_idx, bucket_page, dir_page);
+    if (success) {
+      bucket_guard.SetDirty();
+    }
+  }
   table_latch_.RUnlock();
 
   if (need_merge) {
@@ -230,40 +216,41 @@ bool HASH_TABLE_TYPE::NeedMerge(uint32_t bucket_idx, HASH_TABLE_BUCKET_TYPE *buc
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {
   table_latch_.WLock();
-  auto dir_page = FetchDirectoryPage();
-
-  while (true) {
-    auto bucket_idx = KeyToDirectoryIndex(key, dir_page);
-    auto bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
-    auto bucket_page = FetchBucketPage(bucket_page_id);
-    auto page = reinterpret_cast<Page *>(bucket_page);
-
-    page->RLatch();
-    auto need_merge = NeedMerge(bucket_idx, bucket_page, dir_page);
-    assert(buffer_pool_manager_->UnpinPage(bucket_page_id, false));
-    page->RUnlatch();
-    if (!need_merge) {
-      break;
-    }
+  {
+    BasicPageGuard dir_guard = FetchDirectoryPage();
+    auto dir_page = dir_guard.AsMut<HashTableDirectoryPage>();
+
+    while (true) {
+      auto bucket_idx = KeyToDirectoryIndex(key, dir_page);
+      bool need_merge;
+      {
+        ReadPageGuard bucket_guard = FetchBucketPage(dir_page->GetBucketPageId(bucket_idx)).UpgradeRead();
+        need_merge = NeedMerge(bucket_idx, bucket_guard.As<HASH_TABLE_BUCKET_TYPE>(), dir_page);
+      }
+      if (!need_merge) {
+        break;
+      }
 
-    auto split_image_idx = dir_page->GetSplitImageIndex(bucket_idx);
-    auto split_image_page_id = dir_page->GetBucketPageId(split_image_idx);
-    // 所有指向原bucket和split_image表项，指向split_image、local_depth--；
-    auto local_depth_mask = dir_page->GetLocalDepthMask(bucket_idx);
-    uint32_t idx_start = bucket_idx & local_depth_mask & split_image_idx;
-    uint32_t idx_size = dir_page->Size();
-    uint32_t idx_diff = dir_page->GetLocalHighBit(bucket_idx);
-    for (auto i = idx_start; i < idx_size; i += idx_diff) {
-      dir_page->SetBucketPageId(i, split_image_page_id);
-      dir_page->DecrLocalDepth(i);
-    }
+      auto bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
+      auto split_image_idx = dir_page->GetSplitImageIndex(bucket_idx);
+      auto split_image_page_id = dir_page->GetBucketPageId(split_image_idx);
+      // 所有指向原bucket和split_image表项，指向split_image、local_depth--；
+      auto local_depth_mask = dir_page->GetLocalDepthMask(bucket_idx);
+      uint32_t idx_start = bucket_idx & local_depth_mask & split_image_idx;
+      uint32_t idx_size = dir_page->Size();
+      uint32_t idx_diff = dir_page->GetLocalHighBit(bucket_idx);
+      for (auto i = idx_start; i < idx_size; i += idx_diff) {
+        dir_page->SetBucketPageId(i, split_image_page_id);
+        dir_page->DecrLocalDepth(i);
+      }
 
-    if (dir_page->CanShrink()) {
-      dir_page->DecrGlobalDepth();
+      if (dir_page->CanShrink()) {
+        dir_page->DecrGlobalDepth();
+      }
+      // Nothing points to the empty bucket anymore, give its page back
+      buffer_pool_manager_->DeletePage(bucket_page_id);
     }
   }
-
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, true));
   table_latch_.WUnlock();
 }
 
@@ -273,9 +260,9 @@ void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::GetGlobalDepth() -> uint32_t {
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  uint32_t global_depth = dir_page->GetGlobalDepth();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+  BasicPageGuard dir_guard = FetchDirectoryPage();
+  uint32_t global_depth = dir_guard.As<HashTableDirectoryPage>()->GetGlobalDepth();
+  dir_guard.Drop();
   table_latch_.RUnlock();
   return global_depth;
 }
@@ -286,9 +273,9 @@ auto HASH_TABLE_TYPE::GetGlobalDepth() -> uint32_t {
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::VerifyIntegrity() {
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  dir_page->VerifyIntegrity();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+  BasicPageGuard dir_guard = FetchDirectoryPage();
+  dir_guard.As<HashTableDirectoryPage>()->VerifyIntegrity();
+  dir_guard.Drop();
   table_latch_.RUnlock();
 }
 
@@ -9,14 +9,55 @@
 // Copyright (c) 2015-19, Carnegie Mellon University Database Group
 //
 //===----------------------------------------------------------------------===//
+#include <optional>
+
 #include "execution/executors/index_scan_executor.h"
 
 namespace bustub {
 IndexScanExecutor::IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanPlanNode *plan)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx), plan_(plan) {}
+
+void IndexScanExecutor::Init() {
+  auto *catalog = exec_ctx_->GetCatalog();
+  index_info_ = catalog->GetIndex(plan_->GetIndexOid());
+  table_info_ = catalog->GetTable(index_info_->table_name_);
 
-void IndexScanExecutor::Init() {}
+  // The bounds are given as the values of the key columns, the index reads keys laid out by its key schema
+  auto *key_schema = index_info_->index_->GetKeySchema();
+  std::optional<Tuple> low;
+  std::optional<Tuple> high;
+  if (!plan_->GetLowKey().empty()) {
+    low.emplace(plan_->GetLowKey(), key_schema);
+  }
+  if (!plan_->GetHighKey().empty()) {
+    high.emplace(plan_->GetHighKey(), key_schema);
+  }
+  rids_.clear();
+  next_rid_ = 0;
+  index_info_->index_->ScanRange(low ? &*low : nullptr, plan_->IsLowInclusive(), high ? &*high : nullptr,
+                                 plan_->IsHighInclusive(), plan_->GetDirection(), &rids_,
+                                 exec_ctx_->GetTransaction());
+}
 
-auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool { return false; }
+auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  while (next_rid_ < rids_.size()) {
+    Tuple tup;
+    if (!table_info_->table_->GetTuple(rids_[next_rid_++], &tup, exec_ctx_->GetTransaction())) {
+      continue;
+    }
+    auto predicate = plan_->GetPredicate();
+    if (predicate != nullptr && !predicate->Evaluate(&tup, &table_info_->schema_).GetAs<bool>()) {
+      continue;
+    }
+    std::vector<Value> vals;
+    for (auto &col : GetOutputSchema()->GetColumns()) {
+      vals.emplace_back(col.GetExpr()->Evaluate(&tup, &table_info_->schema_));
+    }
+    *tuple = Tuple(vals, GetOutputSchema());
+    *rid = tup.GetRid();
+    return true;
+  }
+  return false;
+}
 
 }  // namespace bustub
@@ -45,7 +45,7 @@ auto InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
   }
   // 插入数据库
   auto txn = exec_ctx_->GetTransaction();
-  if (!table_info_->table_->InsertTuple(tup, rid, txn)) {
+  if (!table_info_->table_->InsertTuple(tup, rid, txn, &strategy_)) {
     return false;
   }
   // 更新索引
@@ -19,7 +19,7 @@ SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNod
 
 void SeqScanExecutor::Init() {
   table_info_ = exec_ctx_->GetCatalog()->GetTable(plan_->GetTableOid());
-  table_iter_ = std::make_unique<TableIterator>(table_info_->table_->Begin(exec_ctx_->GetTransaction()));
+  table_iter_ = std::make_unique<TableIterator>(table_info_->table_->Begin(exec_ctx_->GetTransaction(), &strategy_));
 }
 
 auto SeqScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
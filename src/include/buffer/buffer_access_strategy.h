@@ -0,0 +1,63 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.h
+//
+// Identification: src/include/buffer/buffer_access_strategy.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * BufferAccessStrategy is a hint passed to FetchPage/NewPage by bulk operations such as sequential scans, index
+ * backfills and bulk inserts. Pages read in through a strategy are remembered in a small ring, and once the ring is
+ * full the scan recycles the frame of the page it read ring_size pages ago instead of asking the replacer for a
+ * victim. The scan thereby keeps to a bounded set of frames and does not flush the rest of the buffer pool.
+ *
+ * Each buffer pool manager instance gets its own ring, as frames cannot move between instances. A strategy belongs
+ * to a single scan and is not thread safe.
+ */
+class BufferAccessStrategy {
+ public:
+  /**
+   * Create a new BufferAccessStrategy.
+   * @param ring_size the number of frames the bulk operation may occupy in each buffer pool manager instance
+   */
+  explicit BufferAccessStrategy(size_t ring_size = BUFFER_RING_SIZE);
+
+  /**
+   * @param instance_index index of the buffer pool manager instance which needs a frame
+   * @return the page whose frame should be recycled next, INVALID_PAGE_ID while the ring is not full yet
+   */
+  auto GetRecycleCandidate(uint32_t instance_index) -> page_id_t;
+
+  /**
+   * Remember that a page was read into a frame on behalf of the strategy, replacing the current recycle candidate.
+   * @param instance_index index of the buffer pool manager instance holding the page
+   * @param page_id id of the page
+   */
+  void AddToRing(uint32_t instance_index, page_id_t page_id);
+
+ private:
+  struct Ring {
+    std::vector<page_id_t> page_ids_;
+    size_t current_{0};
+  };
+
+  auto GetRing(uint32_t instance_index) -> Ring &;
+
+  size_t ring_size_;
+  std::vector<Ring> rings_;
+};
+
+}  // namespace bustub
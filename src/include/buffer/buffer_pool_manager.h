@@ -14,12 +14,17 @@
 
 #include <list>
 #include <mutex>  // NOLINT
+#include <string>
 #include <unordered_map>
+#include <vector>
 
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_stats.h"
 #include "buffer/lru_replacer.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
@@ -53,6 +58,74 @@ class BufferPoolManager {
     return result;
   }
 
+  /**
+   * Fetch a page and wrap it into a guard which unpins it when it goes out of scope.
+   * @param page_id id of page to be fetched
+   * @param strategy if not nullptr, a miss recycles a frame from the ring of this bulk access strategy
+   * @return a guard holding the pinned page, an empty guard if the page could not be fetched
+   */
+  auto FetchPageBasic(page_id_t page_id, BufferAccessStrategy *strategy = nullptr) -> BasicPageGuard {
+    return {this, FetchPgImp(page_id, strategy)};
+  }
+
+  /**
+   * Fetch a page and take its read latch. The guard releases the latch and unpins the page when it goes out of scope.
+   * @param page_id id of page to be fetched
+   * @param strategy if not nullptr, a miss recycles a frame from the ring of this bulk access strategy
+   * @return a guard holding the pinned and read latched page, an empty guard if the page could not be fetched
+   */
+  auto FetchPageRead(page_id_t page_id, BufferAccessStrategy *strategy = nullptr) -> ReadPageGuard {
+    return FetchPageBasic(page_id, strategy).UpgradeRead();
+  }
+
+  /**
+   * Fetch a page and take its write latch. The guard releases the latch and unpins the page when it goes out of scope.
+   * @param page_id id of page to be fetched
+   * @param strategy if not nullptr, a miss recycles a frame from the ring of this bulk access strategy
+   * @return a guard holding the pinned and write latched page, an empty guard if the page could not be fetched
+   */
+  auto FetchPageWrite(page_id_t page_id, BufferAccessStrategy *strategy = nullptr) -> WritePageGuard {
+    return FetchPageBasic(page_id, strategy).UpgradeWrite();
+  }
+
+  /**
+   * Create a new page and wrap it into a guard which unpins it when it goes out of scope. The new page is unpinned as
+   * dirty, so that it reaches the disk even if it is left zeroed.
+   * @param[out] page_id id of created page
+   * @param strategy if not nullptr, the new page recycles a frame from the ring of this bulk access strategy
+   * @return a guard holding the pinned new page, an empty guard if no new pages could be created
+   */
+  auto NewPageGuarded(page_id_t *page_id, BufferAccessStrategy *strategy = nullptr) -> BasicPageGuard {
+    BasicPageGuard guard(this, NewPgImp(page_id, strategy));
+    guard.SetDirty();
+    return guard;
+  }
+
+  /**
+   * Fetch a batch of pages. Hits only pin their pages, misses get their frames under a single acquisition of the
+   * buffer pool latch and runs of consecutive pages are read with a single disk request.
+   * @param page_ids ids of the pages to be fetched, duplicates are pinned once per occurrence
+   * @param[out] pages the requested pages, in the order of page_ids, nullptr for those which could not be fetched
+   * @return true if all the pages were fetched. The pages which were fetched are pinned either way.
+   */
+  auto FetchPages(const std::vector<page_id_t> &page_ids, std::vector<Page *> *pages) -> bool {
+    return FetchPgsImp(page_ids, pages);
+  }
+
+  /**
+   * Unpin a batch of pages.
+   * @param page_ids ids of the pages to be unpinned, duplicates are unpinned once per occurrence
+   * @param is_dirty true if the pages should be marked as dirty, false otherwise
+   * @return true if all the pages were pinned before this call
+   */
+  auto UnpinPages(const std::vector<page_id_t> &page_ids, bool is_dirty) -> bool {
+    bool all_unpinned = true;
+    for (auto page_id : page_ids) {
+      all_unpinned = UnpinPgImp(page_id, is_dirty) && all_unpinned;
+    }
+    return all_unpinned;
+  }
+
   /** Grading function. Do not modify! */
   auto FlushPage(page_id_t page_id, bufferpool_callback_fn callback = nullptr) -> bool {
     GradingCallback(callback, CallbackType::BEFORE, page_id);
@@ -84,9 +157,46 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Hint that a page is going to be fetched soon. The page is read into the buffer pool in the background, this
+   * call never waits for I/O.
+   * @param page_id id of the page to read ahead
+   */
+  void PrefetchPage(page_id_t page_id) { PrefetchPgImp(page_id, 1, 0); }
+
+  /**
+   * Hint that a chain of pages is going to be fetched soon, such as the following pages of a table heap. The pages
+   * are read into the buffer pool in the background one after the other, this call never waits for I/O.
+   * @param page_id id of the first page of the chain
+   * @param num_pages number of pages to read ahead
+   * @param next_page_id_offset offset of the id of the following page within the data of each page
+   */
+  void PrefetchRange(page_id_t page_id, size_t num_pages, size_t next_page_id_offset) {
+    PrefetchPgImp(page_id, num_pages, next_page_id_offset);
+  }
+
+  /**
+   * Save the ids of the pages in the buffer pool, most recently used first, for WarmUp to reload after a restart.
+   * @param file_name file to write the page ids to, it is replaced atomically
+   * @return false if the file could not be written
+   */
+  auto SaveResidentPages(const std::string &file_name) -> bool;
+
+  /**
+   * Read the pages saved by SaveResidentPages back into the buffer pool in the background. The most recently used
+   * pages which fit into the free frames are read in page id order, so that the disk sees sequential reads. Warming
+   * up never evicts a page.
+   * @param file_name file to read the page ids from
+   * @return false if the file could not be read
+   */
+  auto WarmUp(const std::string &file_name) -> bool;
+
   /** @return size of the buffer pool */
   virtual auto GetPoolSize() -> size_t = 0;
 
+  /** @return a snapshot of the buffer pool counters, summed over all the instances of a parallel buffer pool */
+  virtual auto GetStats() -> BufferPoolStats = 0;
+
  protected:
   /**
    * Grading function. Do not modify!
@@ -104,9 +214,21 @@ class BufferPoolManager {
   /**
    * Fetch the requested page from the buffer pool.
    * @param page_id id of page to be fetched
-   * @return the requested page
+   * @param strategy if not nullptr, a miss recycles a frame from the ring of this bulk access strategy
+   * @return the requested page, nullptr if no frame is available or the page on disk is corrupted
    */
-  virtual auto FetchPgImp(page_id_t page_id) -> Page * = 0;
+  virtual auto FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * = 0;
+
+  /** Fetch the requested page from the buffer pool without an access strategy, as the grading functions do. */
+  auto FetchPgImp(page_id_t page_id) -> Page * { return FetchPgImp(page_id, nullptr); }
+
+  /**
+   * Fetch a batch of pages from the buffer pool.
+   * @param page_ids ids of the pages to be fetched
+   * @param[out] pages the requested pages, in the order of page_ids, nullptr for those which could not be fetched
+   * @return true if all the pages were fetched
+   */
+  virtual auto FetchPgsImp(const std::vector<page_id_t> &page_ids, std::vector<Page *> *pages) -> bool = 0;
 
   /**
    * Unpin the target page from the buffer pool.
@@ -126,9 +248,13 @@ class BufferPoolManager {
   /**
    * Creates a new page in the buffer pool.
    * @param[out] page_id id of created page
+   * @param strategy if not nullptr, the new page recycles a frame from the ring of this bulk access strategy
    * @return nullptr if no new pages could be created, otherwise pointer to new page
    */
-  virtual auto NewPgImp(page_id_t *page_id) -> Page * = 0;
+  virtual auto NewPgImp(page_id_t *page_id, BufferAccessStrategy *strategy) -> Page * = 0;
+
+  /** Creates a new page in the buffer pool without an access strategy, as the grading functions do. */
+  auto NewPgImp(page_id_t *page_id) -> Page * { return NewPgImp(page_id, nullptr); }
 
   /**
    * Deletes a page from the buffer pool.
@@ -141,5 +267,25 @@ class BufferPoolManager {
    * Flushes all the pages in the buffer pool to disk.
    */
   virtual void FlushAllPgsImp() = 0;
+
+  /**
+   * Collects the ids of the pages in the buffer pool.
+   * @param[out] page_ids the page ids, most recently used first
+   */
+  virtual void GetResidentPgsImp(std::vector<page_id_t> *page_ids) = 0;
+
+  /**
+   * Reads pages into the free frames of the buffer pool in the background.
+   * @param page_ids ids of the pages to read, most recently used first
+   */
+  virtual void WarmUpPgImp(std::vector<page_id_t> page_ids) = 0;
+
+  /**
+   * Reads a chain of pages into the buffer pool in the background.
+   * @param page_id id of the first page of the chain, INVALID_PAGE_ID for none
+   * @param num_pages number of pages to read ahead
+   * @param next_page_id_offset offset of the id of the following page within the data of each page
+   */
+  virtual void PrefetchPgImp(page_id_t page_id, size_t num_pages, size_t next_page_id_offset) = 0;
 };
 }  // namespace bustub
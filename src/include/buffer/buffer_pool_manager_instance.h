@@ -12,30 +12,51 @@
 
 #pragma once
 
+#include <condition_variable>  // NOLINT
+#include <deque>
 #include <list>
+#include <memory>
 #include <mutex>  // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
-#include "buffer/lru_replacer.h"
+#include "buffer/frame_arena.h"
+#include "buffer/replacer.h"
 #include "recovery/log_manager.h"
+#include "storage/disk/async_disk_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
 
 namespace bustub {
 
+/**
+ * How page ids are spread over the instances of a parallel buffer pool manager: MODULO maps page_id % num_instances,
+ * HASH mixes the bits of the page id first so that strided or clustered page ids do not pile up in one instance.
+ */
+enum class PageRouting { MODULO, HASH };
+
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
  */
 class BufferPoolManagerInstance : public BufferPoolManager {
+  friend class ParallelBufferPoolManager;
+
  public:
   /**
    * Creates a new BufferPoolManagerInstance.
    * @param pool_size the size of the buffer pool
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy used to pick victim frames. CLOCK pins and unpins frames without a
+   * latch, so hits only take their page table shard latch; LRU and LRU_K serialize them on the replacer latch.
+   * @param frame_allocation whether the frames are allocated on the heap or carved out of a huge page arena
    */
-  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
+  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::CLOCK,
+                            FrameAllocation frame_allocation = FrameAllocation::HEAP);
   /**
    * Creates a new BufferPoolManagerInstance.
    * @param pool_size the size of the buffer pool
@@ -43,9 +64,16 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param instance_index index of this BPI in the parallel BPM
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy used to pick victim frames. CLOCK pins and unpins frames without a
+   * latch, so hits only take their page table shard latch; LRU and LRU_K serialize them on the replacer latch.
+   * @param routing how the parallel BPM maps page ids to instances, this BPI only hands out page ids routed to it
+   * @param frame_allocation whether the frames are allocated on the heap or carved out of a huge page arena, which
+   * is bound to NUMA node instance_index % (number of nodes) in a parallel BPM
    */
   BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                            DiskManager *disk_manager, LogManager *log_manager = nullptr);
+                            DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::CLOCK, PageRouting routing = PageRouting::MODULO,
+                            FrameAllocation frame_allocation = FrameAllocation::HEAP);
 
   /**
    * Destroys an existing BufferPoolManagerInstance.
@@ -58,13 +86,70 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** @return pointer to all the pages in the buffer pool */
   auto GetPages() -> Page * { return pages_; }
 
+  /**
+   * @param page_id id of page
+   * @param num_instances total number of BPIs in parallel BPM
+   * @param routing how page ids are spread over the BPIs
+   * @return index of the BPI responsible for the page
+   */
+  static auto GetInstanceIndex(page_id_t page_id, uint32_t num_instances, PageRouting routing) -> uint32_t;
+
+  /** @return the number of pages currently in the page table */
+  auto GetNumResidentPages() -> size_t;
+
+  /** @return the number of FetchPage calls */
+  auto GetNumFetches() const -> uint64_t { return num_fetches_.Load(); }
+
+  /** @return the number of FetchPage calls which found the page in the buffer pool */
+  auto GetNumHits() const -> uint64_t { return num_hits_.Load(); }
+
+  auto GetStats() -> BufferPoolStats override;
+
+  /**
+   * Start a background writer thread which periodically cleans dirty, unpinned frames closest to eviction, so that
+   * evictions rarely have to write back a dirty victim while holding latch_.
+   * @param dirty_ratio_low the writer cleans only while more than this fraction of the pool is dirty
+   * @param dirty_ratio_high unpinning a page above this fraction of dirty frames wakes the writer up immediately
+   */
+  void RunBackgroundWriter(double dirty_ratio_low = BG_WRITER_DIRTY_RATIO_LOW,
+                           double dirty_ratio_high = BG_WRITER_DIRTY_RATIO_HIGH);
+
+  /**
+   * Stop and join the background writer thread, if it is running.
+   */
+  void StopBackgroundWriter();
+
+  /** @return the number of pages that were evicted to make room for other pages */
+  auto GetNumEvictions() const -> uint64_t { return num_evictions_.Load(); }
+
+  /** @return the number of evictions which still had to write back a dirty victim */
+  auto GetNumForegroundFlushes() const -> uint64_t { return num_foreground_flushes_.Load(); }
+
+  /** @return the number of pages written back by the background writer */
+  auto GetNumBackgroundFlushes() const -> uint64_t { return num_background_flushes_.Load(); }
+
+  /** @return the number of evictions which recycled a frame from the ring of a bulk access strategy */
+  auto GetNumRingRecycles() const -> uint64_t { return num_ring_recycles_.Load(); }
+
+  /** @return the number of pages read into the buffer pool ahead of being fetched */
+  auto GetNumPrefetches() const -> uint64_t { return num_prefetches_.Load(); }
+
  protected:
   /**
    * Fetch the requested page from the buffer pool.
    * @param page_id id of page to be fetched
-   * @return the requested page
+   * @param strategy if not nullptr, a miss recycles a frame from the ring of this bulk access strategy
+   * @return the requested page, nullptr if no frame is available or the page on disk is corrupted
+   */
+  auto FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * override;
+
+  /**
+   * Fetch a batch of pages from the buffer pool.
+   * @param page_ids ids of the pages to be fetched
+   * @param[out] pages the requested pages, in the order of page_ids, nullptr for those which could not be fetched
+   * @return true if all the pages were fetched
    */
-  auto FetchPgImp(page_id_t page_id) -> Page * override;
+  auto FetchPgsImp(const std::vector<page_id_t> &page_ids, std::vector<Page *> *pages) -> bool override;
 
   /**
    * Unpin the target page from the buffer pool.
@@ -84,9 +169,10 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /**
    * Creates a new page in the buffer pool.
    * @param[out] page_id id of created page
+   * @param strategy if not nullptr, the new page recycles a frame from the ring of this bulk access strategy
    * @return nullptr if no new pages could be created, otherwise pointer to new page
    */
-  auto NewPgImp(page_id_t *page_id) -> Page * override;
+  auto NewPgImp(page_id_t *page_id, BufferAccessStrategy *strategy) -> Page * override;
 
   /**
    * Deletes a page from the buffer pool.
@@ -101,18 +187,37 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   void FlushAllPgsImp() override;
 
   /**
-   * Allocate a page on disk.∂
+   * Reads a chain of pages into the buffer pool in the background.
+   * @param page_id id of the first page of the chain, INVALID_PAGE_ID for none
+   * @param num_pages number of pages to read ahead
+   * @param next_page_id_offset offset of the id of the following page within the data of each page
+   */
+  void PrefetchPgImp(page_id_t page_id, size_t num_pages, size_t next_page_id_offset) override;
+
+  /**
+   * Collects the ids of the pages in the buffer pool: pinned pages first, then the others in reverse eviction order.
+   * @param[out] page_ids the page ids, most recently used first
+   */
+  void GetResidentPgsImp(std::vector<page_id_t> *page_ids) override;
+
+  /**
+   * Reads pages into the free frames of the buffer pool on a background thread, replacing a warm-up in progress.
+   * @param page_ids ids of the pages to read, most recently used first
+   */
+  void WarmUpPgImp(std::vector<page_id_t> page_ids) override;
+
+  /**
+   * Allocate a page on disk. Deallocated pages routed to this BPI are reused before the file grows.
    * @return the id of the allocated page
    */
   auto AllocatePage() -> page_id_t;
 
   /**
-   * Deallocate a page on disk.
+   * Deallocate a page on disk, its space is reused by a later allocation. Ids this BPI never handed out are ignored,
+   * reusing one would give it out a second time once the BPI allocates up to it.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  void DeallocatePage(page_id_t page_id);
 
   /**
    * Validate that the page_id being used is accessible to this BPI. This can be used in all of the functions to
@@ -127,29 +232,130 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   const uint32_t num_instances_ = 1;
   /** Index of this BPI in the parallel BPM (if present, otherwise just 0) */
   const uint32_t instance_index_ = 0;
-  /** Each BPI maintains its own counter for page_ids to hand out, must ensure they mod back to its instance_index_ */
+  /** How the parallel BPM routes page ids to its BPIs */
+  const PageRouting routing_ = PageRouting::MODULO;
+  /** Each BPI maintains its own counter for page_ids to hand out, must ensure they route back to its instance_index_ */
   std::atomic<page_id_t> next_page_id_ = instance_index_;
 
+  /** Arena the frames are carved out of, nullptr if they are allocated on the heap. */
+  std::unique_ptr<FrameArena> arena_;
+  /** Page data of the frames allocated on the heap, one aligned block. nullptr if they are carved out of an arena. */
+  char *frame_data_{nullptr};
   /** Array of buffer pool pages. */
   Page *pages_;
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
   /** Pointer to the log manager. */
   LogManager *log_manager_ __attribute__((__unused__));
-  /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
+
+  /**
+   * One partition of the page table. Its latch protects the mapping as well as the pin count transitions of the
+   * frames it maps, so a page that is already resident can be pinned and unpinned without taking latch_.
+   */
+  struct PageTableShard {
+    std::mutex latch_;
+    std::unordered_map<page_id_t, frame_id_t> table_;
+  };
+
+  /** Page table for keeping track of buffer pool pages, partitioned by page id. */
+  std::vector<PageTableShard> page_table_;
   /** Replacer to find unpinned pages for replacement. */
   Replacer *replacer_;
   /** List of free pages. */
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  /**
+   * This latch serializes the slow paths: it protects the free list and is held whenever a frame is (re)assigned to
+   * a page, i.e. on misses, new pages, deletes and flushes. Lock order is latch_ -> shard latch -> replacer latch.
+   */
   std::mutex latch_;
 
+  /**
+   * Number of frames with a pin count of 0, i.e. free or evictable ones. It is updated on every pin count transition
+   * from or to 0, so telling that all the frames are pinned does not have to look at them.
+   */
+  std::atomic<size_t> num_unpinned_frames_;
+  /** Number of dirty frames in the buffer pool. */
+  std::atomic<size_t> num_dirty_{0};
+  /** Counters of the hot paths, each on its own cache line. */
+  StatCounter num_fetches_;
+  StatCounter num_hits_;
+  StatCounter num_evictions_;
+  StatCounter num_foreground_flushes_;
+  StatCounter num_background_flushes_;
+  StatCounter num_ring_recycles_;
+  StatCounter num_pin_failures_;
+  StatCounter latch_wait_ns_;
+
+  /** Background writer state, bg_writer_latch_ protects the running flag and the thresholds. */
+  std::thread bg_writer_thread_;
+  std::mutex bg_writer_latch_;
+  std::condition_variable bg_writer_cv_;
+  bool bg_writer_running_{false};
+  double bg_writer_dirty_ratio_low_{BG_WRITER_DIRTY_RATIO_LOW};
+  std::atomic<double> bg_writer_dirty_ratio_high_{1.0};
+  /** The background writer issues its writes asynchronously, so that a round of cleaning is a single submission. */
+  std::unique_ptr<AsyncDiskManager> async_disk_manager_;
+  /**
+   * Frames whose page the background writer is writing out, protected by cleaning_latch_. They are not pinned, hits
+   * use them as usual, but evictions and deletes leave them be until the write completed: dropping the page earlier
+   * could read it back from disk before the write landed. Lock order is shard latch -> cleaning_latch_.
+   */
+  std::unordered_set<frame_id_t> cleaning_;
+  std::mutex cleaning_latch_;
+  std::condition_variable cleaning_cv_;
+
+  struct PrefetchRequest {
+    page_id_t page_id_;
+    size_t num_pages_;
+    size_t next_page_id_offset_;
+  };
+
+  /** Read-ahead state, prefetch_latch_ protects the request queue and the running/stopped flags. */
+  std::thread prefetch_thread_;
+  std::mutex prefetch_latch_;
+  std::condition_variable prefetch_queue_cv_;
+  std::deque<PrefetchRequest> prefetch_queue_;
+  bool prefetch_running_{false};
+  bool prefetch_stopped_{false};
+  /** Instance the rest of a chain is handed to when reading ahead, the parallel BPM if this BPI is part of one. */
+  BufferPoolManager *prefetch_router_{this};
+  /**
+   * Pages being read ahead, protected by latch_. Their frames are reserved but not in the page table yet, misses on
+   * them wait on prefetch_cv_ instead of reading them a second time.
+   */
+  std::unordered_set<page_id_t> prefetching_;
+  std::condition_variable prefetch_cv_;
+  /** Read-ahead recycles its own ring of frames, so that reading ahead does not flush the buffer pool either. */
+  BufferAccessStrategy prefetch_strategy_{PREFETCH_RING_SIZE};
+  StatCounter num_prefetches_;
+
+  /** Warm-up state, warm_up_latch_ serializes starting and stopping the warm-up thread. */
+  std::thread warm_up_thread_;
+  std::mutex warm_up_latch_;
+  std::atomic<bool> warm_up_stopped_{false};
+
  private:
-  bool FindPg(page_id_t page_id);
-  void FlushPg(Page *page);
+  auto GetShard(page_id_t page_id) -> PageTableShard &;
+  auto LockLatch(std::mutex *latch) -> std::unique_lock<std::mutex>;
+  auto PinResidentPg(page_id_t page_id) -> Page *;
+  auto PeekResidentPg(page_id_t page_id) -> Page *;
+  auto FlushPg(Page *page) -> bool;
+  auto DirtyRatio() const -> double { return static_cast<double>(num_dirty_) / pool_size_; }
+  void BackgroundWriterLoop();
+  auto CleanFrames() -> size_t;
+  auto IsBeingCleaned(frame_id_t frame_id) -> bool;
+  void WaitForCleaning();
   bool AllPgsPinned();
-  bool GetFrameId(frame_id_t *frame_id);
+  bool GetFrameId(frame_id_t *frame_id, BufferAccessStrategy *strategy);
+  auto RecycleRingFrame(page_id_t page_id, frame_id_t *frame_id) -> bool;
+  void WaitForPrefetch(std::unique_lock<std::mutex> *lock, page_id_t page_id);
+  void PrefetchLoop();
+  auto ReadAheadPg(page_id_t page_id, bool warm_up = false) -> Page *;
+  void StopPrefetcher();
+  void WarmUpLoop(std::vector<page_id_t> page_ids);
+  void StopWarmUp();
   void ResetPg(Page *page, page_id_t page_id = INVALID_PAGE_ID, int pin_count = 0);
+  /** Return a reserved frame whose page could not be read to the free list, latch_ must be held */
+  void ReleaseFrame(Page *page);
 };
 }  // namespace bustub
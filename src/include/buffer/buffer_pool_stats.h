@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.h
+//
+// Identification: src/include/buffer/buffer_pool_stats.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * A relaxed atomic counter on a cache line of its own, so that threads bumping different counters of a buffer pool
+ * do not contend for the same line. Counters are only ever read for reporting, so no ordering is needed.
+ */
+class alignas(CACHE_LINE_SIZE) StatCounter {
+ public:
+  void Add(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+
+  auto Load() const -> uint64_t { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint64_t> value_{0};
+};
+
+/**
+ * A snapshot of the counters of a buffer pool. The counters are read one by one while the buffer pool keeps running,
+ * so the snapshot is not an atomic cut, but each counter is exact.
+ */
+struct BufferPoolStats {
+  /** FetchPage calls, and pages of FetchPages calls */
+  uint64_t fetches_{0};
+  /** Fetches which found the page in the buffer pool */
+  uint64_t hits_{0};
+  /** Fetches which had to read the page from disk or failed to */
+  uint64_t misses_{0};
+  /** Pages evicted to make room for other pages */
+  uint64_t evictions_{0};
+  /** Evictions which had to write back a dirty victim */
+  uint64_t dirty_evictions_{0};
+  /** Pages written back by the background writer */
+  uint64_t background_flushes_{0};
+  /** Evictions which recycled a frame from the ring of a bulk access strategy */
+  uint64_t ring_recycles_{0};
+  /** Pages read into the buffer pool ahead of being fetched */
+  uint64_t prefetches_{0};
+  /** Fetches and new pages which failed because every frame was pinned */
+  uint64_t pin_failures_{0};
+  /** Time spent waiting for contended buffer pool latches, in nanoseconds */
+  uint64_t latch_wait_ns_{0};
+
+  auto operator+=(const BufferPoolStats &that) -> BufferPoolStats & {
+    fetches_ += that.fetches_;
+    hits_ += that.hits_;
+    misses_ += that.misses_;
+    evictions_ += that.evictions_;
+    dirty_evictions_ += that.dirty_evictions_;
+    background_flushes_ += that.background_flushes_;
+    ring_recycles_ += that.ring_recycles_;
+    prefetches_ += that.prefetches_;
+    pin_failures_ += that.pin_failures_;
+    latch_wait_ns_ += that.latch_wait_ns_;
+    return *this;
+  }
+
+  /** @return the fraction of fetches which found the page in the buffer pool, 0 if there were none */
+  auto HitRate() const -> double { return fetches_ == 0 ? 0 : static_cast<double>(hits_) / fetches_; }
+};
+
+}  // namespace bustub
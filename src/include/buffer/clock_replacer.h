@@ -12,8 +12,8 @@
 
 #pragma once
 
-#include <list>
-#include <mutex>  // NOLINT
+#include <atomic>
+#include <memory>
 #include <vector>
 
 #include "buffer/replacer.h"
@@ -23,6 +23,8 @@ namespace bustub {
 
 /**
  * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used policy.
+ * Every frame has an atomic state which combines its membership and its reference bit, so Pin and Unpin are a
+ * single atomic operation each and never block. Victim sweeps the clock hand without taking any latch either.
  */
 class ClockReplacer : public Replacer {
  public:
@@ -45,8 +47,17 @@ class ClockReplacer : public Replacer {
 
   auto Size() -> size_t override;
 
+  void PeekVictims(size_t max_frames, std::vector<frame_id_t> *frame_ids) override;
+
  private:
-  // TODO(student): implement me!
+  /** A frame is either not in the replacer, or in it with its reference bit cleared or set. */
+  enum FrameState : uint8_t { ABSENT = 0, UNREFERENCED, REFERENCED };
+
+  size_t num_pages_;
+  std::unique_ptr<std::atomic<uint8_t>[]> states_;
+  std::atomic<size_t> clock_hand_{0};
+  /** Signed, since a concurrent Pin can decrement it before the matching Unpin has incremented it. */
+  std::atomic<int64_t> size_{0};
 };
 
 }  // namespace bustub
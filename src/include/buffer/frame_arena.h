@@ -0,0 +1,66 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/** How a buffer pool allocates its frames. */
+enum class FrameAllocation { HEAP, ARENA };
+
+/**
+ * FrameArena carves the frames of a buffer pool out of a single anonymous mapping. The mapping is backed by 2 MB huge
+ * pages if the system has some reserved (MAP_HUGETLB), by transparent huge pages otherwise, and can be bound to a NUMA
+ * node before the frames are first touched.
+ *
+ * The page data of all the frames forms one block at the huge page aligned beginning of the mapping, followed by the
+ * array of Page objects pointing into it. Page data is therefore aligned, which O_DIRECT requires of its buffers.
+ */
+class FrameArena {
+ public:
+  /**
+   * Create a new FrameArena and construct its frames.
+   * @param num_frames the number of frames
+   * @param numa_node the NUMA node to place the frames on, -1 to leave it to the kernel
+   */
+  explicit FrameArena(size_t num_frames, int numa_node = -1);
+
+  /**
+   * Destroys the frames and unmaps the arena.
+   */
+  ~FrameArena();
+
+  FrameArena(const FrameArena &) = delete;
+  auto operator=(const FrameArena &) -> FrameArena & = delete;
+
+  /** @return pointer to the first frame */
+  auto GetFrames() -> Page * { return frames_; }
+
+  /** @return true if the arena is backed by reserved huge pages */
+  auto UsesHugePages() const -> bool { return huge_pages_; }
+
+  /** @return the number of NUMA nodes of the system, 1 if it cannot tell */
+  static auto GetNumNumaNodes() -> int;
+
+ private:
+  size_t num_frames_;
+  size_t size_;
+  bool huge_pages_{false};
+  char *memory_;
+  Page *frames_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,84 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.h
+//
+// Identification: src/include/buffer/lru_k_replacer.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <deque>
+#include <mutex>  // NOLINT
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * Every Pin counts as an access to the frame. The victim is the frame whose K-th most recent access is the oldest,
+ * i.e. the one with the largest backward K-distance. Frames with fewer than K accesses have an infinite backward
+ * K-distance and are evicted first, oldest access first. Pages touched by a single scan therefore go before pages
+ * that keep being re-referenced, such as index inner pages and hash table directories.
+ *
+ * Accesses following the previous access of the same frame within the correlated reference period (e.g. a scan
+ * fetching the same page once per tuple) only refresh the most recent access instead of adding to the history.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of accesses kept per frame
+   * @param correlated_period accesses at most this many timestamps apart are considered correlated
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = LRUK_REPLACER_K,
+                        size_t correlated_period = LRUK_CORRELATED_PERIOD);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  auto Victim(frame_id_t *frame_id) -> bool override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  void PeekVictims(size_t max_frames, std::vector<frame_id_t> *frame_ids) override;
+
+ private:
+  /** Eviction order: frames with less than k accesses first, then by their oldest kept access. */
+  using EvictionKey = std::pair<std::pair<bool, uint64_t>, frame_id_t>;
+
+  struct FrameHistory {
+    /** Timestamps of the last k uncorrelated accesses, most recent first. */
+    std::deque<uint64_t> accesses_;
+    bool evictable_{false};
+  };
+
+  void RecordAccess(frame_id_t frame_id);
+  auto GetEvictionKey(frame_id_t frame_id) -> EvictionKey;
+
+  size_t k_;
+  size_t correlated_period_;
+  uint64_t current_timestamp_{0};
+  std::vector<FrameHistory> frames_;
+  std::set<EvictionKey> evictable_;
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -15,6 +15,7 @@
 #include <list>
 #include <mutex>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
 #include "buffer/replacer.h"
 #include "common/config.h"
@@ -45,6 +46,8 @@ class LRUReplacer : public Replacer {
 
   auto Size() -> size_t override;
 
+  void PeekVictims(size_t max_frames, std::vector<frame_id_t> *frame_ids) override;
+
  private:
   // TODO(student): implement me!
   frame_id_t GetVictim();
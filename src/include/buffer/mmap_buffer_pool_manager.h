@@ -0,0 +1,117 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// mmap_buffer_pool_manager.h
+//
+// Identification: src/include/buffer/mmap_buffer_pool_manager.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_stats.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * MmapBufferPoolManager serves the pages of a database file opened strictly read-only, e.g. on an analytics replica.
+ * The whole file is mapped once, and fetching a page hands out a view whose data points straight into the mapping:
+ * nothing is copied into a frame, and since nothing is ever evicted there is no replacer and no page table. The page
+ * cache of the kernel takes the place of the buffer pool.
+ *
+ * The mapping is read-only, so are the pages: NewPage and DeletePage fail, and writing to the data of a page crashes.
+ * For the same reason the checksum trailer of a page is left in place rather than cleared as a DiskManager does.
+ * Pages appended to the file after it was mapped are not visible, and the file must not be truncated while mapped.
+ * Compressed database files cannot be mapped.
+ */
+class MmapBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * Map a database file.
+   * @param db_file the database file, it is opened read-only
+   */
+  explicit MmapBufferPoolManager(const std::string &db_file);
+
+  /**
+   * Unmaps the database file. No page may be pinned anymore.
+   */
+  ~MmapBufferPoolManager() override;
+
+  /** @return the number of pages of the database file */
+  auto GetPoolSize() -> size_t override { return num_pages_; }
+
+  auto GetStats() -> BufferPoolStats override;
+
+ protected:
+  /**
+   * Fetch the view of a page. The strategy is ignored, there are no frames to recycle.
+   * @param page_id id of page to be fetched
+   * @param strategy unused
+   * @return the view of the page, nullptr if the page is past the end of the file or corrupted
+   */
+  auto FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * override;
+
+  auto FetchPgsImp(const std::vector<page_id_t> &page_ids, std::vector<Page *> *pages) -> bool override;
+
+  /**
+   * Unpin the view of a page. Pages cannot be dirtied, the mapping is read-only.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty unused
+   * @return false if the page pin count is <= 0 before this call, true otherwise
+   */
+  auto UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool override;
+
+  /** Pages are never dirty, there is nothing to flush. @return true if the page exists */
+  auto FlushPgImp(page_id_t page_id) -> bool override;
+
+  /** The file is read-only. @return nullptr */
+  auto NewPgImp(page_id_t *page_id, BufferAccessStrategy *strategy) -> Page * override;
+
+  /** The file is read-only. @return true only if the page does not exist */
+  auto DeletePgImp(page_id_t page_id) -> bool override;
+
+  void FlushAllPgsImp() override {}
+
+  /** Residency is up to the page cache, nothing is saved for warming up. */
+  void GetResidentPgsImp(std::vector<page_id_t> *page_ids) override {}
+
+  /** Ask the kernel to read the pages into the page cache. */
+  void WarmUpPgImp(std::vector<page_id_t> page_ids) override;
+
+  /**
+   * Ask the kernel to read pages into the page cache. Following the chain would wait for the pages, so the pages
+   * after page_id are read instead: table heaps are mostly allocated in order.
+   */
+  void PrefetchPgImp(page_id_t page_id, size_t num_pages, size_t next_page_id_offset) override;
+
+ private:
+  /** @return the view of a page, created on first use once its checksum is verified, nullptr if it is corrupted */
+  auto GetView(page_id_t page_id) -> Page *;
+
+  /** Tell the kernel that a run of pages is going to be accessed soon. */
+  void AdviseWillNeed(page_id_t page_id, size_t num_pages);
+
+  /** File descriptor of the database file. */
+  int fd_{-1};
+  /** The mapping of the database file, nullptr if the file is empty. */
+  char *data_{nullptr};
+  /** Number of pages of the database file when it was mapped. */
+  size_t num_pages_{0};
+  /** Views of the pages, indexed by page id. Views are never freed before the buffer pool, so pins do not count. */
+  std::unique_ptr<std::atomic<Page *>[]> views_;
+
+  StatCounter num_fetches_;
+  StatCounter num_prefetches_;
+};
+
+}  // namespace bustub
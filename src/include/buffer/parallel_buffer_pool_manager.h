@@ -12,10 +12,12 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
@@ -30,9 +32,15 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    * @param pool_size the pool size of each BufferPoolManagerInstance
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy of each BufferPoolManagerInstance, see its constructor
+   * @param routing how page ids are spread over the BufferPoolManagerInstances
+   * @param frame_allocation how each BufferPoolManagerInstance allocates its frames, arenas are spread over the NUMA
+   * nodes
    */
   ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
-                            LogManager *log_manager = nullptr);
+                            LogManager *log_manager = nullptr, ReplacerType replacer_type = ReplacerType::CLOCK,
+                            PageRouting routing = PageRouting::MODULO,
+                            FrameAllocation frame_allocation = FrameAllocation::HEAP);
 
   /**
    * Destroys an existing ParallelBufferPoolManager.
@@ -42,6 +50,42 @@ class ParallelBufferPoolManager : public BufferPoolManager {
   /** @return size of the buffer pool */
   auto GetPoolSize() -> size_t override;
 
+  auto GetStats() -> BufferPoolStats override;
+
+  /**
+   * Start the background writer of every BufferPoolManagerInstance.
+   * @param dirty_ratio_low an instance's writer cleans only while more than this fraction of its frames is dirty
+   * @param dirty_ratio_high unpinning a page above this fraction of dirty frames wakes the instance's writer up
+   */
+  void RunBackgroundWriter(double dirty_ratio_low = BG_WRITER_DIRTY_RATIO_LOW,
+                           double dirty_ratio_high = BG_WRITER_DIRTY_RATIO_HIGH);
+
+  /**
+   * Stop the background writer of every BufferPoolManagerInstance.
+   */
+  void StopBackgroundWriter();
+
+  /** @return the number of BufferPoolManagerInstances */
+  auto GetNumInstances() const -> size_t { return v_.size(); }
+
+  /**
+   * @param instance_index index of a BufferPoolManagerInstance
+   * @return the fraction of the frames of the instance holding a page
+   */
+  auto GetInstanceOccupancy(size_t instance_index) -> double;
+
+  /**
+   * @param instance_index index of a BufferPoolManagerInstance
+   * @return the fraction of the fetches served by the instance which found the page in its buffer pool
+   */
+  auto GetInstanceHitRate(size_t instance_index) -> double;
+
+  /**
+   * @param instance_index index of a BufferPoolManagerInstance
+   * @return a snapshot of the counters of the instance
+   */
+  auto GetInstanceStats(size_t instance_index) -> BufferPoolStats { return v_[instance_index]->GetStats(); }
+
  protected:
   /**
    * @param page_id id of page
@@ -52,9 +96,18 @@ class ParallelBufferPoolManager : public BufferPoolManager {
   /**
    * Fetch the requested page from the buffer pool.
    * @param page_id id of page to be fetched
+   * @param strategy if not nullptr, a miss recycles a frame from the ring of this bulk access strategy
    * @return the requested page
    */
-  auto FetchPgImp(page_id_t page_id) -> Page * override;
+  auto FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * override;
+
+  /**
+   * Fetch a batch of pages from the buffer pool.
+   * @param page_ids ids of the pages to be fetched
+   * @param[out] pages the requested pages, in the order of page_ids, nullptr for those which could not be fetched
+   * @return true if all the pages were fetched
+   */
+  auto FetchPgsImp(const std::vector<page_id_t> &page_ids, std::vector<Page *> *pages) -> bool override;
 
   /**
    * Unpin the target page from the buffer pool.
@@ -74,9 +127,10 @@ class ParallelBufferPoolManager : public BufferPoolManager {
   /**
    * Creates a new page in the buffer pool.
    * @param[out] page_id id of created page
+   * @param strategy if not nullptr, the new page recycles a frame from the ring of this bulk access strategy
    * @return nullptr if no new pages could be created, otherwise pointer to new page
    */
-  auto NewPgImp(page_id_t *page_id) -> Page * override;
+  auto NewPgImp(page_id_t *page_id, BufferAccessStrategy *strategy) -> Page * override;
 
   /**
    * Deletes a page from the buffer pool.
@@ -90,8 +144,30 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    */
   void FlushAllPgsImp() override;
 
+  /**
+   * Reads a chain of pages into the buffer pool in the background.
+   * @param page_id id of the first page of the chain, INVALID_PAGE_ID for none
+   * @param num_pages number of pages to read ahead
+   * @param next_page_id_offset offset of the id of the following page within the data of each page
+   */
+  void PrefetchPgImp(page_id_t page_id, size_t num_pages, size_t next_page_id_offset) override;
+
+  /**
+   * Collects the ids of the pages in all the BufferPoolManagerInstances, interleaving their recency orders.
+   * @param[out] page_ids the page ids, most recently used first
+   */
+  void GetResidentPgsImp(std::vector<page_id_t> *page_ids) override;
+
+  /**
+   * Hands each BufferPoolManagerInstance the pages routed to it to warm up with.
+   * @param page_ids ids of the pages to read, most recently used first
+   */
+  void WarmUpPgImp(std::vector<page_id_t> page_ids) override;
+
  private:
-  std::vector<std::unique_ptr<BufferPoolManager>> v_;
-  int32_t starting_index_ = 0;
+  std::vector<std::unique_ptr<BufferPoolManagerInstance>> v_;
+  const PageRouting routing_;
+  /** Instance NewPage starts looking for a free frame at, bumped by every call */
+  std::atomic<size_t> starting_index_{0};
 };
 }  // namespace bustub
@@ -12,10 +12,15 @@
 
 #pragma once
 
+#include <vector>
+
 #include "common/config.h"
 
 namespace bustub {
 
+/** The replacement policies a buffer pool can be created with. */
+enum class ReplacerType { LRU, CLOCK, LRU_K };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -45,6 +50,13 @@ class Replacer {
 
   /** @return the number of elements in the replacer that can be victimized */
   virtual auto Size() -> size_t = 0;
+
+  /**
+   * Collect the frames that would be victimized next, in eviction order, without removing them from the replacer.
+   * @param max_frames the maximum number of frames to collect
+   * @param[out] frame_ids the frames closest to eviction
+   */
+  virtual void PeekVictims(size_t max_frames, std::vector<frame_id_t> *frame_ids) = 0;
 };
 
 }  // namespace bustub
@@ -21,6 +21,7 @@
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/schema.h"
 #include "container/hash/hash_function.h"
+#include "storage/index/b_plus_tree_index.h"
 #include "storage/index/extendible_hash_table_index.h"
 #include "storage/index/index.h"
 #include "storage/table/table_heap.h"
@@ -34,6 +35,9 @@ using table_oid_t = uint32_t;
 using column_oid_t = uint32_t;
 using index_oid_t = uint32_t;
 
+/** The kinds of indexes the catalog can create */
+enum class IndexType { HashTableIndex, BPlusTreeIndex };
+
 /**
  * The TableInfo class maintains metadata about a table.
  */
@@ -186,12 +190,14 @@ class Catalog {
    * @param key_attrs Key attributes
    * @param keysize Size of the key
    * @param hash_function The hash function for the index
+   * @param index_type The kind of index to create, a B+ tree index is bulk loaded from the table
    * @return A (non-owning) pointer to the metadata of the new table
    */
   template <class KeyType, class ValueType, class KeyComparator>
   auto CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name, const Schema &schema,
                    const Schema &key_schema, const std::vector<uint32_t> &key_attrs, std::size_t keysize,
-                   HashFunction<KeyType> hash_function) -> IndexInfo * {
+                   HashFunction<KeyType> hash_function, IndexType index_type = IndexType::HashTableIndex)
+      -> IndexInfo * {
     // Reject the creation request for nonexistent table
     if (table_names_.find(table_name) == table_names_.end()) {
       return NULL_INDEX_INFO;
@@ -210,18 +216,36 @@ class Catalog {
     // Construct index metdata
     auto meta = std::make_unique<IndexMetadata>(index_name, table_name, &schema, key_attrs);
 
-    // Construct the index, take ownership of metadata
-    // TODO(Kyle): We should update the API for CreateIndex
-    // to allow specification of the index type itself, not
-    // just the key, value, and comparator types
-    auto index = std::make_unique<ExtendibleHashTableIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_,
-                                                                                               hash_function);
-
-    // Populate the index with all tuples in table heap
+    // Populate the index with all tuples in table heap, reading the table through a ring of frames so that the
+    // backfill does not flush the buffer pool
     auto *table_meta = GetTable(table_name);
     auto *heap = table_meta->table_.get();
-    for (auto tuple = heap->Begin(txn); tuple != heap->End(); ++tuple) {
-      index->InsertEntry(tuple->KeyFromTuple(schema, key_schema, key_attrs), tuple->GetRid(), txn);
+    BufferAccessStrategy strategy;
+    auto tuple = heap->Begin(txn, &strategy);
+
+    // Construct the index, take ownership of metadata
+    std::unique_ptr<Index> index;
+    if (index_type == IndexType::BPlusTreeIndex) {
+      // The new tree is empty, so it is built bottom-up rather than by inserting the tuples one by one
+      auto tree_index = std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_);
+      tree_index->BulkLoad(
+          [&](Tuple *key, RID *rid) {
+            if (tuple == heap->End()) {
+              return false;
+            }
+            *key = tuple->KeyFromTuple(schema, key_schema, key_attrs);
+            *rid = tuple->GetRid();
+            ++tuple;
+            return true;
+          },
+          txn);
+      index = std::move(tree_index);
+    } else {
+      index = std::make_unique<ExtendibleHashTableIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_,
+                                                                                            hash_function);
+      for (; tuple != heap->End(); ++tuple) {
+        index->InsertEntry(tuple->KeyFromTuple(schema, key_schema, key_attrs), tuple->GetRid(), txn);
+      }
     }
 
     // Get the next OID for the new index
@@ -34,6 +34,11 @@ class BustubInstance {
 
     buffer_pool_manager_ = new BufferPoolManagerInstance(BUFFER_POOL_SIZE, disk_manager_, log_manager_);
 
+    // warm-up: reload the pages that were in the buffer pool when the instance last shut down
+    auto n = db_file_name.rfind('.');
+    warm_up_file_name_ = db_file_name.substr(0, n) + ".warmup";
+    buffer_pool_manager_->WarmUp(warm_up_file_name_);
+
     // txn related
     lock_manager_ = new LockManager();
     transaction_manager_ = new TransactionManager(lock_manager_, log_manager_);
@@ -43,6 +48,7 @@ class BustubInstance {
   }
 
   ~BustubInstance() {
+    buffer_pool_manager_->SaveResidentPages(warm_up_file_name_);
     if (enable_logging) {
       log_manager_->StopFlushThread();
     }
@@ -60,6 +66,7 @@ class BustubInstance {
   TransactionManager *transaction_manager_;
   LogManager *log_manager_;
   CheckpointManager *checkpoint_manager_;
+  std::string warm_up_file_name_;
 };
 
 }  // namespace bustub
@@ -16,6 +16,11 @@
 #include <chrono>  // NOLINT
 #include <cstdint>
 
+/** The page size is chosen per build, see BUSTUB_PAGE_SIZE in CMakeLists.txt */
+#ifndef BUSTUB_PAGE_SIZE
+#define BUSTUB_PAGE_SIZE 4096
+#endif
+
 namespace bustub {
 
 /** Cycle detection is performed every CYCLE_DETECTION_INTERVAL milliseconds. */
@@ -27,14 +32,35 @@ extern std::atomic<bool> enable_logging;
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/** A running buffer pool background writer wakes up every BG_WRITER_INTERVAL to clean dirty frames. */
+extern std::chrono::milliseconds bg_writer_interval;
+
 static constexpr int INVALID_PAGE_ID = -1;                                    // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                     // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                        // invalid log sequence number
 static constexpr int HEADER_PAGE_ID = 0;                                      // the header page id
-static constexpr int PAGE_SIZE = 4096;                                        // size of a data page in byte
+static constexpr int PAGE_SIZE = BUSTUB_PAGE_SIZE;                            // size of a data page in byte
+static constexpr int PAGE_CHECKSUM_SIZE = 4;                                  // checksum trailer ending each page
 static constexpr int BUFFER_POOL_SIZE = 10;                                   // size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                        // size of extendible hash bucket
+static constexpr int PAGE_TABLE_SHARDS = 16;                                  // page table partitions, a power of 2
+static constexpr int BG_WRITER_MAX_PAGES = 100;                               // max pages cleaned per bg writer round
+static constexpr double BG_WRITER_DIRTY_RATIO_LOW = 0.1;                      // bg writer idles below this dirty ratio
+static constexpr double BG_WRITER_DIRTY_RATIO_HIGH = 0.5;                     // bg writer wakes up above this ratio
+static constexpr int LRUK_REPLACER_K = 2;                                     // lookback window of the LRU-K replacer
+static constexpr int LRUK_CORRELATED_PERIOD = 1;                              // LRU-K correlated reference period
+static constexpr int BUFFER_RING_SIZE = 16;                                   // frames per bulk access strategy ring
+static constexpr int SCAN_PREFETCH_DISTANCE = 4;                              // pages a sequential scan reads ahead
+static constexpr int PREFETCH_RING_SIZE = 32;                                 // frames recycled for read-ahead per BPI
+static constexpr int PREFETCH_QUEUE_SIZE = 64;                                // pending read-ahead requests per BPI
+static constexpr int CACHE_LINE_SIZE = 64;                                    // hot counters are padded to a cache line
+static constexpr int ASYNC_IO_QUEUE_DEPTH = 128;                              // async disk requests in flight per BPI
+static constexpr size_t EXTERNAL_SORT_RUN_BYTES = 64 << 20;                   // memory sorting a run before it spills
+static constexpr double BULK_LOAD_FILL_FACTOR = 0.9;                          // fill of pages packed by a bulk load
+
+static_assert(PAGE_SIZE >= 4096 && PAGE_SIZE <= 32768 && (PAGE_SIZE & (PAGE_SIZE - 1)) == 0,
+              "the page size must be a power of two between 4 KB and 32 KB");
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
@@ -0,0 +1,38 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c_util.h
+//
+// Identification: src/include/common/util/crc32c_util.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * CRC32C (Castagnoli) checksums, as used by iSCSI, ext4 and most storage engines. On x86-64 CPUs with SSE4.2 the
+ * checksum is computed by the crc32 instruction, eight bytes at a time; elsewhere a table-driven implementation is
+ * used. Both produce the same checksums.
+ */
+class Crc32cUtil {
+ public:
+  /**
+   * @param data the bytes to checksum
+   * @param length number of bytes
+   * @return the CRC32C of the bytes
+   */
+  static auto Checksum(const char *data, size_t length) -> uint32_t;
+
+  /** @return true if the checksum is computed in hardware */
+  static auto IsHardwareAccelerated() -> bool;
+};
+
+}  // namespace bustub
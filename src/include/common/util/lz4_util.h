@@ -0,0 +1,50 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz4_util.h
+//
+// Identification: src/include/common/util/lz4_util.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+namespace bustub {
+
+/**
+ * Compression of small buffers such as pages, in the LZ4 block format. The compressor is a plain greedy one: it
+ * favors speed over ratio, which is what a page written on every flush needs. Buffers are limited to 64 KB, so that
+ * every match offset fits the format.
+ */
+class Lz4Util {
+ public:
+  /** The largest buffer which can be compressed */
+  static constexpr size_t MAX_INPUT_SIZE = 65535;
+
+  /**
+   * Compress a buffer.
+   * @param src the bytes to compress, at most MAX_INPUT_SIZE
+   * @param src_size number of bytes
+   * @param[out] dst output buffer
+   * @param dst_capacity size of the output buffer
+   * @return the size of the compressed bytes, 0 if they do not fit into the output buffer
+   */
+  static auto Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity) -> size_t;
+
+  /**
+   * Decompress a buffer. Malformed input is detected, it never reads or writes out of bounds.
+   * @param src the compressed bytes
+   * @param src_size number of compressed bytes
+   * @param[out] dst output buffer
+   * @param dst_capacity size of the output buffer
+   * @return the size of the decompressed bytes, -1 if the input is malformed or does not fit into the output buffer
+   */
+  static auto Decompress(const char *src, size_t src_size, char *dst, size_t dst_capacity) -> int;
+};
+
+}  // namespace bustub
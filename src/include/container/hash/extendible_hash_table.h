@@ -122,19 +122,20 @@ class ExtendibleHashTable {
   inline auto KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page) -> uint32_t;
 
   /**
-   * Fetches the directory page from the buffer pool manager.
+   * Fetches the directory page from the buffer pool manager. The directory is protected by table_latch_ rather than
+   * by its page latch, so the guard only holds the pin.
    *
-   * @return a pointer to the directory page
+   * @return a guard holding the directory page
    */
-  auto FetchDirectoryPage() -> HashTableDirectoryPage *;
+  auto FetchDirectoryPage() -> BasicPageGuard;
 
   /**
    * Fetches the a bucket page from the buffer pool manager using the bucket's page_id.
    *
    * @param bucket_page_id the page_id to fetch
-   * @return a pointer to a bucket page
+   * @return a guard holding the bucket page, to be upgraded to a read or write guard before accessing it
    */
-  auto FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BUCKET_TYPE *;
+  auto FetchBucketPage(page_id_t bucket_page_id) -> BasicPageGuard;
 
   /**
    * Performs insertion with an optional bucket splitting.
@@ -23,9 +23,10 @@
 namespace bustub {
 
 /**
- * IndexScanExecutor executes an index scan over a table.
+ * IndexScanExecutor executes an index scan over a table. The index is range scanned for the record ids of the tuples
+ * whose keys are within the bounds of the plan, and those tuples are fetched from the table in key order and filtered
+ * by the predicate of the plan.
  */
-
 class IndexScanExecutor : public AbstractExecutor {
  public:
   /**
@@ -44,5 +45,10 @@ class IndexScanExecutor : public AbstractExecutor {
  private:
   /** The index scan plan node to be executed. */
   const IndexScanPlanNode *plan_;
+  IndexInfo *index_info_;
+  TableInfo *table_info_;
+  /** The record ids of the tuples in the range, and the next one to fetch */
+  std::vector<RID> rids_;
+  size_t next_rid_{0};
 };
 }  // namespace bustub
@@ -63,6 +63,8 @@ class InsertExecutor : public AbstractExecutor {
   std::unique_ptr<AbstractExecutor> child_executor_;
   TableInfo *table_info_;
   uint32_t raw_values_idx_;
+  /** Bulk inserts walk the table pages through a ring of frames instead of polluting the whole buffer pool */
+  BufferAccessStrategy strategy_;
 };
 
 }  // namespace bustub
@@ -52,6 +52,8 @@ class SeqScanExecutor : public AbstractExecutor {
   /** The sequential scan plan node to be executed */
   const SeqScanPlanNode *plan_;
   TableInfo *table_info_;
+  /** The scan reads the table into a ring of frames instead of polluting the whole buffer pool */
+  BufferAccessStrategy strategy_;
   std::unique_ptr<TableIterator> table_iter_;
 };
 }  // namespace bustub
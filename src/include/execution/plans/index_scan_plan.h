@@ -12,13 +12,18 @@
 
 #pragma once
 
+#include <utility>
+#include <vector>
+
 #include "catalog/catalog.h"
 #include "execution/expressions/abstract_expression.h"
 #include "execution/plans/abstract_plan.h"
 
 namespace bustub {
 /**
- * IndexScanPlanNode identifies a table that should be scanned with an optional predicate.
+ * IndexScanPlanNode identifies an index whose table should be scanned, in key order, with an optional predicate. The
+ * scan may be bounded to a range of keys, then only the part of the index holding the range is read. The predicate is
+ * still tested against the tuples in the range, it may hold conditions the bounds do not cover.
  */
 class IndexScanPlanNode : public AbstractPlanNode {
  public:
@@ -27,24 +32,68 @@ class IndexScanPlanNode : public AbstractPlanNode {
    * @param output the output format of this scan plan node
    * @param predicate the predicate to scan with, tuples are returned if predicate(tuple) == true or predicate ==
    * nullptr
-   * @param table_oid the identifier of table to be scanned
+   * @param index_oid the identifier of the index to be scanned
    */
   IndexScanPlanNode(const Schema *output, const AbstractExpression *predicate, index_oid_t index_oid)
       : AbstractPlanNode(output, {}), predicate_{predicate}, index_oid_(index_oid) {}
 
+  /**
+   * Creates a new index scan plan node over a range of keys.
+   * @param output the output format of this scan plan node
+   * @param predicate the predicate to scan with, tested against the tuples in the range
+   * @param index_oid the identifier of the index to be scanned
+   * @param low_key the values of the key columns of the lowest key, empty if the range has no lower bound
+   * @param low_inclusive whether the range includes low_key
+   * @param high_key the values of the key columns of the highest key, empty if the range has no upper bound
+   * @param high_inclusive whether the range includes high_key
+   * @param direction whether tuples are returned in ascending or descending key order
+   */
+  IndexScanPlanNode(const Schema *output, const AbstractExpression *predicate, index_oid_t index_oid,
+                    std::vector<Value> low_key, bool low_inclusive, std::vector<Value> high_key, bool high_inclusive,
+                    ScanDirection direction = ScanDirection::FORWARD)
+      : AbstractPlanNode(output, {}),
+        predicate_{predicate},
+        index_oid_(index_oid),
+        low_key_(std::move(low_key)),
+        low_inclusive_(low_inclusive),
+        high_key_(std::move(high_key)),
+        high_inclusive_(high_inclusive),
+        direction_(direction) {}
+
   auto GetType() const -> PlanType override { return PlanType::IndexScan; }
 
   /** @return the predicate to test tuples against; tuples should only be returned if they evaluate to true */
   auto GetPredicate() const -> const AbstractExpression * { return predicate_; }
 
-  /** @return the identifier of the table that should be scanned */
+  /** @return the identifier of the index that should be scanned */
   auto GetIndexOid() const -> index_oid_t { return index_oid_; }
 
+  /** @return the values of the lowest key of the range, empty if it has no lower bound */
+  auto GetLowKey() const -> const std::vector<Value> & { return low_key_; }
+
+  /** @return whether the range includes its lowest key */
+  auto IsLowInclusive() const -> bool { return low_inclusive_; }
+
+  /** @return the values of the highest key of the range, empty if it has no upper bound */
+  auto GetHighKey() const -> const std::vector<Value> & { return high_key_; }
+
+  /** @return whether the range includes its highest key */
+  auto IsHighInclusive() const -> bool { return high_inclusive_; }
+
+  /** @return the order the tuples are returned in */
+  auto GetDirection() const -> ScanDirection { return direction_; }
+
  private:
   /** The predicate that all returned tuples must satisfy. */
   const AbstractExpression *predicate_;
-  /** The table whose tuples should be scanned. */
+  /** The index whose table should be scanned. */
   index_oid_t index_oid_;
+  /** The bounds of the range of keys to scan, unbounded by default. */
+  std::vector<Value> low_key_;
+  bool low_inclusive_{true};
+  std::vector<Value> high_key_;
+  bool high_inclusive_{true};
+  ScanDirection direction_{ScanDirection::FORWARD};
 };
 
 }  // namespace bustub
@@ -0,0 +1,143 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_disk_manager.h
+//
+// Identification: src/include/storage/disk/async_disk_manager.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <future>  // NOLINT
+#include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <unordered_set>
+
+#include "common/config.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * Called with true once an asynchronous request completed successfully, with false if it failed. Callbacks run on the
+ * completion thread, they must not wait for other requests.
+ */
+using DiskCallback = std::function<void(bool)>;
+
+/**
+ * AsyncDiskManager issues page reads and writes to the database file of a DiskManager without blocking the caller,
+ * so that a single thread can keep many requests in flight. It is backed by an io_uring: requests are queued in the
+ * submission ring and handed to the kernel together by Submit, with a single system call. A completion thread reaps
+ * the finished requests and completes their futures and callbacks.
+ *
+ * A buffer pool instance owns one AsyncDiskManager, so the requests of an instance are batched together. Where
+ * io_uring is not available (old kernels, seccomp filters), requests are run synchronously when they are issued and
+ * their futures are ready right away, callers do not need to tell the two apart. The same goes for compressed
+ * database files, whose pages are not at fixed offsets, and for the requests once the ring failed.
+ */
+class AsyncDiskManager {
+ public:
+  /**
+   * Create a new AsyncDiskManager on top of a disk manager.
+   * @param disk_manager the disk manager whose database file is read and written
+   * @param queue_depth the maximum number of requests in flight
+   * @param use_io_uring false to always run requests synchronously
+   */
+  explicit AsyncDiskManager(DiskManager *disk_manager, size_t queue_depth = ASYNC_IO_QUEUE_DEPTH,
+                            bool use_io_uring = true);
+
+  /** Waits for all requests in flight and stops the completion thread. */
+  ~AsyncDiskManager();
+
+  AsyncDiskManager(const AsyncDiskManager &) = delete;
+  auto operator=(const AsyncDiskManager &) -> AsyncDiskManager & = delete;
+
+  /**
+   * Queue a read of a page. The request is only handed to the kernel by Submit, or once the queue is full.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer, which must stay valid until the request completed. The checksum of the
+   * page is verified, a corrupted page fails the read.
+   * @param callback called on the completion thread once the request completed, before the future is ready
+   * @return a future which is true once the page was read, false if the read failed
+   */
+  auto ReadPageAsync(page_id_t page_id, char *page_data, DiskCallback callback = nullptr) -> std::future<bool>;
+
+  /**
+   * Queue a write of a page. The request is only handed to the kernel by Submit, or once the queue is full.
+   * @param page_id id of the page
+   * @param page_data raw page data, it is copied and checksummed before the call returns
+   * @param callback called on the completion thread once the request completed, before the future is ready
+   * @return a future which is true once the page was written, false if the write failed
+   */
+  auto WritePageAsync(page_id_t page_id, const char *page_data, DiskCallback callback = nullptr) -> std::future<bool>;
+
+  /** Hand all queued requests to the kernel with a single system call. */
+  void Submit();
+
+  /** Submit the queued requests and wait until every request in flight completed. */
+  void Drain();
+
+  /** @return true if requests are run by an io_uring, false if they are run synchronously */
+  auto UsesIoUring() const -> bool { return ring_ != nullptr && !ring_failed_; }
+
+  /** Make the next num_failures submissions to the ring fail as if the kernel rejected them, for tests */
+  void InjectSubmitFailures(int num_failures) {
+    std::scoped_lock guard(latch_);
+    num_injected_failures_ = num_failures;
+  }
+
+  /** Make the next wait for completions fail as if the ring broke, for tests */
+  void InjectWaitFailure() {
+    std::scoped_lock guard(latch_);
+    inject_wait_failure_ = true;
+  }
+
+ private:
+  enum class RingOp { READ, WRITE, NOP };
+  struct Ring;
+  struct Request;
+
+  auto Enqueue(bool is_write, page_id_t page_id, char *page_data, DiskCallback callback) -> std::future<bool>;
+  /** Complete a request which ran synchronously */
+  static auto CompleteSynchronously(bool success, const DiskCallback &callback) -> std::future<bool>;
+  /** Push a request to the submission ring, latch_ must be held */
+  void PushRequest(std::unique_lock<std::mutex> *lock, Request *request);
+  /**
+   * Hand the queued requests to the kernel, latch_ must be held. If the kernel rejects them, the ring is not used any
+   * more and the queued requests run synchronously, with latch_ released meanwhile.
+   */
+  void SubmitLocked(std::unique_lock<std::mutex> *lock);
+  void CompletionLoop();
+  void Complete(Request *request, int result);
+
+  DiskManager *disk_manager_;
+  std::unique_ptr<Ring> ring_;
+  /** Set once the ring failed, new requests run synchronously from then on */
+  std::atomic<bool> ring_failed_{false};
+  std::thread completion_thread_;
+
+  /** latch_ protects the submission ring and the request counts */
+  std::mutex latch_;
+  std::condition_variable completed_cv_;
+  /** Requests pushed to the submission ring but not handed to the kernel yet, in ring order */
+  std::deque<Request *> queued_;
+  /** Requests handed to the kernel but not reaped yet, which are finished synchronously should the ring break */
+  std::unordered_set<Request *> submitted_;
+  /** Requests pushed to the submission ring but not completed yet, bounded by the queue depth */
+  size_t num_in_flight_{0};
+  /** Set by the destructor, the completion thread stops once it sees it */
+  bool stopping_{false};
+  int num_injected_failures_{0};
+  bool inject_wait_failure_{false};
+};
+
+}  // namespace bustub
@@ -0,0 +1,126 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_store.h
+//
+// Identification: src/include/storage/disk/compressed_page_store.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * CompressedPageStore keeps the pages of a database file LZ4 compressed, for a DiskManager opened with compression.
+ * Pages no longer sit at page_id * PAGE_SIZE: every write appends an extent holding the compressed page, and an
+ * in-memory map points each page id at its latest extent. The buffer pool still sees plain PAGE_SIZE pages.
+ *
+ * File layout:
+ *  ----------------------------------------------------------------
+ *  | FILE HEADER (16) | EXTENT | EXTENT | ... (8-byte aligned)     |
+ *  ----------------------------------------------------------------
+ *  File header format (size in bytes):
+ *  ----------------------------------------------
+ *  | Magic (8) | Version (4) | PageSize (4)     |
+ *  ----------------------------------------------
+ *  Extent format (size in bytes):
+ *  ---------------------------------------------------------------------------------------------
+ *  | Checksum (4) | Magic (4) | PageId (4) | DataSize (4) | Sequence (8) | Data (DataSize)      |
+ *  ---------------------------------------------------------------------------------------------
+ *
+ * The checksum is the CRC32C of the rest of the extent. The checksum trailer of a page is not stored, and pages which
+ * do not compress are stored as they are, with a DataSize of PAGE_SIZE - PAGE_CHECKSUM_SIZE.
+ *
+ * The map is not saved anywhere, opening the file rebuilds it by scanning the extents: the extent with the highest
+ * sequence number of a page wins. A torn append fails its checksum and is skipped, so the page reads as its previous
+ * version. Overwritten extents are dead space until the file is compacted offline.
+ */
+class CompressedPageStore {
+ public:
+  /** Size of the header starting a compressed database file */
+  static constexpr size_t FILE_HEADER_SIZE = 16;
+
+  /**
+   * @param fd file descriptor of a database file
+   * @return true if the file is a compressed database file
+   */
+  static auto IsCompressedFile(int fd) -> bool;
+
+  /**
+   * @param fd file descriptor of a compressed database file
+   * @return the page size the file was created with, 0 if the header cannot be read
+   */
+  static auto GetFilePageSize(int fd) -> size_t;
+
+  /**
+   * Open a compressed database file, an empty file is initialized with the file header.
+   * @param fd file descriptor of the database file, which stays owned by the caller
+   */
+  explicit CompressedPageStore(int fd);
+
+  /**
+   * Compress a page and append it to the file.
+   * @param page_id id of the page
+   * @param page_data raw page data, its checksum trailer is not stored
+   * @return false if the page could not be written
+   */
+  auto WritePage(page_id_t page_id, const char *page_data) -> bool;
+
+  /**
+   * Read the latest version of a page. A page which was never written reads as zeros.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer, the checksum trailer reads as zeros
+   * @return false if the page could not be read or is corrupted
+   */
+  auto ReadPage(page_id_t page_id, char *page_data) -> bool;
+
+  /** Forget a deallocated page, its extent becomes dead space. */
+  void DropPage(page_id_t page_id);
+
+  /** @return one past the highest page id stored */
+  auto GetNumPages() -> size_t;
+
+  /** @return the number of extents read whose checksum did not match */
+  auto GetNumChecksumFailures() const -> int { return num_checksum_failures_; }
+
+  /**
+   * Copy the latest extent of every page into a new, empty file, in page id order, and continue on that file. This
+   * is an offline operation.
+   * @param fd file descriptor of the new file, which stays owned by the caller
+   * @return false if the new file could not be written, the store stays on the old file then
+   */
+  auto Rewrite(int fd) -> bool;
+
+ private:
+  struct Extent {
+    off_t offset_{0};
+    uint32_t size_{0};
+    uint64_t sequence_{0};
+  };
+
+  /** Rebuild the map from the extents of the file */
+  void Scan();
+
+  int fd_;
+  /** latch_ protects the map and the end of the file */
+  std::mutex latch_;
+  std::unordered_map<page_id_t, Extent> extents_;
+  off_t end_{FILE_HEADER_SIZE};
+  uint64_t next_sequence_{1};
+  std::atomic<int> num_checksum_failures_{0};
+};
+
+}  // namespace bustub
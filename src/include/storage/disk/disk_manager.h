@@ -12,48 +12,120 @@
 
 #pragma once
 
+#include <sys/types.h>
+
 #include <atomic>
 #include <fstream>
+#include <functional>
 #include <future>  // NOLINT
-#include <mutex>   // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <set>
 #include <string>
 
 #include "common/config.h"
+#include "storage/disk/compressed_page_store.h"
 
 namespace bustub {
 
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * Pages are read and written with pread/pwrite on a file descriptor. There is no shared file cursor, so requests from
+ * different threads, e.g. the instances of a parallel buffer pool manager, run in parallel without a latch. The log
+ * file is written sequentially by a single thread and stays a stream.
+ *
+ * Every page ends with a CRC32C checksum of the rest of the page, stamped when the page is written and verified when
+ * it is read, so that a torn or otherwise corrupted page is caught when it is read instead of being interpreted as
+ * tuples. Page layouts must leave the last PAGE_CHECKSUM_SIZE bytes alone; they read as zeros.
+ *
+ * A database file can be kept compressed, see CompressedPageStore. Whether a file is compressed is decided when it is
+ * created, a file opened again keeps its format.
+ *
+ * Deallocated pages are kept in a free-page map and handed out again before the file grows. The map is saved next
+ * to the database file on shut down and removed when it is loaded: after a crash the free pages leak, but a page is
+ * never handed out twice.
  */
 class DiskManager {
  public:
+  /** Alignment O_DIRECT requires of buffers, file offsets and sizes */
+  static constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param direct_io open the database file with O_DIRECT, bypassing the page cache. Falls back to buffered I/O if
+   * the file system does not support it. Pages which are not aligned in memory go through a bounce buffer.
+   * @param compress create the database file LZ4 compressed if it does not exist yet. Compressed files are always
+   * accessed through the page cache, direct_io is ignored for them.
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, bool direct_io = false, bool compress = false);
 
   ~DiskManager() = default;
 
   /**
-   * Shut down the disk manager and close all the file resources.
+   * Shut down the disk manager and close all the file resources. The free-page map is saved next to the database
+   * file, to be picked up when it is opened again.
    */
   void ShutDown();
 
   /**
-   * Write a page to the database file.
+   * Write a page to the database file. The page is checksummed as it is copied, it may change while it is written.
    * @param page_id id of the page
    * @param page_data raw page data
    */
   void WritePage(page_id_t page_id, const char *page_data);
 
   /**
-   * Read a page from the database file.
+   * Read a page from the database file and verify its checksum. A page which was never written reads as zeros.
    * @param page_id id of the page
    * @param[out] page_data output buffer
+   * @return false if the page could not be read or is corrupted, the contents of the buffer are undefined then
+   */
+  auto ReadPage(page_id_t page_id, char *page_data) -> bool;
+
+  /**
+   * Read a run of consecutive pages from the database file with a single request and verify their checksums.
+   * @param first_page_id id of the first page
+   * @param num_pages number of pages to read
+   * @param[out] page_data output buffers, one per page
+   * @return false if the run could not be read or a page of it is corrupted
+   */
+  auto ReadPages(page_id_t first_page_id, size_t num_pages, char **page_data) -> bool;
+
+  /**
+   * Hand out a deallocated page for reuse.
+   * @param usable tells whether the caller can use a page id, e.g. whether it routes to its buffer pool instance
+   * @return the lowest usable deallocated page id, INVALID_PAGE_ID if there is none
+   */
+  auto AllocateFreePage(const std::function<bool(page_id_t)> &usable) -> page_id_t;
+
+  /**
+   * Return a page to the free-page map, so that its space is reused by a later allocation.
+   * @param page_id id of the page, which must not be in use anymore
+   */
+  void DeallocatePage(page_id_t page_id);
+
+  /** @return the number of deallocated pages waiting to be reused */
+  auto GetNumFreePages() const -> size_t { return num_free_pages_; }
+
+  /** @return the size of the database file in pages, one past the highest page stored if it is compressed */
+  auto GetNumPages() -> size_t;
+
+  /**
+   * Shrink the database file. This is an offline operation, no buffer pool may be using the file.
+   *
+   * Free pages at the end of the file are cut off. If relocate is given, the live pages at the end of the file are
+   * moved into the free pages closest to its start as well, and relocate is called for each of them so that the
+   * references to the page can be rewritten; the file is then truncated after its last live page.
+   *
+   * A compressed file is rewritten instead, with only the latest extent of every live page. Free pages take no space
+   * in it, so relocate is never called.
+   * @param relocate called with the old and the new id of every page moved, nullptr to only cut off free pages
+   * @return the number of pages the file shrank by
    */
-  void ReadPage(page_id_t page_id, char *page_data);
+  auto Compact(const std::function<void(page_id_t, page_id_t)> &relocate = nullptr) -> size_t;
 
   /**
    * Flush the entire log buffer into disk.
@@ -80,6 +152,27 @@ class DiskManager {
   /** @return the number of disk writes */
   auto GetNumWrites() const -> int;
 
+  /** @return the number of read requests, a run of pages read by ReadPages counts once */
+  auto GetNumReads() const -> int;
+
+  /**
+   * Check the checksum trailer of a page as stored on disk.
+   * @param page_data raw page data, including the trailer
+   * @return true if the checksum matches, or the page was never written and is all zeros
+   */
+  static auto ChecksumMatches(const char *page_data) -> bool;
+
+  /** @return the number of pages read whose checksum did not match */
+  auto GetNumChecksumFailures() const -> int {
+    return num_checksum_failures_ + (compressed_store_ != nullptr ? compressed_store_->GetNumChecksumFailures() : 0);
+  }
+
+  /** @return true if the database file is accessed with O_DIRECT */
+  auto UsesDirectIO() const -> bool { return direct_io_; }
+
+  /** @return true if the database file is compressed */
+  auto UsesCompression() const -> bool { return compressed_store_ != nullptr; }
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -90,19 +183,39 @@ class DiskManager {
   inline auto HasFlushLogFuture() -> bool { return flush_log_f_ != nullptr; }
 
  private:
+  friend class AsyncDiskManager;
+
   auto GetFileSize(const std::string &file_name) -> int;
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  auto ReadAt(char *data, size_t size, off_t offset) -> bool;
+  auto WriteAt(const char *data, size_t size, off_t offset) -> bool;
+  auto ReadVectored(off_t offset, size_t num_pages, char **page_data) -> bool;
+  auto CompactCompressed() -> size_t;
+  // stamp the checksum trailer of a page about to be written
+  static void StampChecksum(char *page_data);
+  // verify the checksum trailer of a page just read and clear it
+  auto VerifyChecksum(page_id_t page_id, char *page_data) -> bool;
+  // file descriptor of the db file, -1 once shut down
+  int db_fd_{-1};
+  bool direct_io_{false};
+  // pages of a compressed db file, nullptr if it is not compressed
+  std::unique_ptr<CompressedPageStore> compressed_store_;
   std::string file_name_;
+  void LoadFreePages();
+  void SaveFreePages();
+  // free-page map, persisted in its own file between runs
+  std::string free_name_;
+  std::mutex free_latch_;
+  std::set<page_id_t> free_pages_;
+  std::atomic<size_t> num_free_pages_{0};
   int num_flushes_{0};
-  int num_writes_{0};
+  std::atomic<int> num_writes_{0};
+  std::atomic<int> num_reads_{0};
+  std::atomic<int> num_checksum_failures_{0};
   bool flush_log_{false};
   std::future<void> *flush_log_f_{nullptr};
-  // With multiple buffer pool instances, need to protect file access
-  std::mutex db_io_latch_;
 };
 
 }  // namespace bustub
@@ -10,10 +10,13 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <functional>
+#include <mutex>  // NOLINT
 #include <queue>
 #include <string>
 #include <vector>
 
+#include "common/rwlatch.h"
 #include "concurrency/transaction.h"
 #include "storage/index/index_iterator.h"
 #include "storage/page/b_plus_tree_internal_page.h"
@@ -32,6 +35,19 @@ namespace bustub {
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
+ *
+ * The tree is safe to use from many threads at once, through latch crabbing: a thread latches a child page before
+ * it releases the parent. Readers crab down with read latches. Writers first try optimistically: they crab down with
+ * read latches and only write latch the leaf. If the leaf would split or underflow, they start over and crab down
+ * with write latches, holding on to every ancestor which the change could reach. root_latch_ guards the root page
+ * id the same way.
+ *
+ * Pages do not store the id of their parent, which would have to be rewritten on every split and merge. A writer
+ * finds the parent of a page among the pages it keeps latched instead, in the page set of its transaction.
+ *
+ * Keys take as many bytes in a page as they need, see b_plus_tree_page.h, so pages fill up by bytes as well as by
+ * entries. When a leaf splits, the key pushed up is the shortest one separating the two leaves, and leaves may store
+ * the prefix their keys share only once.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
@@ -40,7 +56,8 @@ class BPlusTree {
 
  public:
   explicit BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE - 1,
+                     page_id_t header_page_id = HEADER_PAGE_ID, bool compress_key_prefix = true);
 
   // Returns true if this B+ tree has no keys and values.
   auto IsEmpty() const -> bool;
@@ -54,6 +71,17 @@ class BPlusTree {
   // return the value associated with a given key
   auto GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction = nullptr) -> bool;
 
+  /**
+   * Build an empty tree bottom-up from key & value pairs sorted by key. Pages are packed left to right and written
+   * once each, rather than splitting their way up with one insertion per pair. Of pairs with equal keys, only the
+   * first is kept.
+   * @param next produces the next pair in key order, returns false once there are none left
+   * @param fill_factor fraction of each page to fill, the rest is room for later insertions. Pages are filled to at
+   * least their min size.
+   * @return false if the tree is not empty, nothing is loaded then
+   */
+  auto BulkLoad(const std::function<bool(MappingType *)> &next, double fill_factor = BULK_LOAD_FILL_FACTOR) -> bool;
+
   // index iterator
   auto Begin() -> INDEXITERATOR_TYPE;
   auto Begin(const KeyType &key) -> INDEXITERATOR_TYPE;
@@ -71,33 +99,68 @@ class BPlusTree {
   // read data from file and remove one by one
   void RemoveFromFile(const std::string &file_name, Transaction *transaction = nullptr);
   // expose for test purpose
-  auto FindLeafPage(const KeyType &key, bool leftMost = false) -> Page *;
+  auto FindLeafPage(const KeyType &key, bool leftMost = false) -> ReadPageGuard;
 
  private:
+  /** The operations a writer crabs down the tree for */
+  enum class Operation { INSERT, REMOVE };
+
   void StartNewTree(const KeyType &key, const ValueType &value);
 
-  auto InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr) -> bool;
+  auto InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction) -> bool;
 
   void InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
-                        Transaction *transaction = nullptr);
+                        Transaction *transaction);
 
   template <typename N>
-  auto Split(N *node) -> N *;
+  auto Split(N *node, Transaction *transaction) -> N *;
 
   template <typename N>
-  auto CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr) -> bool;
+  auto CoalesceOrRedistribute(N *node, Transaction *transaction) -> bool;
 
   template <typename N>
   auto Coalesce(N **neighbor_node, N **node, BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> **parent,
-                int index, Transaction *transaction = nullptr) -> bool;
+                int index, Transaction *transaction) -> bool;
 
   template <typename N>
-  void Redistribute(N *neighbor_node, N *node, int index);
+  void Redistribute(N *neighbor_node, N *node, InternalPage *parent, int index, Transaction *transaction);
 
   auto AdjustRoot(BPlusTreePage *node) -> bool;
 
   void UpdateRootPageId(int insert_record = 0);
 
+  /**
+   * Crab down to the leaf holding a key with read latches, and write latch the leaf.
+   * @param[out] is_root set to true if the leaf is the root page
+   * @return the write latched leaf, an empty guard if the tree is empty
+   */
+  auto FindLeafOptimistic(const KeyType &key, bool *is_root) -> WritePageGuard;
+
+  /**
+   * Crab down to the leaf holding a key with write latches. The pages which the operation could change stay latched
+   * in the page set of the transaction, root first and the leaf last. The root latch must be write locked, with a
+   * nullptr in the page set standing for it.
+   */
+  void FindLeafPessimistic(const KeyType &key, Operation operation, Transaction *transaction);
+
+  /** @return true if the operation cannot split or underflow the page, so that its ancestors can be released */
+  auto IsSafe(const BPlusTreePage *node, Operation operation, bool is_root) const -> bool;
+
+  /**
+   * @return the shortest key greater than left and at most right, which separates the leaves they end and start. Only
+   * the variable-length data of right is cut short, so that its columns stay readable.
+   */
+  auto ShortestSeparator(const KeyType &left, const KeyType &right) const -> KeyType;
+
+  /** @return the write latched parent of a page from the page set, nullptr if the page is the root */
+  auto FindParentPage(page_id_t page_id, Transaction *transaction) const -> Page *;
+
+  /** Create a new page, write latched and added to the page set of the transaction */
+  auto NewNodePage(page_id_t *page_id, Transaction *transaction) -> Page *;
+
+  /** Release the latches and pins of the page set and delete the pages of the deleted page set */
+  void ReleasePageSet(Transaction *transaction, bool is_dirty);
+
   /* Debug Routines for FREE!! */
   void ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstream &out) const;
 
@@ -110,6 +173,15 @@ class BPlusTree {
   KeyComparator comparator_;
   int leaf_max_size_;
   int internal_max_size_;
+  /** Whether leaves store the prefix their keys share only once */
+  bool compress_key_prefix_;
+  /** The page holding the root page id of the tree, with those of other trees */
+  page_id_t header_page_id_;
+  /** root_latch_ protects root_page_id_ */
+  mutable ReaderWriterLatch root_latch_;
+  /** Pages merged away while an iterator still had them pinned, deleted once they are unpinned */
+  std::mutex garbage_latch_;
+  std::vector<page_id_t> garbage_pages_;
 };
 
 }  // namespace bustub
@@ -11,6 +11,7 @@
 
 #pragma once
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -34,6 +35,20 @@ class BPlusTreeIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  /** Walk the leaves holding the range only, starting from the leaf of its lower bound */
+  void ScanRange(const Tuple *low, bool low_inclusive, const Tuple *high, bool high_inclusive, ScanDirection direction,
+                 std::vector<RID> *result, Transaction *transaction) override;
+
+  /**
+   * Fill the index with entries, such as those of the table it is created on. An empty index is bulk loaded: the
+   * entries are sorted externally and packed into the tree bottom-up. Otherwise they are inserted one by one.
+   * @param next produces the next key and record id, returns false once there are none left
+   * @param transaction the transaction filling the index
+   * @param fill_factor fraction of each page a bulk load fills
+   */
+  void BulkLoad(const std::function<bool(Tuple *key, RID *rid)> &next, Transaction *transaction,
+                double fill_factor = BULK_LOAD_FILL_FACTOR);
+
   auto GetBeginIterator() -> INDEXITERATOR_TYPE;
 
   auto GetBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE;
@@ -43,6 +58,8 @@ class BPlusTreeIndex : public Index {
  protected:
   // comparator for key
   KeyComparator comparator_;
+  // page of the root page id of the tree, each index gets its own
+  page_id_t header_page_id_;
   // container
   BPlusTree<KeyType, ValueType, KeyComparator> container_;
 };
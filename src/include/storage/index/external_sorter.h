@@ -0,0 +1,181 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_sorter.h
+//
+// Identification: src/include/storage/index/external_sorter.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "common/exception.h"
+
+namespace bustub {
+
+/**
+ * ExternalSorter sorts more items than fit in memory, such as the entries of an index being bulk loaded. Items are
+ * collected into runs of run_bytes, and each full run is sorted and spilled to a temporary file. Reading the items
+ * back merges the runs, holding only a small buffer of each in memory. Items which fit into a single run are sorted
+ * in memory and never touch the disk.
+ *
+ * The sort is stable. Items are spilled as raw bytes, so they must be plain data such as keys and record ids.
+ */
+template <typename T, typename Compare>
+class ExternalSorter {
+ public:
+  /**
+   * @param compare strict weak ordering of the items
+   * @param run_bytes memory used to sort a run, each run is spilled once this is full
+   */
+  explicit ExternalSorter(Compare compare, size_t run_bytes = EXTERNAL_SORT_RUN_BYTES)
+      : compare_(std::move(compare)), run_size_(std::max<size_t>(run_bytes / sizeof(T), 1)) {}
+
+  ExternalSorter(const ExternalSorter &) = delete;
+  auto operator=(const ExternalSorter &) -> ExternalSorter & = delete;
+
+  ~ExternalSorter() {
+    if (file_ != nullptr) {
+      fclose(file_);
+    }
+  }
+
+  /** Add an item. Items cannot be added once Sort was called. */
+  void Add(const T &item) {
+    buffer_.push_back(item);
+    if (buffer_.size() == run_size_) {
+      SpillRun();
+    }
+  }
+
+  /** Sort the items added, so that Next returns them in order. */
+  void Sort() {
+    if (runs_.empty()) {
+      std::stable_sort(buffer_.begin(), buffer_.end(), compare_);
+      return;
+    }
+    if (!buffer_.empty()) {
+      SpillRun();
+    }
+    buffer_.clear();
+    buffer_.shrink_to_fit();
+    for (size_t i = 0; i < runs_.size(); i++) {
+      if (Refill(&runs_[i])) {
+        heap_.push_back(i);
+        std::push_heap(heap_.begin(), heap_.end(), [this](size_t a, size_t b) { return RunGreater(a, b); });
+      }
+    }
+  }
+
+  /**
+   * @param[out] item the next item in sorted order
+   * @return false if all the items were returned
+   */
+  auto Next(T *item) -> bool {
+    if (runs_.empty()) {
+      if (next_ == buffer_.size()) {
+        return false;
+      }
+      *item = buffer_[next_++];
+      return true;
+    }
+    if (heap_.empty()) {
+      return false;
+    }
+    auto greater = [this](size_t a, size_t b) { return RunGreater(a, b); };
+    std::pop_heap(heap_.begin(), heap_.end(), greater);
+    auto &run = runs_[heap_.back()];
+    *item = run.buffer_[run.next_++];
+    if (run.next_ < run.buffer_.size() || Refill(&run)) {
+      std::push_heap(heap_.begin(), heap_.end(), greater);
+    } else {
+      heap_.pop_back();
+    }
+    return true;
+  }
+
+  /** @return the number of runs spilled to disk, 0 if the items were sorted in memory */
+  auto GetNumRuns() const -> size_t { return runs_.size(); }
+
+ private:
+  /** Size of the buffer each run is read back through while merging */
+  static constexpr size_t MERGE_BUFFER_BYTES = 64 * 1024;
+
+  /** A sorted run in the temporary file, and the part of it read back */
+  struct Run {
+    off_t offset_{0};
+    size_t remaining_{0};
+    std::vector<T> buffer_;
+    size_t next_{0};
+  };
+
+  void SpillRun() {
+    if (file_ == nullptr && (file_ = tmpfile()) == nullptr) {
+      throw Exception("cannot create a temporary file to sort into");
+    }
+    std::stable_sort(buffer_.begin(), buffer_.end(), compare_);
+    Run run;
+    run.offset_ = end_;
+    run.remaining_ = buffer_.size();
+    auto bytes = buffer_.size() * sizeof(T);
+    if (pwrite(fileno(file_), buffer_.data(), bytes, end_) != static_cast<ssize_t>(bytes)) {
+      throw Exception("cannot write a sorted run to the temporary file");
+    }
+    end_ += bytes;
+    runs_.push_back(std::move(run));
+    buffer_.clear();
+  }
+
+  /** Read the next part of a run, @return false if the run is exhausted */
+  auto Refill(Run *run) -> bool {
+    if (run->remaining_ == 0) {
+      run->buffer_.clear();
+      run->buffer_.shrink_to_fit();
+      return false;
+    }
+    auto count = std::min(run->remaining_, std::max<size_t>(MERGE_BUFFER_BYTES / sizeof(T), 1));
+    run->buffer_.resize(count);
+    auto bytes = count * sizeof(T);
+    if (pread(fileno(file_), run->buffer_.data(), bytes, run->offset_) != static_cast<ssize_t>(bytes)) {
+      throw Exception("cannot read a sorted run from the temporary file");
+    }
+    run->offset_ += bytes;
+    run->remaining_ -= count;
+    run->next_ = 0;
+    return true;
+  }
+
+  /** Order of the runs in the merge heap, by their next item and then by run, which keeps the merge stable */
+  auto RunGreater(size_t a, size_t b) const -> bool {
+    const auto &item_a = runs_[a].buffer_[runs_[a].next_];
+    const auto &item_b = runs_[b].buffer_[runs_[b].next_];
+    if (compare_(item_b, item_a)) {
+      return true;
+    }
+    return !compare_(item_a, item_b) && a > b;
+  }
+
+  Compare compare_;
+  size_t run_size_;
+  /** Items of the run being collected, or all the items if they fit into a single run */
+  std::vector<T> buffer_;
+  size_t next_{0};
+  FILE *file_{nullptr};
+  off_t end_{0};
+  std::vector<Run> runs_;
+  /** Heap of the runs which have items left, the run with the smallest next item on top */
+  std::vector<size_t> heap_;
+};
+
+}  // namespace bustub
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstring>
 
 #include "storage/table/tuple.h"
@@ -94,13 +95,53 @@ class GenericComparator {
     return 0;
   }
 
-  GenericComparator(const GenericComparator &other) : key_schema_{other.key_schema_} {}
+  /**
+   * @return the bytes of a key which a key cut short from it must keep to stay readable: the inlined columns and the
+   * lengths of the variable-length ones
+   */
+  inline auto GetMinPrefixSize(const GenericKey<KeySize> &key) const -> uint32_t {
+    uint32_t size = key_schema_->GetLength();
+    for (uint32_t column_idx : key_schema_->GetUnlinedColumns()) {
+      uint32_t offset;
+      memcpy(&offset, key.data_ + key_schema_->GetColumn(column_idx).GetOffset(), sizeof(offset));
+      size = std::max<uint32_t>(size, offset + sizeof(uint32_t));
+    }
+    return std::min<uint32_t>(size, KeySize);
+  }
+
+  /**
+   * @return the size of the integer if the key is a single integer column, 0 otherwise. Such keys order like the
+   * little-endian integer stored at their start, so they can be compared without deserializing them. A null key is
+   * the smallest integer and orders first.
+   */
+  inline auto GetIntegerKeySize() const -> int { return integer_key_size_; }
+
+  GenericComparator(const GenericComparator &other)
+      : key_schema_{other.key_schema_}, integer_key_size_{other.integer_key_size_} {}
 
   // constructor
-  explicit GenericComparator(Schema *key_schema) : key_schema_(key_schema) {}
+  explicit GenericComparator(Schema *key_schema)
+      : key_schema_(key_schema), integer_key_size_(IntegerKeySize(key_schema)) {}
 
  private:
+  static auto IntegerKeySize(const Schema *key_schema) -> int {
+    if (key_schema->GetColumnCount() != 1) {
+      return 0;
+    }
+    const auto &column = key_schema->GetColumn(0);
+    switch (column.GetType()) {
+      case TypeId::TINYINT:
+      case TypeId::SMALLINT:
+      case TypeId::INTEGER:
+      case TypeId::BIGINT:
+        return column.GetFixedLength() <= KeySize ? static_cast<int>(column.GetFixedLength()) : 0;
+      default:
+        return 0;
+    }
+  }
+
   Schema *key_schema_;
+  int integer_key_size_;
 };
 
 }  // namespace bustub
@@ -18,6 +18,7 @@
 #include <vector>
 
 #include "catalog/schema.h"
+#include "common/exception.h"
 #include "storage/table/tuple.h"
 #include "type/value.h"
 
@@ -25,6 +26,9 @@ namespace bustub {
 
 class Transaction;
 
+/** The order a range scan returns the entries of an index in */
+enum class ScanDirection { FORWARD, BACKWARD };
+
 /**
  * class IndexMetadata - Holds metadata of an index object.
  *
@@ -175,6 +179,21 @@ class Index {
    */
   virtual void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) = 0;
 
+  /**
+   * Search the index for the keys in a range. Only ordered indexes support range scans.
+   * @param low The lowest key of the range, nullptr if the range has no lower bound
+   * @param low_inclusive Whether the range includes low
+   * @param high The highest key of the range, nullptr if the range has no upper bound
+   * @param high_inclusive Whether the range includes high
+   * @param direction Whether the RIDs are returned in ascending or descending key order
+   * @param result The collection of RIDs that is populated with results of the search
+   * @param transaction The transaction context
+   */
+  virtual void ScanRange(const Tuple *low, bool low_inclusive, const Tuple *high, bool high_inclusive,
+                         ScanDirection direction, std::vector<RID> *result, Transaction *transaction) {
+    throw NotImplementedException("the index does not support range scans");
+  }
+
  private:
   /** The Index structure owns its metadata */
   std::unique_ptr<IndexMetadata> metadata_;
@@ -13,17 +13,36 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include "buffer/buffer_pool_manager.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
 
 namespace bustub {
 
 #define INDEXITERATOR_TYPE IndexIterator<KeyType, ValueType, KeyComparator>
 
+/**
+ * IndexIterator walks the leaves of a B+ tree in key order. It holds the read latch of the leaf it is on, so that
+ * writers to that leaf wait until the iterator moves on, but it is not isolated from the changes made to the tree
+ * before and after. Moving to the next leaf releases the current one before latching the next, which keeps the
+ * iterator out of latch cycles with writers merging leaves. The leaves after the current one are read ahead.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+
  public:
-  // you may define your own constructor based on your member variables
-  IndexIterator();
+  /** Create an end iterator */
+  IndexIterator() = default;
+
+  /**
+   * @param bpm the buffer pool manager of the tree
+   * @param guard the read latched leaf to start from, an empty guard for an end iterator
+   * @param index the position in the leaf to start from
+   */
+  IndexIterator(BufferPoolManager *bpm, ReadPageGuard guard, int index);
+
+  IndexIterator(IndexIterator &&that) noexcept = default;
+  auto operator=(IndexIterator &&that) noexcept -> IndexIterator & = default;
   ~IndexIterator();  // NOLINT
 
   auto IsEnd() -> bool;
@@ -32,12 +51,26 @@ class IndexIterator {
 
   auto operator++() -> IndexIterator &;
 
-  auto operator==(const IndexIterator &itr) const -> bool { throw std::runtime_error("unimplemented"); }
+  auto operator==(const IndexIterator &itr) const -> bool {
+    return GetPageId() == itr.GetPageId() && index_ == itr.index_;
+  }
 
-  auto operator!=(const IndexIterator &itr) const -> bool { throw std::runtime_error("unimplemented"); }
+  auto operator!=(const IndexIterator &itr) const -> bool { return !(*this == itr); }
 
  private:
-  // add your own private member variables here
+  auto GetPageId() const -> page_id_t { return guard_ ? guard_.PageId() : INVALID_PAGE_ID; }
+
+  /** Move on to the following leaves while the position is past the end of the current one */
+  void SkipToValidPosition();
+
+  /** Read ahead the leaves after the current one */
+  void PrefetchNextLeaves();
+
+  BufferPoolManager *bpm_{nullptr};
+  ReadPageGuard guard_;
+  int index_{0};
+  /** The entry last dereferenced, which is read out of the leaf since the leaf does not store it as a pair */
+  MappingType item_;
 };
 
 }  // namespace bustub
@@ -17,8 +17,8 @@
 namespace bustub {
 
 #define B_PLUS_TREE_INTERNAL_PAGE_TYPE BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>
-#define INTERNAL_PAGE_HEADER_SIZE 24
-#define INTERNAL_PAGE_SIZE ((PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(MappingType)))
+#define INTERNAL_PAGE_SIZE \
+  ((PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE - PAGE_CHECKSUM_SIZE) / (B_PLUS_TREE_SLOT_SIZE + sizeof(page_id_t)))
 /**
  * Store n indexed keys and n+1 child pointers (page_id) within internal page.
  * Pointer PAGE_ID(i) points to a subtree in which all keys K satisfy:
@@ -27,16 +27,23 @@ namespace bustub {
  * the first key always remains invalid. That is to say, any search/lookup
  * should ignore the first key.
  *
+ * The entries are cells of the slotted layout described in b_plus_tree_page.h. INTERNAL_PAGE_SIZE is the most
+ * children an internal page has room for, so by default internal pages split once they run out of bytes. The tree
+ * keeps the keys short by choosing the shortest separators it can when leaves split.
+ *
+ * An internal page splits once it holds more than max_size children, so it has room for INTERNAL_PAGE_SIZE - 1
+ * children plus the one which overflows it.
+ *
  * Internal page format (keys are stored in increasing order):
- *  --------------------------------------------------------------------------
- * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
- *  --------------------------------------------------------------------------
+ *  ---------------------------------------------------------------------------------------------
+ * | HEADER | SLOT(1) | ... | SLOT(n) | free space | PAGE_ID(n)+KEY(n) | ... | PAGE_ID(1)+KEY(1) |
+ *  ---------------------------------------------------------------------------------------------
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeInternalPage : public BPlusTreePage {
  public:
   // must call initialize method after "create" a new node
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = INTERNAL_PAGE_SIZE);
+  void Init(page_id_t page_id, int max_size = INTERNAL_PAGE_SIZE - 1);
 
   auto KeyAt(int index) const -> KeyType;
   void SetKeyAt(int index, const KeyType &key);
@@ -50,18 +57,15 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   auto RemoveAndReturnOnlyChild() -> ValueType;
 
   // Split and Merge utility methods
-  void MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key, BufferPoolManager *buffer_pool_manager);
-  void MoveHalfTo(BPlusTreeInternalPage *recipient, BufferPoolManager *buffer_pool_manager);
-  void MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                        BufferPoolManager *buffer_pool_manager);
-  void MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                         BufferPoolManager *buffer_pool_manager);
+  void MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key);
+  void MoveHalfTo(BPlusTreeInternalPage *recipient);
+  void MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key);
+  void MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key);
+
+  // Append entries, also used to pack pages when bulk loading
+  void CopyNFrom(const MappingType *items, int size);
 
- private:
-  void CopyNFrom(MappingType *items, int size, BufferPoolManager *buffer_pool_manager);
-  void CopyLastFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager);
-  void CopyFirstFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager);
-  // Flexible array member for page data.
-  MappingType array_[1];
+  /** Size of the largest entry of an internal page, with its slot */
+  static constexpr int MAX_ENTRY_SIZE = B_PLUS_TREE_SLOT_SIZE + sizeof(ValueType) + sizeof(KeyType);
 };
 }  // namespace bustub
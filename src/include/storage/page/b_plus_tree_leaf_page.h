@@ -18,39 +18,49 @@
 namespace bustub {
 
 #define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>
-#define LEAF_PAGE_HEADER_SIZE 28
-#define LEAF_PAGE_SIZE ((PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
+#define LEAF_PAGE_SIZE \
+  ((PAGE_SIZE - LEAF_PAGE_HEADER_SIZE - PAGE_CHECKSUM_SIZE) / (B_PLUS_TREE_SLOT_SIZE + sizeof(ValueType)))
 
 /**
  * Store indexed key and record id(record id = page id combined with slot id,
  * see include/common/rid.h for detailed implementation) together within leaf
  * page. Only support unique key.
  *
+ * The entries are cells of the slotted layout described in b_plus_tree_page.h, a leaf may compress the prefix its
+ * keys share. LEAF_PAGE_SIZE is the most entries a leaf has room for, so by default leaves split once they run out of
+ * bytes.
+ *
  * Leaf page format (keys are stored in order):
- *  ----------------------------------------------------------------------
- * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
- *  ----------------------------------------------------------------------
+ *  -------------------------------------------------------------------------------------
+ * | HEADER | SLOT(1) | ... | SLOT(n) | free space | RID(n) + KEY(n) | ... | RID(1) + KEY(1) | KEY PREFIX |
+ *  -------------------------------------------------------------------------------------
  *
- *  Header format (size in byte, 28 bytes in total):
+ *  Header format (size in byte, 36 bytes in total):
  *  ---------------------------------------------------------------------
  * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
  *  ---------------------------------------------------------------------
- *  -----------------------------------------------
- * | ParentPageId (4) | PageId (4) | NextPageId (4)
- *  -----------------------------------------------
+ *  -------------------------------------------------------------------------------
+ * | PageId (4) | CellsBegin (2) | DeadBytes (2) | KeyPrefixSize (2) | MaxEntrySize (2) |
+ *  -------------------------------------------------------------------------------
+ *  ------------------------------
+ * | Flags (4) | NextPageId (4) |
+ *  ------------------------------
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeLeafPage : public BPlusTreePage {
  public:
   // After creating a new leaf page from buffer pool, must call initialize
   // method to set default values
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = LEAF_PAGE_SIZE);
+  void Init(page_id_t page_id, int max_size = LEAF_PAGE_SIZE, bool compress_key_prefix = false);
   // helper methods
   auto GetNextPageId() const -> page_id_t;
   void SetNextPageId(page_id_t next_page_id);
   auto KeyAt(int index) const -> KeyType;
   auto KeyIndex(const KeyType &key, const KeyComparator &comparator) const -> int;
-  auto GetItem(int index) -> const MappingType &;
+  auto GetItem(int index) const -> MappingType;
+
+  /** @return the offset of the next page id within the page, for reading ahead the leaves of a scan */
+  static constexpr auto GetNextPageIdOffset() -> size_t { return LEAF_PAGE_HEADER_SIZE - sizeof(page_id_t); }
 
   // insert and delete methods
   auto Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator) -> int;
@@ -63,12 +73,13 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   void MoveFirstToEndOf(BPlusTreeLeafPage *recipient);
   void MoveLastToFrontOf(BPlusTreeLeafPage *recipient);
 
+  // Append entries, also used to pack pages when bulk loading
+  void CopyNFrom(const MappingType *items, int size);
+
+  /** Size of the largest entry of a leaf, with its slot */
+  static constexpr int MAX_ENTRY_SIZE = B_PLUS_TREE_SLOT_SIZE + sizeof(ValueType) + sizeof(KeyType);
+
  private:
-  void CopyNFrom(MappingType *items, int size);
-  void CopyLastFrom(const MappingType &item);
-  void CopyFirstFrom(const MappingType &item);
   page_id_t next_page_id_;
-  // Flexible array member for page data.
-  MappingType array_[1];
 };
 }  // namespace bustub
@@ -13,7 +13,12 @@
 #include <cassert>
 #include <climits>
 #include <cstdlib>
+#include <cstring>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "storage/index/generic_key.h"
@@ -24,7 +29,10 @@ namespace bustub {
 
 #define INDEX_TEMPLATE_ARGUMENTS template <typename KeyType, typename ValueType, typename KeyComparator>
 
-// define page type enum
+#define LEAF_PAGE_HEADER_SIZE 36
+#define INTERNAL_PAGE_HEADER_SIZE 32
+#define B_PLUS_TREE_SLOT_SIZE 4
+
 enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE };
 
 /**
@@ -33,43 +41,248 @@ enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE };
  * It actually serves as a header part for each B+ tree page and
  * contains information shared by both leaf page and internal page.
  *
- * Header format (size in byte, 24 bytes in total):
+ * Pages do not point to their parent: keeping parent pointers up to date would mean latching and rewriting every child
+ * moved by a split or merge. The tree finds the parent of a page on the path it latched down to it instead.
+ *
+ * Entries are stored in variable-length cells, so that short keys take less room than the KeyType they are read back
+ * into. Slots grow forwards from the header in key order, each holding the offset and size of a cell, and the cells
+ * grow backwards from the end of the page:
+ *  ------------------------------------------------------------------------------------------
+ * | HEADER | SLOT(0) | ... | SLOT(n-1) | free space | CELL | ... | CELL | KEY PREFIX | (checksum)
+ *  ------------------------------------------------------------------------------------------
+ * A cell holds the value followed by the key without its trailing zero bytes. A page compressing key prefixes stores
+ * the prefix its keys share once, the slots of the keys starting with it are flagged, and their cells hold only the
+ * rest of the key. A removed cell is dead space until a new cell does not fit otherwise, then the page is compacted.
+ *
+ * A page splits once it holds more than its max size entries, leaves at most max size - 1 of them, or once it may not
+ * have room for another entry of MaxEntrySize bytes. It underflows once it holds fewer than its min size entries and
+ * less than half of its capacity in bytes.
+ *
+ * Header format (size in byte, 32 bytes in total):
  * ----------------------------------------------------------------------------
- * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
+ * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) | PageId(4) |
  * ----------------------------------------------------------------------------
- * | ParentPageId (4) | PageId(4) |
+ * | CellsBegin (2) | DeadBytes (2) | KeyPrefixSize (2) | MaxEntrySize (2) | Flags (4) |
  * ----------------------------------------------------------------------------
  */
 class BPlusTreePage {
  public:
   auto IsLeafPage() const -> bool;
-  auto IsRootPage() const -> bool;
   void SetPageType(IndexPageType page_type);
 
   auto GetSize() const -> int;
-  void SetSize(int size);
-  void IncreaseSize(int amount);
 
   auto GetMaxSize() const -> int;
   void SetMaxSize(int max_size);
   auto GetMinSize() const -> int;
 
-  auto GetParentPageId() const -> page_id_t;
-  void SetParentPageId(page_id_t parent_page_id);
-
   auto GetPageId() const -> page_id_t;
   void SetPageId(page_id_t page_id);
 
   void SetLSN(lsn_t lsn = INVALID_LSN);
 
+  /** @return the largest entry the page may have to take, with its slot */
+  auto GetMaxEntrySize() const -> int;
+  /** @return the bytes of the page available to entries */
+  auto GetCapacity() const -> int;
+  /** @return the bytes taken by the entries, their slots and the key prefix */
+  auto GetUsedSpace() const -> int;
+  /** @return the bytes left for new entries, including the dead space compacting the page reclaims */
+  auto GetFreeSpace() const -> int;
+  /** @return the bytes the entries would take if no key shared the key prefix */
+  auto GetExpandedSpace() const -> int;
+
+  /** @return true if the page must be split */
+  auto IsFull() const -> bool;
+  /** @return true if the page must be merged or refilled, unless it is the root */
+  auto IsUnderflow() const -> bool;
+
+  /**
+   * @param key a key
+   * @return the bytes of the key stored in a cell, which drops its trailing zero bytes
+   */
+  template <typename KeyType>
+  static auto KeyBytes(const KeyType &key) -> std::string_view {
+    static_assert(std::is_trivially_copyable_v<KeyType>, "keys are stored as their bytes");
+    const auto *data = reinterpret_cast<const char *>(&key);
+    size_t size = sizeof(KeyType);
+    while (size > 0 && data[size - 1] == 0) {
+      size--;
+    }
+    return {data, size};
+  }
+
+ protected:
+  /** Empty the page, setting the size of its largest entry and whether it compresses key prefixes */
+  void InitCells(int max_entry_size, bool compress_key_prefix);
+
+  /** @return the index to split the page at, by bytes unless it is full by its max size then half_size is used */
+  auto GetSplitIndex(int half_size) const -> int;
+
+  /** @return the key of the entry at index */
+  template <typename KeyType>
+  auto KeyAtCell(int index, size_t value_size) const -> KeyType {
+    KeyType key;
+    auto *data = reinterpret_cast<char *>(&key);
+    size_t prefix_size = IsPrefixedAt(index) ? key_prefix_size_ : 0;
+    size_t suffix_size = CellSizeAt(index) - value_size;
+    memcpy(data, GetKeyPrefix().data(), prefix_size);
+    memcpy(data + prefix_size, CellAt(index) + value_size, suffix_size);
+    memset(data + prefix_size + suffix_size, 0, sizeof(KeyType) - prefix_size - suffix_size);
+    return key;
+  }
+
+  /** @return the value of the entry at index */
+  template <typename ValueType>
+  auto ValueAtCell(int index) const -> ValueType {
+    ValueType value;
+    memcpy(&value, CellAt(index), sizeof(ValueType));
+    return value;
+  }
+
+  /** @return the key of the entry at index, for keys which are a single integer column of key_size bytes */
+  template <typename KeyType>
+  auto IntegerKeyAtCell(int index, size_t value_size, int key_size) const -> int64_t {
+    static_assert(sizeof(KeyType) <= sizeof(int64_t), "integer keys fit into an int64_t");
+    // The key prefix holds the lowest bytes of the integers, their dropped trailing zeros are the highest ones
+    uint64_t bits = 0;
+    auto *data = reinterpret_cast<char *>(&bits);
+    size_t prefix_size = IsPrefixedAt(index) ? key_prefix_size_ : 0;
+    memcpy(data, GetKeyPrefix().data(), prefix_size);
+    memcpy(data + prefix_size, CellAt(index) + value_size, CellSizeAt(index) - value_size);
+    return SignExtend(bits, key_size);
+  }
+
+  /** @return the integer of a key which is a single integer column of key_size bytes */
+  template <typename KeyType>
+  static auto IntegerKey(const KeyType &key, int key_size) -> int64_t {
+    static_assert(sizeof(KeyType) <= sizeof(int64_t), "integer keys fit into an int64_t");
+    uint64_t bits = 0;
+    memcpy(&bits, &key, key_size);
+    return SignExtend(bits, key_size);
+  }
+
+  /**
+   * Binary search keys which are a single integer column of key_size bytes. The search does not branch on the keys,
+   * which a comparison of integers mispredicts half of the time, and reads them straight from their cells.
+   * @return the first index in [begin, end) whose key is greater than key, or equal to it as well unless upper is set
+   */
+  template <typename KeyType>
+  auto IntegerKeyBound(int begin, int end, int64_t key, bool upper, size_t value_size, int key_size) const -> int {
+    if (begin == end) {
+      return begin;
+    }
+    auto before = [key, upper](int64_t probe) {
+      return static_cast<int>(probe < key) | static_cast<int>(upper & (probe == key));
+    };
+    int base = begin;
+    for (int size = end - begin; size > 1; size -= size / 2) {
+      base += (size / 2) * before(IntegerKeyAtCell<KeyType>(base + size / 2, value_size, key_size));
+    }
+    return base + before(IntegerKeyAtCell<KeyType>(base, value_size, key_size));
+  }
+
+  /** Insert an entry before the one at index, the page must not be full */
+  template <typename KeyType, typename ValueType>
+  void InsertCell(int index, const KeyType &key, const ValueType &value) {
+    auto bytes = KeyBytes(key);
+    auto prefix = GetKeyPrefix();
+    bool prefixed = bytes.substr(0, prefix.size()) == prefix;
+    if (prefixed) {
+      bytes.remove_prefix(prefix.size());
+    }
+    char *cell = AllocateCell(index, sizeof(ValueType) + bytes.size(), prefixed);
+    memcpy(cell, &value, sizeof(ValueType));
+    memcpy(cell + sizeof(ValueType), bytes.data(), bytes.size());
+  }
+
+  /** Replace the entries of the page, choosing the key prefix out of the current one and the given ones */
+  template <typename KeyType, typename ValueType>
+  void ResetCells(const std::vector<std::pair<KeyType, ValueType>> &items,
+                  std::vector<std::string> key_prefixes = {}) {
+    std::string key_prefix;
+    if (HasKeyPrefixCompression()) {
+      std::vector<std::string_view> keys;
+      keys.reserve(items.size());
+      for (const auto &item : items) {
+        keys.push_back(KeyBytes(item.first));
+      }
+      key_prefixes.emplace_back(GetKeyPrefix());
+      key_prefix = ChooseKeyPrefix(keys, std::move(key_prefixes));
+    }
+    ClearCells(key_prefix);
+    for (const auto &item : items) {
+      InsertCell(GetSize(), item.first, item.second);
+    }
+  }
+
+  /** @return the entries in [begin, end) */
+  template <typename KeyType, typename ValueType>
+  auto ReadCells(int begin, int end) const -> std::vector<std::pair<KeyType, ValueType>> {
+    std::vector<std::pair<KeyType, ValueType>> items;
+    items.reserve(end - begin);
+    for (int i = begin; i < end; i++) {
+      items.emplace_back(KeyAtCell<KeyType>(i, sizeof(ValueType)), ValueAtCell<ValueType>(i));
+    }
+    return items;
+  }
+
+  void RemoveCell(int index);
+  auto GetKeyPrefix() const -> std::string_view;
+  auto HasKeyPrefixCompression() const -> bool;
+
  private:
+  /** The flag of the slot of a key stored without the key prefix */
+  static constexpr uint16_t SLOT_PREFIXED = 0x8000;
+  /** Flags of the page */
+  static constexpr uint32_t KEY_PREFIX_COMPRESSION = 1;
+
+  struct Slot {
+    uint16_t offset_;
+    uint16_t size_;
+  };
+
+  /** @return the two's complement integer of the lowest key_size bytes of bits */
+  static auto SignExtend(uint64_t bits, int key_size) -> int64_t {
+    int shift = 64 - 8 * key_size;
+    return static_cast<int64_t>(bits << shift) >> shift;
+  }
+
+  /**
+   * @param keys the keys of a page
+   * @param candidates prefixes to consider besides the longest prefix of all the keys
+   * @return the candidate which saves the most bytes
+   */
+  static auto ChooseKeyPrefix(const std::vector<std::string_view> &keys, std::vector<std::string> candidates)
+      -> std::string;
+
+  auto GetHeaderSize() const -> int;
+  auto GetSlots() -> Slot *;
+  auto GetSlots() const -> const Slot *;
+  auto CellAt(int index) const -> const char *;
+  auto CellSizeAt(int index) const -> int;
+  auto IsPrefixedAt(int index) const -> bool;
+  /** @return the most entries the page holds without being full */
+  auto GetMaxEntries() const -> int;
+
+  /** Add a slot for a cell of size bytes before the one at index, @return the cell to write */
+  auto AllocateCell(int index, size_t size, bool prefixed) -> char *;
+  /** Remove all the entries and set the key prefix */
+  void ClearCells(std::string_view key_prefix);
+  /** Move the cells together, reclaiming the dead space */
+  void Compact();
+
   // member variable, attributes that both internal and leaf page share
-  IndexPageType page_type_ __attribute__((__unused__));
-  lsn_t lsn_ __attribute__((__unused__));
-  int size_ __attribute__((__unused__));
-  int max_size_ __attribute__((__unused__));
-  page_id_t parent_page_id_ __attribute__((__unused__));
-  page_id_t page_id_ __attribute__((__unused__));
+  IndexPageType page_type_;
+  lsn_t lsn_;
+  int size_;
+  int max_size_;
+  page_id_t page_id_;
+  uint16_t cells_begin_;
+  uint16_t dead_bytes_;
+  uint16_t key_prefix_size_;
+  uint16_t max_entry_size_;
+  uint32_t flags_;
 };
 
 }  // namespace bustub
@@ -26,9 +26,9 @@ namespace bustub {
  *
  * Directory Page for extendible hash table.
  *
- * Directory format (size in byte):
+ * Directory format (size in byte), with N = DIRECTORY_ARRAY_SIZE, e.g. 512 for 4 KB pages:
  * --------------------------------------------------------------------------------------------
- * | LSN (4) | PageId(4) | GlobalDepth(4) | LocalDepths(512) | BucketPageIds(2048) | Free(1524)
+ * | LSN (4) | PageId(4) | GlobalDepth(4) | LocalDepths(N) | BucketPageIds(4 * N) | Free
  * --------------------------------------------------------------------------------------------
  */
 class HashTableDirectoryPage {
@@ -194,4 +194,6 @@ class HashTableDirectoryPage {
   page_id_t bucket_page_ids_[DIRECTORY_ARRAY_SIZE];
 };
 
+static_assert(sizeof(HashTableDirectoryPage) <= PAGE_SIZE - PAGE_CHECKSUM_SIZE);
+
 }  // namespace bustub
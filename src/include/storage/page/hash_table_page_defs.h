@@ -32,13 +32,19 @@
  * Extendible Hashing Definitions
  */
 #define HASH_TABLE_BUCKET_TYPE HashTableBucketPage<KeyType, ValueType, KeyComparator>
-#define DIRECTORY_ARRAY_SIZE 512
+
+/**
+ * DIRECTORY_ARRAY_SIZE is the number of slots of the extendible hashing directory page, a power of two since the
+ * directory doubles. Each slot takes 5 bytes (local depth and bucket page id), so PAGE_SIZE / 8 slots always fit next
+ * to the header and the checksum trailer: 512 slots for 4 KB pages.
+ */
+#define DIRECTORY_ARRAY_SIZE (PAGE_SIZE / 8)
 
 /**
  * BUCKET_ARRAY_SIZE is the number of (key, value) pairs that can be stored in an extendible hashing bucket page.
  * It is an approximate calculation based on the size of MappingType (which is a std::pair of KeyType and ValueType).
  * For each key/value pair, we need two additional bits for occupied_ and readable_. 4 * (PAGE_SIZE - 4) / (4 * sizeof
  * (MappingType) + 1) = (PAGE_SIZE - 4)/(sizeof (MappingType) + 0.25) because 0.25 bytes = 2 bits is the space required
- * to maintain the occupied and readable flags for a key value pair.
+ * to maintain the occupied and readable flags for a key value pair. The last 4 bytes are the checksum of the page.
  */
-#define BUCKET_ARRAY_SIZE (4 * PAGE_SIZE / (4 * sizeof(MappingType) + 1))
+#define BUCKET_ARRAY_SIZE (4 * (PAGE_SIZE - PAGE_CHECKSUM_SIZE) / (4 * sizeof(MappingType) + 1))
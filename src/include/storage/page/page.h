@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
 
@@ -28,13 +29,19 @@ namespace bustub {
 class Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManagerInstance;
+  friend class MmapBufferPoolManager;
+  friend class FrameArena;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor of a standalone page. Allocates and zeros out the page data, frames of a buffer pool do not. */
+  Page() : data_(new char[PAGE_SIZE]), owns_data_(true) { ResetMemory(); }
 
-  /** Default destructor. */
-  ~Page() = default;
+  /** Destructor. Frees the page data if the page owns it. */
+  ~Page() {
+    if (owns_data_) {
+      delete[] data_;
+    }
+  }
 
   /** @return the actual data contained within this page */
   inline auto GetData() -> char * { return data_; }
@@ -57,6 +64,9 @@ class Page {
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
 
+  /** Acquire the page read latch if it is available right away, @return true if it was acquired. */
+  inline auto TryRLatch() -> bool { return rwlatch_.TryRLock(); }
+
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
@@ -75,17 +85,25 @@ class Page {
   static constexpr size_t OFFSET_LSN = 4;
 
  private:
+  /**
+   * Constructor of a page whose data lives in memory owned by someone else, e.g. a frame arena or a file mapping. The
+   * data is left as it is.
+   */
+  explicit Page(char *data) : data_(data) {}
+
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
   /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
+  char *data_;
+  /** True if data_ was allocated by the page itself. */
+  bool owns_data_{false};
   /** The ID of this page. */
   page_id_t page_id_ = INVALID_PAGE_ID;
-  /** The pin count of this page. */
-  int pin_count_ = 0;
+  /** The pin count of this page. Atomic so that it can be read without holding the page table latches. */
+  std::atomic<int> pin_count_{0};
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
-  bool is_dirty_ = false;
+  std::atomic<bool> is_dirty_{false};
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
 };
@@ -0,0 +1,222 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.h
+//
+// Identification: src/include/storage/page/page_guard.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <type_traits>
+
+#include "storage/page/page.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+class ReadPageGuard;
+class WritePageGuard;
+
+/**
+ * BasicPageGuard owns one pin of a page and unpins it when it goes out of scope, so a page can no longer be leaked by
+ * an early return or an exception. It is move-only: moving hands the pin over, and the moved-from guard is empty.
+ *
+ * A guard is dirty if the page was modified through it (AsMut/GetDataMut), the page is then unpinned as dirty. The
+ * page types are not const correct, so As returns a mutable view as well: it is meant for reading, writes through it
+ * are only flushed if the guard is marked dirty with SetDirty.
+ */
+class BasicPageGuard {
+ public:
+  BasicPageGuard() = default;
+
+  /**
+   * Take over a pin of a page.
+   * @param bpm the buffer pool manager the page is pinned in
+   * @param page the pinned page, nullptr for an empty guard
+   */
+  BasicPageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  BasicPageGuard(const BasicPageGuard &) = delete;
+  auto operator=(const BasicPageGuard &) -> BasicPageGuard & = delete;
+
+  BasicPageGuard(BasicPageGuard &&that) noexcept;
+  auto operator=(BasicPageGuard &&that) noexcept -> BasicPageGuard &;
+
+  /** Unpins the page, if the guard still holds one. */
+  ~BasicPageGuard() { Drop(); }
+
+  /** Unpin the page now rather than when the guard goes out of scope. The guard is empty afterwards. */
+  void Drop();
+
+  /**
+   * Take the read latch of the page and hand the pin over to a ReadPageGuard. This guard is empty afterwards.
+   * @return a guard holding the pin and the read latch
+   */
+  auto UpgradeRead() -> ReadPageGuard;
+
+  /**
+   * Take the write latch of the page and hand the pin over to a WritePageGuard. This guard is empty afterwards.
+   * @return a guard holding the pin and the write latch
+   */
+  auto UpgradeWrite() -> WritePageGuard;
+
+  /** @return true if the guard holds a page */
+  explicit operator bool() const { return page_ != nullptr; }
+
+  /** @return the guarded page, nullptr if the guard is empty */
+  auto GetPage() const -> Page * { return page_; }
+
+  /** @return the id of the guarded page */
+  auto PageId() const -> page_id_t { return page_->GetPageId(); }
+
+  /** @return the data of the guarded page */
+  auto GetData() const -> const char * { return page_->GetData(); }
+
+  /** @return the data of the guarded page, which is unpinned as dirty */
+  auto GetDataMut() -> char * {
+    is_dirty_ = true;
+    return page_->GetData();
+  }
+
+  /** @return the guarded page, viewed as one of the page types */
+  template <class T>
+  auto As() const -> T * {
+    // Page types deriving from Page are views of the page itself, the others are overlaid on top of its data
+    if constexpr (std::is_base_of_v<Page, T>) {
+      return static_cast<T *>(page_);
+    } else {
+      return reinterpret_cast<T *>(page_->GetData());
+    }
+  }
+
+  /** @return the guarded page, viewed as one of the page types, which is unpinned as dirty */
+  template <class T>
+  auto AsMut() -> T * {
+    is_dirty_ = true;
+    return As<T>();
+  }
+
+  /** Unpin the page as dirty even if it was not modified through the guard. */
+  void SetDirty() { is_dirty_ = true; }
+
+ private:
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+  bool is_dirty_{false};
+};
+
+/**
+ * ReadPageGuard owns one pin and the read latch of a page, and releases both when it goes out of scope.
+ */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+
+  /**
+   * Take over a pin and the read latch of a page.
+   * @param bpm the buffer pool manager the page is pinned in
+   * @param page the pinned and read latched page, nullptr for an empty guard
+   */
+  ReadPageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  ReadPageGuard(const ReadPageGuard &) = delete;
+  auto operator=(const ReadPageGuard &) -> ReadPageGuard & = delete;
+
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+  auto operator=(ReadPageGuard &&that) noexcept -> ReadPageGuard &;
+
+  /** Releases the read latch and unpins the page, if the guard still holds one. */
+  ~ReadPageGuard() { Drop(); }
+
+  /** Release the read latch and unpin the page now. The guard is empty afterwards. */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  explicit operator bool() const { return static_cast<bool>(guard_); }
+
+  /** @return the id of the guarded page */
+  auto PageId() const -> page_id_t { return guard_.PageId(); }
+
+  /** @return the data of the guarded page */
+  auto GetData() const -> const char * { return guard_.GetData(); }
+
+  /** @return the guarded page, viewed as one of the page types */
+  template <class T>
+  auto As() const -> T * {
+    return guard_.As<T>();
+  }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+/**
+ * WritePageGuard owns one pin and the write latch of a page, and releases both when it goes out of scope.
+ */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+
+  /**
+   * Take over a pin and the write latch of a page.
+   * @param bpm the buffer pool manager the page is pinned in
+   * @param page the pinned and write latched page, nullptr for an empty guard
+   */
+  WritePageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  WritePageGuard(const WritePageGuard &) = delete;
+  auto operator=(const WritePageGuard &) -> WritePageGuard & = delete;
+
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+  auto operator=(WritePageGuard &&that) noexcept -> WritePageGuard &;
+
+  /** Releases the write latch and unpins the page, if the guard still holds one. */
+  ~WritePageGuard() { Drop(); }
+
+  /** Release the write latch and unpin the page now. The guard is empty afterwards. */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  explicit operator bool() const { return static_cast<bool>(guard_); }
+
+  /** @return the id of the guarded page */
+  auto PageId() const -> page_id_t { return guard_.PageId(); }
+
+  /** @return the data of the guarded page */
+  auto GetData() const -> const char * { return guard_.GetData(); }
+
+  /** @return the data of the guarded page, which is unpinned as dirty */
+  auto GetDataMut() -> char * { return guard_.GetDataMut(); }
+
+  /** @return the guarded page, viewed as one of the page types */
+  template <class T>
+  auto As() const -> T * {
+    return guard_.As<T>();
+  }
+
+  /** @return the guarded page, viewed as one of the page types, which is unpinned as dirty */
+  template <class T>
+  auto AsMut() -> T * {
+    return guard_.AsMut<T>();
+  }
+
+  /** Unpin the page as dirty even if it was not modified through the guard. */
+  void SetDirty() { guard_.SetDirty(); }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+}  // namespace bustub
@@ -26,9 +26,9 @@ namespace bustub {
 
 /**
  * Slotted page format:
- *  ---------------------------------------------------------
- *  | HEADER | ... FREE SPACE ... | ... INSERTED TUPLES ... |
- *  ---------------------------------------------------------
+ *  ------------------------------------------------------------------------
+ *  | HEADER | ... FREE SPACE ... | ... INSERTED TUPLES ... | CHECKSUM (4) |
+ *  ------------------------------------------------------------------------
  *                                ^
  *                                free space pointer
  *
@@ -138,6 +138,9 @@ class TablePage : public Page {
    */
   auto GetNextTupleRid(const RID &cur_rid, RID *next_rid) -> bool;
 
+  /** @return offset of the next page id within the page data, for reading ahead along the table heap */
+  static constexpr auto GetNextPageIdOffset() -> size_t { return OFFSET_NEXT_PAGE_ID; }
+
  private:
   static_assert(sizeof(page_id_t) == 4);
 
@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/page/table_page.h"
@@ -55,9 +57,11 @@ class TableHeap {
    * @param tuple tuple to insert
    * @param[out] rid the rid of the inserted tuple
    * @param txn the transaction performing the insert
+   * @param strategy optional ring of frames to read the table pages into, for bulk inserts. A bulk insert appends
+   * after the page the previous bulk insert used rather than filling free space earlier in the table.
    * @return true iff the insert is successful
    */
-  auto InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) -> bool;
+  auto InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, BufferAccessStrategy *strategy = nullptr) -> bool;
 
   /**
    * Mark the tuple as deleted. The actual delete will occur when ApplyDelete is called.
@@ -99,8 +103,12 @@ class TableHeap {
    */
   auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn) -> bool;
 
-  /** @return the begin iterator of this table */
-  auto Begin(Transaction *txn) -> TableIterator;
+  /**
+   * @param txn the transaction performing the scan
+   * @param strategy optional ring of frames to read the table pages into, for scans of the whole table
+   * @return the begin iterator of this table
+   */
+  auto Begin(Transaction *txn, BufferAccessStrategy *strategy = nullptr) -> TableIterator;
 
   /** @return the end iterator of this table */
   auto End() -> TableIterator;
@@ -113,6 +121,8 @@ class TableHeap {
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+  /** The page the last bulk insert went to, where the next one starts looking for space */
+  std::atomic<page_id_t> last_page_id_{INVALID_PAGE_ID};
 };
 
 }  // namespace bustub
@@ -14,6 +14,7 @@
 
 #include <cassert>
 
+#include "buffer/buffer_access_strategy.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 #include "storage/table/tuple.h"
@@ -29,10 +30,13 @@ class TableIterator {
   friend class Cursor;
 
  public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferAccessStrategy *strategy = nullptr);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        strategy_(other.strategy_) {}
 
   ~TableIterator() { delete tuple_; }
 
@@ -54,6 +58,7 @@ class TableIterator {
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    strategy_ = other.strategy_;
     return *this;
   }
 
@@ -61,6 +66,8 @@ class TableIterator {
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  /** Ring of frames the scanned pages are read into, nullptr to go through the shared buffer pool. */
+  BufferAccessStrategy *strategy_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,465 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_disk_manager.cpp
+//
+// Identification: src/storage/disk/async_disk_manager.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/async_disk_manager.h"
+
+#include <sys/types.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "common/logger.h"
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define BUSTUB_HAS_IO_URING
+#endif
+
+namespace bustub {
+
+namespace {
+
+struct AlignedDeleter {
+  void operator()(char *data) const { free(data); }
+};
+
+/** How long the completion thread waits for completions before it checks whether it should stop, in ns */
+constexpr int64_t WAIT_TIMEOUT_NS = 100'000'000;
+
+}  // namespace
+
+struct AsyncDiskManager::Request {
+  bool is_write_;
+  page_id_t page_id_;
+  char *data_;
+  DiskCallback callback_;
+  std::promise<bool> promise_;
+  /** The checksummed copy of the page a write goes out from */
+  std::unique_ptr<char, AlignedDeleter> copy_;
+};
+
+#ifdef BUSTUB_HAS_IO_URING
+
+/**
+ * The submission and completion rings shared with the kernel. liburing is not a dependency, the rings are mapped and
+ * driven with the raw system calls. Only one thread pushes requests (under latch_) and only the completion thread
+ * pops completions, so the ring indexes only need acquire/release ordering against the kernel.
+ */
+struct AsyncDiskManager::Ring {
+  static auto Create(unsigned entries) -> std::unique_ptr<Ring> {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0) {
+      return nullptr;
+    }
+    auto ring = std::make_unique<Ring>();
+    ring->fd_ = fd;
+    ring->sq_len_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_len_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      ring->sq_len_ = ring->cq_len_ = std::max(ring->sq_len_, ring->cq_len_);
+    }
+    ring->sq_ptr_ = Map(fd, ring->sq_len_, IORING_OFF_SQ_RING);
+    if (ring->sq_ptr_ == nullptr) {
+      return nullptr;
+    }
+    ring->cq_ptr_ = single_mmap ? ring->sq_ptr_ : Map(fd, ring->cq_len_, IORING_OFF_CQ_RING);
+    if (ring->cq_ptr_ == nullptr) {
+      return nullptr;
+    }
+    ring->sqes_len_ = params.sq_entries * sizeof(io_uring_sqe);
+    ring->sqes_ = static_cast<io_uring_sqe *>(Map(fd, ring->sqes_len_, IORING_OFF_SQES));
+    if (ring->sqes_ == nullptr) {
+      return nullptr;
+    }
+
+    auto sq = static_cast<char *>(ring->sq_ptr_);
+    ring->sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    ring->sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    ring->sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    auto cq = static_cast<char *>(ring->cq_ptr_);
+    ring->cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    ring->cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    ring->cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    ring->cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    ring->sq_entries_ = params.sq_entries;
+    ring->timed_wait_ = (params.features & IORING_FEAT_EXT_ARG) != 0;
+    return ring;
+  }
+
+  ~Ring() {
+    if (sqes_ != nullptr) {
+      munmap(sqes_, sqes_len_);
+    }
+    if (cq_ptr_ != nullptr && cq_ptr_ != sq_ptr_) {
+      munmap(cq_ptr_, cq_len_);
+    }
+    if (sq_ptr_ != nullptr) {
+      munmap(sq_ptr_, sq_len_);
+    }
+    close(fd_);
+  }
+
+  /** Push a request to the submission ring. The caller makes sure there is room for it. */
+  void Push(RingOp op, int fd, char *data, off_t offset, uint64_t user_data) {
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & sq_mask_;
+    io_uring_sqe *sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = op == RingOp::READ ? IORING_OP_READ : op == RingOp::WRITE ? IORING_OP_WRITE : IORING_OP_NOP;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(data);
+    sqe->len = op == RingOp::NOP ? 0 : PAGE_SIZE;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+    sq_array_[index] = index;
+    // Publish the entry before the kernel may see the new tail
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  }
+
+  /** @return the number of requests handed to the kernel, or -errno */
+  auto Submit(unsigned num_requests) -> int {
+    auto n = syscall(__NR_io_uring_enter, fd_, num_requests, 0, 0, nullptr, 0);
+    return n < 0 ? -errno : static_cast<int>(n);
+  }
+
+  /** Take back the last num_requests pushed requests, which the kernel has not consumed */
+  void Retract(unsigned num_requests) { __atomic_store_n(sq_tail_, *sq_tail_ - num_requests, __ATOMIC_RELEASE); }
+
+  /**
+   * Block until at least one completion is available, or until WAIT_TIMEOUT_NS passed on kernels which support
+   * timed waits (5.11 on). Older kernels only wake up for completions.
+   * @return 0, -ETIME on a timeout, or -errno
+   */
+  auto Wait() -> int {
+    if (timed_wait_) {
+      __kernel_timespec timeout{0, WAIT_TIMEOUT_NS};
+      io_uring_getevents_arg arg;
+      memset(&arg, 0, sizeof(arg));
+      arg.ts = reinterpret_cast<uint64_t>(&timeout);
+      auto n = syscall(__NR_io_uring_enter, fd_, 0, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg,
+                       sizeof(arg));
+      return n < 0 ? -errno : 0;
+    }
+    auto n = syscall(__NR_io_uring_enter, fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+    return n < 0 ? -errno : 0;
+  }
+
+  /** Pop a completion, if there is one */
+  auto Pop(uint64_t *user_data, int *result) -> bool {
+    unsigned head = *cq_head_;
+    if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      return false;
+    }
+    const io_uring_cqe &cqe = cqes_[head & cq_mask_];
+    *user_data = cqe.user_data;
+    *result = cqe.res;
+    // Hand the slot back to the kernel only once it has been read
+    __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+  static auto Map(int fd, size_t len, off_t offset) -> void * {
+    void *ptr = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+  }
+
+  int fd_{-1};
+  bool timed_wait_{false};
+  unsigned sq_entries_{0};
+  void *sq_ptr_{nullptr};
+  size_t sq_len_{0};
+  void *cq_ptr_{nullptr};
+  size_t cq_len_{0};
+  io_uring_sqe *sqes_{nullptr};
+  size_t sqes_len_{0};
+  unsigned *sq_tail_{nullptr};
+  unsigned sq_mask_{0};
+  unsigned *sq_array_{nullptr};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned cq_mask_{0};
+  io_uring_cqe *cqes_{nullptr};
+};
+
+#else
+
+/** io_uring is not available on this platform, every request runs synchronously */
+struct AsyncDiskManager::Ring {
+  static auto Create(unsigned /*entries*/) -> std::unique_ptr<Ring> { return nullptr; }
+  void Push(RingOp /*op*/, int /*fd*/, char * /*data*/, off_t /*offset*/, uint64_t /*user_data*/) {}
+  auto Submit(unsigned /*num_requests*/) -> int { return -ENOSYS; }
+  void Retract(unsigned /*num_requests*/) {}
+  auto Wait() -> int { return -ENOSYS; }
+  auto Pop(uint64_t * /*user_data*/, int * /*result*/) -> bool { return false; }
+  unsigned sq_entries_{0};
+};
+
+#endif
+
+AsyncDiskManager::AsyncDiskManager(DiskManager *disk_manager, size_t queue_depth, bool use_io_uring)
+    : disk_manager_(disk_manager) {
+  if (use_io_uring) {
+    ring_ = Ring::Create(static_cast<unsigned>(queue_depth));
+    if (ring_ == nullptr) {
+      LOG_DEBUG("io_uring is not available, falling back to synchronous I/O");
+    }
+  }
+  if (ring_ != nullptr) {
+    completion_thread_ = std::thread(&AsyncDiskManager::CompletionLoop, this);
+  }
+}
+
+AsyncDiskManager::~AsyncDiskManager() {
+  if (ring_ == nullptr) {
+    return;
+  }
+  std::unique_lock lock(latch_);
+  SubmitLocked(&lock);
+  completed_cv_.wait(lock, [&] { return num_in_flight_ == 0; });
+  // Wake the completion thread up with a no-op request, it stops at it. If the ring rejects the request, the thread
+  // still stops after its wait timed out. If the ring broke, it stopped on its own already.
+  stopping_ = true;
+  ring_->Push(RingOp::NOP, -1, nullptr, 0, 0);
+  queued_.push_back(nullptr);
+  SubmitLocked(&lock);
+  lock.unlock();
+  completion_thread_.join();
+}
+
+auto AsyncDiskManager::ReadPageAsync(page_id_t page_id, char *page_data, DiskCallback callback) -> std::future<bool> {
+  return Enqueue(false, page_id, page_data, std::move(callback));
+}
+
+auto AsyncDiskManager::WritePageAsync(page_id_t page_id, const char *page_data, DiskCallback callback)
+    -> std::future<bool> {
+  // The buffer is only ever read from for a write
+  return Enqueue(true, page_id, const_cast<char *>(page_data), std::move(callback));
+}
+
+void AsyncDiskManager::Submit() {
+  if (ring_ == nullptr) {
+    return;
+  }
+  std::unique_lock lock(latch_);
+  SubmitLocked(&lock);
+}
+
+void AsyncDiskManager::Drain() {
+  if (ring_ == nullptr) {
+    return;
+  }
+  std::unique_lock lock(latch_);
+  SubmitLocked(&lock);
+  completed_cv_.wait(lock, [&] { return num_in_flight_ == 0; });
+}
+
+auto AsyncDiskManager::Enqueue(bool is_write, page_id_t page_id, char *page_data, DiskCallback callback)
+    -> std::future<bool> {
+  if (disk_manager_->UsesCompression()) {
+    // Pages of a compressed file are not at fixed offsets, they go through the disk manager synchronously
+    bool success = true;
+    if (is_write) {
+      disk_manager_->WritePage(page_id, page_data);
+    } else {
+      success = disk_manager_->ReadPage(page_id, page_data);
+    }
+    return CompleteSynchronously(success, callback);
+  }
+  if (is_write) {
+    disk_manager_->num_writes_ += 1;
+  } else {
+    disk_manager_->num_reads_ += 1;
+  }
+  // A write goes out from a checksummed copy, so the page may change while it is in flight. The copy is aligned.
+  std::unique_ptr<char, AlignedDeleter> copy;
+  if (is_write) {
+    copy.reset(static_cast<char *>(aligned_alloc(DiskManager::DIRECT_IO_ALIGNMENT, PAGE_SIZE)));
+    memcpy(copy.get(), page_data, PAGE_SIZE);
+    DiskManager::StampChecksum(copy.get());
+    page_data = copy.get();
+  }
+  // O_DIRECT needs aligned buffers, the synchronous path bounces the others
+  bool aligned = !disk_manager_->UsesDirectIO() ||
+                 reinterpret_cast<uintptr_t>(page_data) % DiskManager::DIRECT_IO_ALIGNMENT == 0;
+  if (!UsesIoUring() || !aligned) {
+    auto offset = static_cast<off_t>(page_id) * PAGE_SIZE;
+    bool success = is_write ? disk_manager_->WriteAt(page_data, PAGE_SIZE, offset)
+                            : disk_manager_->ReadAt(page_data, PAGE_SIZE, offset) &&
+                                  disk_manager_->VerifyChecksum(page_id, page_data);
+    return CompleteSynchronously(success, callback);
+  }
+
+  auto request = new Request{is_write, page_id, page_data, std::move(callback), {}, std::move(copy)};
+  auto future = request->promise_.get_future();
+  std::unique_lock lock(latch_);
+  PushRequest(&lock, request);
+  return future;
+}
+
+auto AsyncDiskManager::CompleteSynchronously(bool success, const DiskCallback &callback) -> std::future<bool> {
+  if (callback) {
+    callback(success);
+  }
+  std::promise<bool> promise;
+  promise.set_value(success);
+  return promise.get_future();
+}
+
+void AsyncDiskManager::PushRequest(std::unique_lock<std::mutex> *lock, Request *request) {
+  // Bound the requests in flight by the ring size, so that neither the submission nor the completion ring overflows
+  if (num_in_flight_ >= ring_->sq_entries_) {
+    SubmitLocked(lock);
+    completed_cv_.wait(*lock, [&] { return num_in_flight_ < ring_->sq_entries_; });
+  }
+  num_in_flight_++;
+  if (ring_failed_) {
+    // The ring failed while the request waited for room in it
+    lock->unlock();
+    Complete(request, -EIO);
+    return;
+  }
+  ring_->Push(request->is_write_ ? RingOp::WRITE : RingOp::READ, disk_manager_->db_fd_, request->data_,
+              static_cast<off_t>(request->page_id_) * PAGE_SIZE, reinterpret_cast<uint64_t>(request));
+  queued_.push_back(request);
+}
+
+void AsyncDiskManager::SubmitLocked(std::unique_lock<std::mutex> *lock) {
+  while (!queued_.empty()) {
+    int n;
+    if (num_injected_failures_ > 0) {
+      num_injected_failures_--;
+      n = -EIO;
+    } else {
+      n = ring_->Submit(static_cast<unsigned>(queued_.size()));
+    }
+    if (n == -EINTR || n == -EAGAIN || n == -EBUSY) {
+      continue;
+    }
+    if (n < 0) {
+      // The kernel did not consume the queued requests. Take them back out of the ring, so that they are not run
+      // twice, and finish them synchronously; a failed result makes Complete fall back to the disk manager.
+      LOG_WARN("io_uring submission failed with error %d, falling back to synchronous I/O", -n);
+      ring_failed_ = true;
+      ring_->Retract(static_cast<unsigned>(queued_.size()));
+      std::deque<Request *> requests;
+      requests.swap(queued_);
+      lock->unlock();
+      for (auto *request : requests) {
+        // The no-op request of the destructor has nothing to run
+        if (request != nullptr) {
+          Complete(request, n);
+        }
+      }
+      lock->lock();
+      return;
+    }
+    for (int i = 0; i < n; i++) {
+      if (queued_[i] != nullptr) {
+        submitted_.insert(queued_[i]);
+      }
+    }
+    queued_.erase(queued_.begin(), queued_.begin() + n);
+  }
+}
+
+void AsyncDiskManager::CompletionLoop() {
+  std::vector<std::pair<Request *, int>> completions;
+  while (true) {
+    int error = ring_->Wait();
+    bool stopping;
+    {
+      // Reaping under latch_ orders the completions after their submissions for race detectors too, they cannot see
+      // through the rings shared with the kernel
+      std::unique_lock lock(latch_);
+      if (inject_wait_failure_) {
+        inject_wait_failure_ = false;
+        error = -EIO;
+      }
+      if (error < 0 && error != -EINTR && error != -EAGAIN && error != -EBUSY && error != -ETIME) {
+        // No more completions can be reaped from a broken ring. Take back the requests it holds and finish them
+        // synchronously, as failed ones, so that their futures and callbacks still complete.
+        LOG_WARN("io_uring wait failed with error %d, falling back to synchronous I/O", -error);
+        ring_failed_ = true;
+        ring_->Retract(static_cast<unsigned>(queued_.size()));
+        std::vector<Request *> requests(submitted_.begin(), submitted_.end());
+        requests.insert(requests.end(), queued_.begin(), queued_.end());
+        submitted_.clear();
+        queued_.clear();
+        lock.unlock();
+        for (auto *request : requests) {
+          // The no-op request of the destructor has nothing to run
+          if (request != nullptr) {
+            Complete(request, -EIO);
+          }
+        }
+        return;
+      }
+      uint64_t user_data;
+      int result;
+      while (ring_->Pop(&user_data, &result)) {
+        auto *request = reinterpret_cast<Request *>(user_data);
+        submitted_.erase(request);
+        completions.emplace_back(request, result);
+      }
+      stopping = stopping_;
+    }
+    for (auto [request, result] : completions) {
+      // The no-op request which stops the thread is the last one
+      if (request == nullptr) {
+        return;
+      }
+      Complete(request, result);
+    }
+    completions.clear();
+    if (stopping) {
+      return;
+    }
+  }
+}
+
+void AsyncDiskManager::Complete(Request *request, int result) {
+  bool success = result == PAGE_SIZE;
+  if (!success) {
+    // Finish short transfers and failed requests synchronously. This also zero fills a read past the end of file, and
+    // covers kernels which do not know IORING_OP_READ/WRITE yet.
+    auto done = std::max(result, 0);
+    auto offset = static_cast<off_t>(request->page_id_) * PAGE_SIZE + done;
+    success = request->is_write_ ? disk_manager_->WriteAt(request->data_ + done, PAGE_SIZE - done, offset)
+                                 : disk_manager_->ReadAt(request->data_ + done, PAGE_SIZE - done, offset);
+  }
+  if (success && !request->is_write_) {
+    success = disk_manager_->VerifyChecksum(request->page_id_, request->data_);
+  }
+  if (request->callback_) {
+    request->callback_(success);
+  }
+  request->promise_.set_value(success);
+  delete request;
+
+  {
+    std::scoped_lock guard(latch_);
+    num_in_flight_--;
+  }
+  completed_cv_.notify_all();
+}
+
+}  // namespace bustub
@@ -0,0 +1,305 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_store.cpp
+//
+// Identification: src/storage/disk/compressed_page_store.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/compressed_page_store.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include "common/logger.h"
+#include "common/util/crc32c_util.h"
+#include "common/util/lz4_util.h"
+
+namespace bustub {
+
+namespace {
+
+constexpr char FILE_MAGIC[8] = {'B', 'U', 'S', 'T', 'U', 'B', 'L', 'Z'};
+constexpr uint32_t FILE_VERSION = 1;
+constexpr off_t FILE_PAGE_SIZE_OFFSET = 12;
+constexpr uint32_t EXTENT_MAGIC = 0x50585442;  // "BTXP"
+constexpr size_t EXTENT_HEADER_SIZE = 24;
+/** Extents start at aligned offsets, so that the scan can pick up again after a damaged extent */
+constexpr size_t EXTENT_ALIGNMENT = 8;
+/** The bytes of a page which are stored, the checksum trailer is left out */
+constexpr size_t PAGE_DATA_SIZE = PAGE_SIZE - PAGE_CHECKSUM_SIZE;
+/** The scan reads the file in windows of this size */
+constexpr size_t SCAN_WINDOW_SIZE = 1 << 20;
+
+auto AlignUp(off_t offset) -> off_t {
+  return (offset + EXTENT_ALIGNMENT - 1) / EXTENT_ALIGNMENT * EXTENT_ALIGNMENT;
+}
+
+/** @return the number of bytes read, which is short at the end of file, -1 on error */
+auto PreadFull(int fd, char *data, size_t size, off_t offset) -> ssize_t {
+  size_t read_count = 0;
+  while (read_count < size) {
+    auto n = pread(fd, data + read_count, size - read_count, offset + read_count);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      return -1;
+    }
+    if (n == 0) {
+      break;
+    }
+    read_count += n;
+  }
+  return static_cast<ssize_t>(read_count);
+}
+
+auto PwriteFull(int fd, const char *data, size_t size, off_t offset) -> bool {
+  size_t write_count = 0;
+  while (write_count < size) {
+    auto n = pwrite(fd, data + write_count, size - write_count, offset + write_count);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      return false;
+    }
+    write_count += n;
+  }
+  return true;
+}
+
+/** The fields of an extent header, see the format in the class comment */
+struct ExtentHeader {
+  uint32_t checksum_;
+  uint32_t magic_;
+  page_id_t page_id_;
+  uint32_t data_size_;
+  uint64_t sequence_;
+};
+static_assert(sizeof(ExtentHeader) == EXTENT_HEADER_SIZE);
+
+/** @return true if the header and data of an extent are intact */
+auto ExtentMatches(const char *extent, ExtentHeader *header) -> bool {
+  memcpy(header, extent, EXTENT_HEADER_SIZE);
+  if (header->magic_ != EXTENT_MAGIC || header->data_size_ > PAGE_DATA_SIZE) {
+    return false;
+  }
+  return header->checksum_ == Crc32cUtil::Checksum(extent + sizeof(uint32_t),
+                                                   EXTENT_HEADER_SIZE - sizeof(uint32_t) + header->data_size_);
+}
+
+/** A buffer for one extent, one per thread */
+auto GetExtentBuffer() -> char * {
+  thread_local char buffer[EXTENT_HEADER_SIZE + PAGE_DATA_SIZE];
+  return buffer;
+}
+
+}  // namespace
+
+auto CompressedPageStore::IsCompressedFile(int fd) -> bool {
+  char magic[sizeof(FILE_MAGIC)];
+  return PreadFull(fd, magic, sizeof(magic), 0) == static_cast<ssize_t>(sizeof(magic)) &&
+         memcmp(magic, FILE_MAGIC, sizeof(magic)) == 0;
+}
+
+auto CompressedPageStore::GetFilePageSize(int fd) -> size_t {
+  uint32_t page_size;
+  if (PreadFull(fd, reinterpret_cast<char *>(&page_size), sizeof(page_size), FILE_PAGE_SIZE_OFFSET) !=
+      static_cast<ssize_t>(sizeof(page_size))) {
+    return 0;
+  }
+  return page_size;
+}
+
+CompressedPageStore::CompressedPageStore(int fd) : fd_(fd) {
+  struct stat stat_buf;
+  if (fstat(fd_, &stat_buf) == 0 && stat_buf.st_size > 0) {
+    Scan();
+    return;
+  }
+  char header[FILE_HEADER_SIZE] = {0};
+  memcpy(header, FILE_MAGIC, sizeof(FILE_MAGIC));
+  memcpy(header + sizeof(FILE_MAGIC), &FILE_VERSION, sizeof(FILE_VERSION));
+  uint32_t page_size = PAGE_SIZE;
+  memcpy(header + FILE_PAGE_SIZE_OFFSET, &page_size, sizeof(page_size));
+  if (!PwriteFull(fd_, header, FILE_HEADER_SIZE, 0)) {
+    LOG_DEBUG("I/O error while writing the file header");
+  }
+}
+
+auto CompressedPageStore::WritePage(page_id_t page_id, const char *page_data) -> bool {
+  // Compress outside of the latch, only the space in the file is allocated under it
+  auto extent = GetExtentBuffer();
+  ExtentHeader header{0, EXTENT_MAGIC, page_id, 0, 0};
+  header.data_size_ = static_cast<uint32_t>(
+      Lz4Util::Compress(page_data, PAGE_DATA_SIZE, extent + EXTENT_HEADER_SIZE, PAGE_DATA_SIZE - 1));
+  if (header.data_size_ == 0) {
+    // Incompressible, e.g. random bytes
+    header.data_size_ = PAGE_DATA_SIZE;
+    memcpy(extent + EXTENT_HEADER_SIZE, page_data, PAGE_DATA_SIZE);
+  }
+  size_t size = EXTENT_HEADER_SIZE + header.data_size_;
+  off_t offset;
+  {
+    std::scoped_lock guard(latch_);
+    header.sequence_ = next_sequence_++;
+    offset = end_;
+    end_ = AlignUp(end_ + size);
+  }
+  memcpy(extent, &header, EXTENT_HEADER_SIZE);
+  header.checksum_ = Crc32cUtil::Checksum(extent + sizeof(uint32_t), size - sizeof(uint32_t));
+  memcpy(extent, &header.checksum_, sizeof(uint32_t));
+  if (!PwriteFull(fd_, extent, size, offset)) {
+    return false;
+  }
+
+  // Concurrent writes of a page may finish out of order, the latest one wins
+  std::scoped_lock guard(latch_);
+  auto &latest = extents_[page_id];
+  if (latest.sequence_ < header.sequence_) {
+    latest = {offset, static_cast<uint32_t>(size), header.sequence_};
+  }
+  return true;
+}
+
+auto CompressedPageStore::ReadPage(page_id_t page_id, char *page_data) -> bool {
+  Extent location;
+  {
+    std::scoped_lock guard(latch_);
+    auto it = extents_.find(page_id);
+    if (it == extents_.end()) {
+      memset(page_data, 0, PAGE_SIZE);
+      return true;
+    }
+    location = it->second;
+  }
+  auto extent = GetExtentBuffer();
+  auto read_count = PreadFull(fd_, extent, location.size_, location.offset_);
+  if (read_count < 0) {
+    LOG_DEBUG("I/O error while reading");
+    return false;
+  }
+  // An extent cut short, e.g. by a torn append, is as corrupted as one whose bytes changed
+  ExtentHeader header;
+  if (read_count != static_cast<ssize_t>(location.size_) || !ExtentMatches(extent, &header) ||
+      header.page_id_ != page_id ||
+      EXTENT_HEADER_SIZE + header.data_size_ != location.size_) {
+    num_checksum_failures_ += 1;
+    LOG_WARN("checksum mismatch, page %d is corrupted", page_id);
+    return false;
+  }
+  if (header.data_size_ == PAGE_DATA_SIZE) {
+    memcpy(page_data, extent + EXTENT_HEADER_SIZE, PAGE_DATA_SIZE);
+  } else if (Lz4Util::Decompress(extent + EXTENT_HEADER_SIZE, header.data_size_, page_data, PAGE_DATA_SIZE) !=
+             static_cast<int>(PAGE_DATA_SIZE)) {
+    LOG_WARN("malformed compressed data, page %d is corrupted", page_id);
+    return false;
+  }
+  memset(page_data + PAGE_DATA_SIZE, 0, PAGE_CHECKSUM_SIZE);
+  return true;
+}
+
+void CompressedPageStore::DropPage(page_id_t page_id) {
+  std::scoped_lock guard(latch_);
+  extents_.erase(page_id);
+}
+
+auto CompressedPageStore::GetNumPages() -> size_t {
+  std::scoped_lock guard(latch_);
+  size_t num_pages = 0;
+  for (const auto &[page_id, extent] : extents_) {
+    num_pages = std::max(num_pages, static_cast<size_t>(page_id) + 1);
+  }
+  return num_pages;
+}
+
+auto CompressedPageStore::Rewrite(int fd) -> bool {
+  std::scoped_lock guard(latch_);
+  std::vector<page_id_t> page_ids;
+  page_ids.reserve(extents_.size());
+  for (const auto &[page_id, extent] : extents_) {
+    page_ids.push_back(page_id);
+  }
+  // Pages which are read together are usually neighbors by id as well
+  std::sort(page_ids.begin(), page_ids.end());
+
+  char header[FILE_HEADER_SIZE];
+  if (PreadFull(fd_, header, FILE_HEADER_SIZE, 0) != static_cast<ssize_t>(FILE_HEADER_SIZE) ||
+      !PwriteFull(fd, header, FILE_HEADER_SIZE, 0)) {
+    return false;
+  }
+  std::unordered_map<page_id_t, Extent> extents;
+  off_t end = FILE_HEADER_SIZE;
+  auto extent = GetExtentBuffer();
+  for (auto page_id : page_ids) {
+    auto location = extents_[page_id];
+    if (PreadFull(fd_, extent, location.size_, location.offset_) != static_cast<ssize_t>(location.size_) ||
+        !PwriteFull(fd, extent, location.size_, end)) {
+      return false;
+    }
+    extents[page_id] = {end, location.size_, location.sequence_};
+    end = AlignUp(end + location.size_);
+  }
+  fd_ = fd;
+  extents_ = std::move(extents);
+  end_ = end;
+  return true;
+}
+
+void CompressedPageStore::Scan() {
+  struct stat stat_buf;
+  if (fstat(fd_, &stat_buf) != 0) {
+    return;
+  }
+  auto file_size = static_cast<off_t>(stat_buf.st_size);
+  std::vector<char> window(SCAN_WINDOW_SIZE);
+  off_t window_offset = 0;
+  size_t window_size = 0;
+  // Bytes [offset, offset + size) of the file, nullptr if they are past its end
+  auto load = [&](off_t offset, size_t size) -> const char * {
+    if (offset < window_offset || offset + size > window_offset + window_size) {
+      auto read_count = PreadFull(fd_, window.data(), window.size(), offset);
+      window_offset = offset;
+      window_size = std::max<ssize_t>(read_count, 0);
+    }
+    return offset + size <= window_offset + window_size ? window.data() + (offset - window_offset) : nullptr;
+  };
+
+  off_t offset = FILE_HEADER_SIZE;
+  while (offset + static_cast<off_t>(EXTENT_HEADER_SIZE) <= file_size) {
+    ExtentHeader header;
+    auto extent = load(offset, EXTENT_HEADER_SIZE);
+    if (extent == nullptr) {
+      break;
+    }
+    memcpy(&header, extent, EXTENT_HEADER_SIZE);
+    if (header.magic_ == EXTENT_MAGIC && header.data_size_ <= PAGE_DATA_SIZE) {
+      extent = load(offset, EXTENT_HEADER_SIZE + header.data_size_);
+    } else {
+      extent = nullptr;
+    }
+    if (extent == nullptr || !ExtentMatches(extent, &header)) {
+      // A torn or otherwise damaged extent, the next intact one starts at some aligned offset after it
+      offset += EXTENT_ALIGNMENT;
+      continue;
+    }
+    auto &latest = extents_[header.page_id_];
+    if (latest.sequence_ < header.sequence_) {
+      latest = {offset, static_cast<uint32_t>(EXTENT_HEADER_SIZE + header.data_size_), header.sequence_};
+    }
+    next_sequence_ = std::max(next_sequence_, header.sequence_ + 1);
+    offset = AlignUp(offset + EXTENT_HEADER_SIZE + header.data_size_);
+  }
+  end_ = AlignUp(std::max<off_t>(file_size, FILE_HEADER_SIZE));
+}
+
+}  // namespace bustub
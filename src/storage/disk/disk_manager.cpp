@@ -10,33 +10,65 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
 #include <cstring>
+#include <fstream>
 #include <iostream>
-#include <mutex>  // NOLINT
+#include <memory>
 #include <string>
 #include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
 #include "common/logger.h"
+#include "common/util/crc32c_util.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
 
 static char *buffer_used;
 
+namespace {
+
+auto IsAligned(const void *data) -> bool {
+  return reinterpret_cast<uintptr_t>(data) % DiskManager::DIRECT_IO_ALIGNMENT == 0;
+}
+
+/** An aligned buffer of at least size bytes, one per thread, for pages which are not aligned in memory */
+auto GetBounceBuffer(size_t size) -> char * {
+  thread_local std::unique_ptr<char, decltype(&free)> buffer{nullptr, &free};
+  thread_local size_t capacity = 0;
+  if (capacity < size) {
+    buffer.reset(static_cast<char *>(aligned_alloc(DiskManager::DIRECT_IO_ALIGNMENT, size)));
+    capacity = size;
+  }
+  return buffer.get();
+}
+
+}  // namespace
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+DiskManager::DiskManager(const std::string &db_file, bool direct_io, bool compress) : file_name_(db_file) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
     return;
   }
   log_name_ = file_name_.substr(0, n) + ".log";
+  free_name_ = file_name_.substr(0, n) + ".free";
 
   log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
   // directory or file does not exist
@@ -49,27 +81,47 @@ DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
     }
   }
 
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
-    if (!db_io_.is_open()) {
-      throw Exception("can't open db file");
+  // create the file if it does not exist
+  db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
+  }
+  struct stat stat_buf;
+  bool is_new = fstat(db_fd_, &stat_buf) == 0 && stat_buf.st_size == 0;
+  bool is_compressed = CompressedPageStore::IsCompressedFile(db_fd_);
+  // Page layouts are compiled in, a file of another build cannot be read. Only compressed files record their page size.
+  if (is_compressed && CompressedPageStore::GetFilePageSize(db_fd_) != PAGE_SIZE) {
+    close(db_fd_);
+    throw Exception("db file was created with a different page size");
+  }
+  if (is_compressed || (compress && is_new)) {
+    compressed_store_ = std::make_unique<CompressedPageStore>(db_fd_);
+  }
+#ifdef O_DIRECT
+  if (direct_io && compressed_store_ == nullptr) {
+    int fd = open(db_file.c_str(), O_RDWR | O_DIRECT);
+    // e.g. tmpfs does not support O_DIRECT
+    direct_io_ = fd >= 0;
+    if (direct_io_) {
+      close(db_fd_);
+      db_fd_ = fd;
+    } else {
+      LOG_DEBUG("O_DIRECT is not supported, falling back to buffered I/O");
     }
   }
+#endif
   buffer_used = nullptr;
+  LoadFreePages();
 }
 
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
-  {
-    std::scoped_lock scoped_db_io_latch(db_io_latch_);
-    db_io_.close();
+  if (db_fd_ >= 0) {
+    SaveFreePages();
+    close(db_fd_);
+    db_fd_ = -1;
   }
   log_io_.close();
 }
@@ -78,48 +130,211 @@ void DiskManager::ShutDown() {
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-  // set write cursor to offset
   num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG_DEBUG("I/O error while writing");
+  if (compressed_store_ != nullptr) {
+    // Extents carry a checksum of their own
+    if (!compressed_store_->WritePage(page_id, page_data)) {
+      LOG_DEBUG("I/O error while writing");
+    }
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  // Checksum a copy, a page may be changed while it is flushed. The copy is aligned for O_DIRECT as well.
+  auto buffer = GetBounceBuffer(PAGE_SIZE);
+  memcpy(buffer, page_data, PAGE_SIZE);
+  StampChecksum(buffer);
+  // pwrite hands the page to the kernel right away, there is no stream buffer to flush
+  if (!WriteAt(buffer, PAGE_SIZE, static_cast<off_t>(page_id) * PAGE_SIZE)) {
+    LOG_DEBUG("I/O error while writing");
+  }
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
-void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  int offset = page_id * PAGE_SIZE;
-  // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
-    LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    if (db_io_.bad()) {
+auto DiskManager::ReadPage(page_id_t page_id, char *page_data) -> bool {
+  num_reads_ += 1;
+  if (compressed_store_ != nullptr) {
+    return compressed_store_->ReadPage(page_id, page_data);
+  }
+  if (!ReadAt(page_data, PAGE_SIZE, static_cast<off_t>(page_id) * PAGE_SIZE)) {
+    LOG_DEBUG("I/O error while reading");
+    return false;
+  }
+  return VerifyChecksum(page_id, page_data);
+}
+
+/**
+ * Read the contents of consecutive pages into the given memory areas with a single request
+ */
+auto DiskManager::ReadPages(page_id_t first_page_id, size_t num_pages, char **page_data) -> bool {
+  num_reads_ += 1;
+  if (compressed_store_ != nullptr) {
+    // The extents of consecutive pages are not necessarily next to each other
+    bool all_read = true;
+    for (size_t i = 0; i < num_pages; i++) {
+      all_read = compressed_store_->ReadPage(first_page_id + static_cast<page_id_t>(i), page_data[i]) && all_read;
+    }
+    return all_read;
+  }
+  auto offset = static_cast<off_t>(first_page_id) * PAGE_SIZE;
+  if (direct_io_) {
+    // Read the run into the aligned bounce buffer in one go, then scatter it
+    auto buffer = GetBounceBuffer(num_pages * PAGE_SIZE);
+    if (!ReadAt(buffer, num_pages * PAGE_SIZE, offset)) {
       LOG_DEBUG("I/O error while reading");
-      return;
+      return false;
     }
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      db_io_.clear();
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    for (size_t i = 0; i < num_pages; i++) {
+      memcpy(page_data[i], buffer + i * PAGE_SIZE, PAGE_SIZE);
     }
+  } else if (!ReadVectored(offset, num_pages, page_data)) {
+    LOG_DEBUG("I/O error while reading");
+    return false;
+  }
+
+  // Verify every page, so that each corrupted one is reported
+  bool all_valid = true;
+  for (size_t i = 0; i < num_pages; i++) {
+    all_valid = VerifyChecksum(first_page_id + static_cast<page_id_t>(i), page_data[i]) && all_valid;
+  }
+  return all_valid;
+}
+
+/**
+ * Check the checksum trailer of a page
+ */
+auto DiskManager::ChecksumMatches(const char *page_data) -> bool {
+  const char *trailer = page_data + PAGE_SIZE - PAGE_CHECKSUM_SIZE;
+  uint32_t checksum;
+  memcpy(&checksum, trailer, PAGE_CHECKSUM_SIZE);
+  if (checksum == Crc32cUtil::Checksum(page_data, PAGE_SIZE - PAGE_CHECKSUM_SIZE)) {
+    return true;
+  }
+  // A page which was never written, a hole in the file or past its end, is all zeros without a checksum
+  return checksum == 0 && std::all_of(page_data, trailer, [](char c) { return c == 0; });
+}
+
+/**
+ * Hand out the lowest free page the caller can use
+ */
+auto DiskManager::AllocateFreePage(const std::function<bool(page_id_t)> &usable) -> page_id_t {
+  // Skip the latch in the common case of a file without holes
+  if (num_free_pages_ == 0) {
+    return INVALID_PAGE_ID;
+  }
+  std::scoped_lock guard(free_latch_);
+  for (auto it = free_pages_.begin(); it != free_pages_.end(); ++it) {
+    if (usable(*it)) {
+      auto page_id = *it;
+      free_pages_.erase(it);
+      num_free_pages_--;
+      return page_id;
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+/**
+ * Add a page to the free-page map
+ */
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  if (page_id < 0) {
+    return;
+  }
+  if (compressed_store_ != nullptr) {
+    compressed_store_->DropPage(page_id);
+  }
+  std::scoped_lock guard(free_latch_);
+  if (free_pages_.insert(page_id).second) {
+    num_free_pages_++;
+  }
+}
+
+/**
+ * Returns the size of the db file in pages, a trailing partial page counts as a page
+ */
+auto DiskManager::GetNumPages() -> size_t {
+  if (compressed_store_ != nullptr) {
+    return compressed_store_->GetNumPages();
+  }
+  struct stat stat_buf;
+  if (db_fd_ < 0 || fstat(db_fd_, &stat_buf) != 0) {
+    return 0;
+  }
+  return (static_cast<size_t>(stat_buf.st_size) + PAGE_SIZE - 1) / PAGE_SIZE;
+}
+
+/**
+ * Move the live pages at the end of the db file into its holes and truncate it
+ */
+auto DiskManager::Compact(const std::function<void(page_id_t, page_id_t)> &relocate) -> size_t {
+  if (compressed_store_ != nullptr) {
+    return CompactCompressed();
+  }
+  std::scoped_lock guard(free_latch_);
+  auto old_num_pages = GetNumPages();
+  auto num_pages = old_num_pages;
+  std::vector<char> page(PAGE_SIZE);
+  while (num_pages > 0) {
+    auto last_page_id = static_cast<page_id_t>(num_pages - 1);
+    if (free_pages_.count(last_page_id) > 0) {
+      num_pages--;
+      continue;
+    }
+    // The last page is live, move it into the first hole if there is one before it
+    if (relocate == nullptr || free_pages_.empty() || *free_pages_.begin() >= last_page_id) {
+      break;
+    }
+    auto hole_page_id = *free_pages_.begin();
+    if (!ReadAt(page.data(), PAGE_SIZE, static_cast<off_t>(last_page_id) * PAGE_SIZE) ||
+        !WriteAt(page.data(), PAGE_SIZE, static_cast<off_t>(hole_page_id) * PAGE_SIZE)) {
+      LOG_DEBUG("I/O error while compacting");
+      break;
+    }
+    free_pages_.erase(free_pages_.begin());
+    relocate(last_page_id, hole_page_id);
+    num_pages--;
+  }
+  // Page ids past the new end of file are handed out as new pages again, they must not be reused as well
+  free_pages_.erase(free_pages_.lower_bound(static_cast<page_id_t>(num_pages)), free_pages_.end());
+  num_free_pages_ = free_pages_.size();
+  if (num_pages == old_num_pages) {
+    return 0;
+  }
+  if (ftruncate(db_fd_, static_cast<off_t>(num_pages) * PAGE_SIZE) != 0) {
+    LOG_DEBUG("I/O error while truncating");
+    return 0;
   }
+  return old_num_pages - num_pages;
+}
+
+/**
+ * Rewrite a compressed db file without its dead extents
+ */
+auto DiskManager::CompactCompressed() -> size_t {
+  std::scoped_lock guard(free_latch_);
+  auto old_size = static_cast<size_t>(GetFileSize(file_name_));
+  // Write the new file next to the old one and swap them, a crash leaves one of the two intact
+  auto tmp_name = file_name_ + ".tmp";
+  int fd = open(tmp_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    LOG_DEBUG("can't create the compacted db file");
+    return 0;
+  }
+  if (!compressed_store_->Rewrite(fd) || fsync(fd) != 0 || std::rename(tmp_name.c_str(), file_name_.c_str()) != 0) {
+    LOG_DEBUG("I/O error while compacting");
+    close(fd);
+    std::remove(tmp_name.c_str());
+    return 0;
+  }
+  close(db_fd_);
+  db_fd_ = fd;
+  // Page ids past the last page stored are handed out as new pages again, they must not be reused as well
+  auto num_pages = compressed_store_->GetNumPages();
+  free_pages_.erase(free_pages_.lower_bound(static_cast<page_id_t>(num_pages)), free_pages_.end());
+  num_free_pages_ = free_pages_.size();
+  auto new_size = static_cast<size_t>(GetFileSize(file_name_));
+  return old_size > new_size ? (old_size - new_size) / PAGE_SIZE : 0;
 }
 
 /**
@@ -194,11 +409,173 @@ auto DiskManager::GetNumFlushes() const -> int { return num_flushes_; }
  */
 auto DiskManager::GetNumWrites() const -> int { return num_writes_; }
 
+/**
+ * Returns number of read requests
+ */
+auto DiskManager::GetNumReads() const -> int { return num_reads_; }
+
 /**
  * Returns true if the log is currently being flushed
  */
 auto DiskManager::GetFlushState() const -> bool { return flush_log_; }
 
+/**
+ * Private helper function to read from the db file at the given offset, reading past the end of file as zeros
+ */
+auto DiskManager::ReadAt(char *data, size_t size, off_t offset) -> bool {
+  // O_DIRECT needs an aligned buffer, frames are not
+  char *buffer = direct_io_ && !IsAligned(data) ? GetBounceBuffer(size) : data;
+  size_t read_count = 0;
+  while (read_count < size) {
+    auto n = pread(db_fd_, buffer + read_count, size - read_count, offset + read_count);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      return false;
+    }
+    if (n == 0) {
+      break;
+    }
+    read_count += n;
+  }
+  memset(buffer + read_count, 0, size - read_count);
+  if (buffer != data) {
+    memcpy(data, buffer, size);
+  }
+  return true;
+}
+
+/**
+ * Private helper function to write to the db file at the given offset
+ */
+auto DiskManager::WriteAt(const char *data, size_t size, off_t offset) -> bool {
+  const char *buffer = data;
+  if (direct_io_ && !IsAligned(data)) {
+    auto bounce_buffer = GetBounceBuffer(size);
+    memcpy(bounce_buffer, data, size);
+    buffer = bounce_buffer;
+  }
+  size_t write_count = 0;
+  while (write_count < size) {
+    auto n = pwrite(db_fd_, buffer + write_count, size - write_count, offset + write_count);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      return false;
+    }
+    write_count += n;
+  }
+  return true;
+}
+
+/**
+ * Private helper function to read consecutive pages from the db file straight into their buffers
+ */
+auto DiskManager::ReadVectored(off_t offset, size_t num_pages, char **page_data) -> bool {
+  // Scatter the run straight into the pages
+  std::vector<iovec> iov(num_pages);
+  for (size_t i = 0; i < num_pages; i++) {
+    iov[i] = {page_data[i], PAGE_SIZE};
+  }
+  size_t first = 0;
+  while (first < iov.size()) {
+    auto count = static_cast<int>(std::min<size_t>(iov.size() - first, IOV_MAX));
+    auto read_count = preadv(db_fd_, &iov[first], count, offset);
+    if (read_count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (read_count < 0) {
+      return false;
+    }
+    if (read_count == 0) {
+      break;
+    }
+    offset += read_count;
+    // Skip the pages read completely and trim the one read partially
+    auto remaining = static_cast<size_t>(read_count);
+    for (; first < iov.size() && remaining >= iov[first].iov_len; first++) {
+      remaining -= iov[first].iov_len;
+    }
+    if (remaining > 0) {
+      iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + remaining;
+      iov[first].iov_len -= remaining;
+    }
+  }
+  // pages past the end of file were never written, read them as zeros
+  for (; first < iov.size(); first++) {
+    memset(iov[first].iov_base, 0, iov[first].iov_len);
+  }
+  return true;
+}
+
+/**
+ * Private helper function to stamp the checksum of the rest of the page into its trailer
+ */
+void DiskManager::StampChecksum(char *page_data) {
+  uint32_t checksum = Crc32cUtil::Checksum(page_data, PAGE_SIZE - PAGE_CHECKSUM_SIZE);
+  memcpy(page_data + PAGE_SIZE - PAGE_CHECKSUM_SIZE, &checksum, PAGE_CHECKSUM_SIZE);
+}
+
+/**
+ * Private helper function to verify the checksum trailer of a page, it is cleared so that pages read as written
+ */
+auto DiskManager::VerifyChecksum(page_id_t page_id, char *page_data) -> bool {
+  if (!ChecksumMatches(page_data)) {
+    num_checksum_failures_ += 1;
+    LOG_WARN("checksum mismatch, page %d is corrupted", page_id);
+    return false;
+  }
+  memset(page_data + PAGE_SIZE - PAGE_CHECKSUM_SIZE, 0, PAGE_CHECKSUM_SIZE);
+  return true;
+}
+
+/**
+ * Private helper function to load the free-page map saved by the last shut down
+ */
+void DiskManager::LoadFreePages() {
+  std::ifstream in(free_name_);
+  if (!in.is_open()) {
+    return;
+  }
+  auto num_pages = GetNumPages();
+  page_id_t page_id;
+  while (in >> page_id) {
+    // Page ids past the end of file are handed out as new pages, they must not be reused as well
+    if (page_id >= 0 && static_cast<size_t>(page_id) < num_pages) {
+      free_pages_.insert(page_id);
+    }
+  }
+  in.close();
+  // The pages reused from now on would be handed out twice if a crash left this map behind
+  std::remove(free_name_.c_str());
+  num_free_pages_ = free_pages_.size();
+}
+
+/**
+ * Private helper function to save the free-page map, it replaces the old one atomically
+ */
+void DiskManager::SaveFreePages() {
+  std::scoped_lock guard(free_latch_);
+  if (free_pages_.empty()) {
+    return;
+  }
+  auto tmp_name = free_name_ + ".tmp";
+  {
+    std::ofstream out(tmp_name, std::ios::trunc);
+    for (auto page_id : free_pages_) {
+      out << page_id << '\n';
+    }
+    out.flush();
+    if (!out) {
+      LOG_DEBUG("I/O error while saving the free-page map");
+      return;
+    }
+  }
+  std::rename(tmp_name.c_str(), free_name_.c_str());
+}
+
 /**
  * Private helper function to get disk file size
  */
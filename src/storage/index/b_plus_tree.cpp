@@ -9,7 +9,16 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "common/exception.h"
 #include "common/logger.h"
@@ -18,21 +27,173 @@
 #include "storage/page/header_page.h"
 
 namespace bustub {
+
+namespace {
+
+/**
+ * Packs the entries of one level of a bulk loaded tree into pages, left to right in key order. A page is closed once
+ * the next entry would take it past its fill target, in entries or in bytes. A closed page is only written out once
+ * the page after it is closed too, so that a last page left below its min size can be evened out with it.
+ */
+template <typename KeyType, typename ValueType>
+class PagePacker {
+ public:
+  using Entry = std::pair<KeyType, ValueType>;
+
+  /**
+   * @param max_entries the most entries a page holds without being full
+   * @param min_entries a page holding fewer entries underflows, unless half of its capacity is used
+   * @param capacity the bytes of a page available to entries
+   * @param max_entry_size the size of the largest entry, which a page keeps room for
+   * @param compress_key_prefix whether the pages store the prefix their keys share only once
+   * @param fill_factor fraction of each page to fill
+   * @param write_page writes the entries of a page
+   */
+  PagePacker(int max_entries, int min_entries, int capacity, int max_entry_size, bool compress_key_prefix,
+             double fill_factor, std::function<void(const Entry *, size_t)> write_page)
+      : max_entries_(max_entries),
+        min_entries_(min_entries),
+        capacity_(capacity),
+        max_space_(capacity - max_entry_size),
+        target_entries_(std::clamp(static_cast<int>(max_entries * fill_factor), std::max(min_entries, 1), max_entries)),
+        target_space_(std::clamp(static_cast<int>(capacity * fill_factor), capacity / 2, max_space_)),
+        compress_key_prefix_(compress_key_prefix),
+        write_page_(std::move(write_page)) {}
+
+  void Add(const Entry &entry) {
+    auto key = BPlusTreePage::KeyBytes(entry.first);
+    int count = static_cast<int>(entries_.size() - page_begin_) + 1;
+    size_t prefix_size = count == 1 ? key.size() : CommonPrefixSize(prefix_, key);
+    if (count > 1 && (count > target_entries_ || Space(count, key_bytes_ + key.size(), prefix_size) > target_space_)) {
+      ClosePage();
+      prefix_size = key.size();
+    }
+    entries_.push_back(entry);
+    key_bytes_ += key.size();
+    prefix_.assign(key.data(), prefix_size);
+  }
+
+  /** Write out the pages left */
+  void Finish() {
+    const Entry *entries = entries_.data();
+    size_t size = entries_.size();
+    if (page_begin_ > 0 && page_begin_ < size && IsUnderflow(entries + page_begin_, size - page_begin_)) {
+      if (static_cast<int>(size) <= max_entries_ && Space(entries, size) <= max_space_) {
+        page_begin_ = size;
+      } else {
+        page_begin_ = SplitIndex(entries, size);
+      }
+    }
+    if (page_begin_ > 0) {
+      write_page_(entries, page_begin_);
+    }
+    if (page_begin_ < size) {
+      write_page_(entries + page_begin_, size - page_begin_);
+    }
+    entries_.clear();
+    page_begin_ = 0;
+  }
+
+ private:
+  static auto CommonPrefixSize(std::string_view a, std::string_view b) -> size_t {
+    return std::mismatch(a.begin(), a.end(), b.begin(), b.end()).first - a.begin();
+  }
+
+  /** @return the bytes of a page of count entries, taking the longest prefix they share once if it is compressed */
+  auto Space(int count, size_t key_bytes, size_t prefix_size) const -> int {
+    size_t saved = compress_key_prefix_ ? (count - 1) * prefix_size : 0;
+    return static_cast<int>(count * (B_PLUS_TREE_SLOT_SIZE + sizeof(ValueType)) + key_bytes - saved);
+  }
+
+  auto Space(const Entry *entries, size_t count) const -> int {
+    std::string_view prefix = BPlusTreePage::KeyBytes(entries[0].first);
+    size_t key_bytes = 0;
+    for (size_t i = 0; i < count; i++) {
+      auto key = BPlusTreePage::KeyBytes(entries[i].first);
+      key_bytes += key.size();
+      prefix = prefix.substr(0, CommonPrefixSize(prefix, key));
+    }
+    return Space(static_cast<int>(count), key_bytes, prefix.size());
+  }
+
+  auto IsUnderflow(const Entry *entries, size_t count) const -> bool {
+    return static_cast<int>(count) < min_entries_ && Space(entries, count) < capacity_ / 2;
+  }
+
+  /** @return where to split entries too many for a page in two, in half of the entries or of their bytes */
+  auto SplitIndex(const Entry *entries, size_t count) const -> size_t {
+    if (static_cast<int>(count) > max_entries_) {
+      return count / 2;
+    }
+    auto entry_size = [&entries](size_t i) {
+      return B_PLUS_TREE_SLOT_SIZE + sizeof(ValueType) + BPlusTreePage::KeyBytes(entries[i].first).size();
+    };
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+      total += entry_size(i);
+    }
+    size_t index = 0;
+    for (size_t bytes = 0; index < count - 1 && 2 * bytes < total; index++) {
+      bytes += entry_size(index);
+    }
+    return std::max<size_t>(index, 1);
+  }
+
+  /** Write out the page before the current one, the current one becomes the page before the next */
+  void ClosePage() {
+    if (page_begin_ > 0) {
+      write_page_(entries_.data(), page_begin_);
+      entries_.erase(entries_.begin(), entries_.begin() + page_begin_);
+    }
+    page_begin_ = entries_.size();
+    key_bytes_ = 0;
+  }
+
+  int max_entries_;
+  int min_entries_;
+  int capacity_;
+  int max_space_;
+  int target_entries_;
+  int target_space_;
+  bool compress_key_prefix_;
+  std::function<void(const Entry *, size_t)> write_page_;
+  /** The entries of the page closed last, followed by those of the current page starting at page_begin_ */
+  std::vector<Entry> entries_;
+  size_t page_begin_{0};
+  /** The bytes of the keys of the current page, and the prefix they share */
+  size_t key_bytes_{0};
+  std::string prefix_;
+};
+
+}  // namespace
+
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                          int leaf_max_size, int internal_max_size)
+                          int leaf_max_size, int internal_max_size, page_id_t header_page_id,
+                          bool compress_key_prefix)
     : index_name_(std::move(name)),
       root_page_id_(INVALID_PAGE_ID),
       buffer_pool_manager_(buffer_pool_manager),
       comparator_(comparator),
       leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {}
+      internal_max_size_(internal_max_size),
+      compress_key_prefix_(compress_key_prefix),
+      header_page_id_(header_page_id) {
+  // A page split in half by bytes must leave both halves room for another entry
+  static_assert(4 * LeafPage::MAX_ENTRY_SIZE <= PAGE_SIZE - PAGE_CHECKSUM_SIZE - LEAF_PAGE_HEADER_SIZE);
+  static_assert(4 * InternalPage::MAX_ENTRY_SIZE <= PAGE_SIZE - PAGE_CHECKSUM_SIZE - INTERNAL_PAGE_HEADER_SIZE);
+}
 
 /*
  * Helper function to decide whether current b+tree is empty
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::IsEmpty() const -> bool { return true; }
+auto BPLUSTREE_TYPE::IsEmpty() const -> bool {
+  root_latch_.RLock();
+  bool is_empty = root_page_id_ == INVALID_PAGE_ID;
+  root_latch_.RUnlock();
+  return is_empty;
+}
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
@@ -43,7 +204,13 @@ auto BPLUSTREE_TYPE::IsEmpty() const -> bool { return true; }
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) -> bool {
-  return false;
+  auto guard = FindLeafPage(key);
+  ValueType value;
+  if (!guard || !guard.template As<LeafPage>()->Lookup(key, &value, comparator_)) {
+    return false;
+  }
+  result->push_back(value);
+  return true;
 }
 
 /*****************************************************************************
@@ -58,7 +225,38 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) -> bool {
-  return false;
+  {
+    bool is_root;
+    auto guard = FindLeafOptimistic(key, &is_root);
+    if (guard) {
+      auto *leaf = guard.template As<LeafPage>();
+      ValueType old_value;
+      if (leaf->Lookup(key, &old_value, comparator_)) {
+        return false;
+      }
+      if (IsSafe(leaf, Operation::INSERT, is_root)) {
+        guard.template AsMut<LeafPage>()->Insert(key, value, comparator_);
+        return true;
+      }
+    }
+  }
+
+  // The leaf splits or the tree is empty, start over holding every page the insertion reaches
+  Transaction local_transaction(INVALID_TXN_ID);
+  if (transaction == nullptr) {
+    transaction = &local_transaction;
+  }
+  root_latch_.WLock();
+  transaction->AddIntoPageSet(nullptr);
+  bool inserted = true;
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    StartNewTree(key, value);
+  } else {
+    FindLeafPessimistic(key, Operation::INSERT, transaction);
+    inserted = InsertIntoLeaf(key, value, transaction);
+  }
+  ReleasePageSet(transaction, true);
+  return inserted;
 }
 /*
  * Insert constant key & value pair into an empty tree
@@ -67,7 +265,18 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
  * tree's root page id and insert entry directly into leaf page.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {}
+void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
+  page_id_t page_id;
+  auto guard = buffer_pool_manager_->NewPageGuarded(&page_id);
+  if (!guard) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate a new root page");
+  }
+  auto *root = guard.template AsMut<LeafPage>();
+  root->Init(page_id, leaf_max_size_, compress_key_prefix_);
+  root->Insert(key, value, comparator_);
+  root_page_id_ = page_id;
+  UpdateRootPageId(1);
+}
 
 /*
  * Insert constant key & value pair into leaf page
@@ -79,7 +288,19 @@ void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {}
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction) -> bool {
-  return false;
+  auto *leaf = reinterpret_cast<LeafPage *>(transaction->GetPageSet()->back()->GetData());
+  int size = leaf->GetSize();
+  if (leaf->Insert(key, value, comparator_) == size) {
+    return false;
+  }
+  if (leaf->IsFull()) {
+    auto *new_leaf = Split(leaf, transaction);
+    new_leaf->SetNextPageId(leaf->GetNextPageId());
+    leaf->SetNextPageId(new_leaf->GetPageId());
+    InsertIntoParent(leaf, ShortestSeparator(leaf->KeyAt(leaf->GetSize() - 1), new_leaf->KeyAt(0)), new_leaf,
+                     transaction);
+  }
+  return true;
 }
 
 /*
@@ -91,8 +312,16 @@ auto BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-auto BPLUSTREE_TYPE::Split(N *node) -> N * {
-  return nullptr;
+auto BPLUSTREE_TYPE::Split(N *node, Transaction *transaction) -> N * {
+  page_id_t page_id;
+  auto *new_node = reinterpret_cast<N *>(NewNodePage(&page_id, transaction)->GetData());
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    new_node->Init(page_id, node->GetMaxSize(), compress_key_prefix_);
+  } else {
+    new_node->Init(page_id, node->GetMaxSize());
+  }
+  node->MoveHalfTo(new_node);
+  return new_node;
 }
 
 /*
@@ -106,7 +335,118 @@ auto BPLUSTREE_TYPE::Split(N *node) -> N * {
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
-                                      Transaction *transaction) {}
+                                      Transaction *transaction) {
+  Page *parent_page = FindParentPage(old_node->GetPageId(), transaction);
+  if (parent_page == nullptr) {
+    page_id_t root_page_id;
+    auto *root = reinterpret_cast<InternalPage *>(NewNodePage(&root_page_id, transaction)->GetData());
+    root->Init(root_page_id, internal_max_size_);
+    root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
+    root_page_id_ = root_page_id;
+    UpdateRootPageId();
+    return;
+  }
+  auto *parent = reinterpret_cast<InternalPage *>(parent_page->GetData());
+  parent->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
+  if (parent->IsFull()) {
+    auto *new_parent = Split(parent, transaction);
+    InsertIntoParent(parent, new_parent->KeyAt(0), new_parent, transaction);
+  }
+}
+
+/*****************************************************************************
+ * BULK LOADING
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BulkLoad(const std::function<bool(MappingType *)> &next, double fill_factor) -> bool {
+  root_latch_.WLock();
+  if (root_page_id_ != INVALID_PAGE_ID) {
+    root_latch_.WUnlock();
+    return false;
+  }
+
+  // The first key and page id of each page of the level being built, which make up the level above it
+  std::vector<std::pair<KeyType, page_id_t>> level;
+  // Every page allocated so far, which are deleted again if the load fails halfway
+  std::vector<page_id_t> page_ids;
+  auto new_page = [this, &level, &page_ids](const KeyType &first_key) {
+    page_id_t page_id;
+    auto guard = buffer_pool_manager_->NewPageGuarded(&page_id);
+    if (!guard) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate a new page");
+    }
+    page_ids.push_back(page_id);
+    level.emplace_back(first_key, page_id);
+    return guard;
+  };
+
+  // Leaves are separated by the shortest key between them rather than by the first key of the right one
+  BasicPageGuard prev_leaf;
+  try {
+    PagePacker<KeyType, ValueType> leaves(
+        leaf_max_size_ - 1, leaf_max_size_ / 2, PAGE_SIZE - PAGE_CHECKSUM_SIZE - LEAF_PAGE_HEADER_SIZE,
+        LeafPage::MAX_ENTRY_SIZE, compress_key_prefix_, fill_factor, [&](const MappingType *items, size_t size) {
+          KeyType separator{};
+          if (prev_leaf) {
+            auto *prev = prev_leaf.template As<LeafPage>();
+            separator = ShortestSeparator(prev->KeyAt(prev->GetSize() - 1), items[0].first);
+          }
+          auto guard = new_page(separator);
+          auto *leaf = guard.template AsMut<LeafPage>();
+          leaf->Init(level.back().second, leaf_max_size_, compress_key_prefix_);
+          leaf->CopyNFrom(items, static_cast<int>(size));
+          if (prev_leaf) {
+            prev_leaf.template AsMut<LeafPage>()->SetNextPageId(leaf->GetPageId());
+          }
+          prev_leaf = std::move(guard);
+        });
+    MappingType item;
+    std::optional<KeyType> prev_key;
+    while (next(&item)) {
+      if (prev_key.has_value() && comparator_(*prev_key, item.first) == 0) {
+        continue;
+      }
+      leaves.Add(item);
+      prev_key = item.first;
+    }
+    leaves.Finish();
+    prev_leaf.Drop();
+
+    // Internal pages take the separator of each child as its key, the invalid first key of a page included
+    while (level.size() > 1) {
+      auto children = std::move(level);
+      level.clear();
+      PagePacker<KeyType, page_id_t> internals(
+          internal_max_size_, (internal_max_size_ + 1) / 2,
+          PAGE_SIZE - PAGE_CHECKSUM_SIZE - INTERNAL_PAGE_HEADER_SIZE, InternalPage::MAX_ENTRY_SIZE, false, fill_factor,
+          [&](const std::pair<KeyType, page_id_t> *items, size_t size) {
+            auto guard = new_page(items[0].first);
+            auto *internal = guard.template AsMut<InternalPage>();
+            internal->Init(level.back().second, internal_max_size_);
+            internal->CopyNFrom(items, static_cast<int>(size));
+          });
+      for (const auto &child : children) {
+        internals.Add(child);
+      }
+      internals.Finish();
+    }
+
+    if (!level.empty()) {
+      root_page_id_ = level[0].second;
+      UpdateRootPageId(1);
+    }
+  } catch (...) {
+    prev_leaf.Drop();
+    for (auto page_id : page_ids) {
+      buffer_pool_manager_->DeletePage(page_id);
+    }
+    root_page_id_ = INVALID_PAGE_ID;
+    root_latch_.WUnlock();
+    throw;
+  }
+  root_latch_.WUnlock();
+  return true;
+}
 
 /*****************************************************************************
  * REMOVE
@@ -119,7 +459,41 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &ke
  * necessary.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {}
+void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
+  {
+    bool is_root;
+    auto guard = FindLeafOptimistic(key, &is_root);
+    if (!guard) {
+      return;
+    }
+    auto *leaf = guard.template As<LeafPage>();
+    ValueType value;
+    if (!leaf->Lookup(key, &value, comparator_)) {
+      return;
+    }
+    if (IsSafe(leaf, Operation::REMOVE, is_root)) {
+      guard.template AsMut<LeafPage>()->RemoveAndDeleteRecord(key, comparator_);
+      return;
+    }
+  }
+
+  // The leaf underflows, start over holding every page the removal reaches
+  Transaction local_transaction(INVALID_TXN_ID);
+  if (transaction == nullptr) {
+    transaction = &local_transaction;
+  }
+  root_latch_.WLock();
+  transaction->AddIntoPageSet(nullptr);
+  if (root_page_id_ != INVALID_PAGE_ID) {
+    FindLeafPessimistic(key, Operation::REMOVE, transaction);
+    auto *leaf = reinterpret_cast<LeafPage *>(transaction->GetPageSet()->back()->GetData());
+    int size = leaf->GetSize();
+    if (leaf->RemoveAndDeleteRecord(key, comparator_) < size) {
+      CoalesceOrRedistribute(leaf, transaction);
+    }
+  }
+  ReleasePageSet(transaction, true);
+}
 
 /*
  * User needs to first find the sibling of input page. If sibling's size + input
@@ -131,6 +505,46 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {}
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 auto BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) -> bool {
+  // A page which was safe for the removal kept none of its ancestors latched, it does not underflow
+  Page *top_page = transaction->GetPageSet()->front();
+  if (top_page != nullptr && top_page->GetPageId() == node->GetPageId()) {
+    return false;
+  }
+  Page *parent_page = FindParentPage(node->GetPageId(), transaction);
+  if (parent_page == nullptr) {
+    if (AdjustRoot(node)) {
+      transaction->AddIntoDeletedPageSet(node->GetPageId());
+      return true;
+    }
+    return false;
+  }
+  if (!node->IsUnderflow()) {
+    return false;
+  }
+
+  // The parent is write latched, so the sibling can be latched without waiting on a writer holding the parent
+  auto *parent = reinterpret_cast<InternalPage *>(parent_page->GetData());
+  int index = parent->ValueIndex(node->GetPageId());
+  Page *sibling_page = buffer_pool_manager_->FetchPage(parent->ValueAt(index == 0 ? 1 : index - 1));
+  if (sibling_page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch the sibling page");
+  }
+  sibling_page->WLatch();
+  transaction->AddIntoPageSet(sibling_page);
+  auto *sibling = reinterpret_cast<N *>(sibling_page->GetData());
+
+  // Leaves split once they reach their max size, internal pages once they exceed it. The merged page must not be full
+  // either: it keeps the key prefix of one of the pages at worst, and an internal page also takes the separator from
+  // the parent.
+  int max_size = node->IsLeafPage() ? node->GetMaxSize() - 1 : node->GetMaxSize();
+  int space = std::min(sibling->GetUsedSpace() + node->GetExpandedSpace(),
+                       sibling->GetExpandedSpace() + node->GetUsedSpace()) +
+              (node->IsLeafPage() ? 0 : N::MAX_ENTRY_SIZE);
+  if (sibling->GetSize() + node->GetSize() <= max_size && space <= node->GetCapacity() - node->GetMaxEntrySize()) {
+    Coalesce(&sibling, &node, &parent, index, transaction);
+    return index != 0;
+  }
+  Redistribute(sibling, node, parent, index, transaction);
   return false;
 }
 
@@ -151,7 +565,22 @@ template <typename N>
 auto BPLUSTREE_TYPE::Coalesce(N **neighbor_node, N **node,
                               BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> **parent, int index,
                               Transaction *transaction) -> bool {
-  return false;
+  // Always merge the right page into the left one, so that the next page id of the left leaf stays valid
+  N *left = *neighbor_node;
+  N *right = *node;
+  int right_index = index;
+  if (index == 0) {
+    std::swap(left, right);
+    right_index = 1;
+  }
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    right->MoveAllTo(left);
+  } else {
+    right->MoveAllTo(left, (*parent)->KeyAt(right_index));
+  }
+  (*parent)->Remove(right_index);
+  transaction->AddIntoDeletedPageSet(right->GetPageId());
+  return CoalesceOrRedistribute(*parent, transaction);
 }
 
 /*
@@ -162,10 +591,46 @@ auto BPLUSTREE_TYPE::Coalesce(N **neighbor_node, N **node,
  * Using template N to represent either internal page or leaf page.
  * @param   neighbor_node      sibling page of input "node"
  * @param   node               input from method coalesceOrRedistribute()
+ * @param   parent             parent page of both, whose separator key is updated
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
+void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, InternalPage *parent, int index,
+                                  Transaction *transaction) {
+  // Pairs differ in size, keep moving them over while the node underflows and the neighbor has them to spare
+  auto can_spare = [](const N *page) {
+    return page->GetSize() > page->GetMinSize() ||
+           page->GetUsedSpace() - page->GetMaxEntrySize() >= page->GetCapacity() / 2;
+  };
+  do {
+    if (index == 0) {
+      if constexpr (std::is_same_v<N, LeafPage>) {
+        neighbor_node->MoveFirstToEndOf(node);
+        parent->SetKeyAt(1, ShortestSeparator(node->KeyAt(node->GetSize() - 1), neighbor_node->KeyAt(0)));
+      } else {
+        neighbor_node->MoveFirstToEndOf(node, parent->KeyAt(1));
+        parent->SetKeyAt(1, neighbor_node->KeyAt(0));
+      }
+    } else {
+      if constexpr (std::is_same_v<N, LeafPage>) {
+        neighbor_node->MoveLastToFrontOf(node);
+        parent->SetKeyAt(index,
+                         ShortestSeparator(neighbor_node->KeyAt(neighbor_node->GetSize() - 1), node->KeyAt(0)));
+      } else {
+        neighbor_node->MoveLastToFrontOf(node, parent->KeyAt(index));
+        parent->SetKeyAt(index, node->KeyAt(0));
+      }
+    }
+  } while (node->IsUnderflow() && can_spare(neighbor_node));
+
+  // The new separator may be longer than the old one. The parent is only safe for the removal if it has room for that,
+  // so a parent which runs full has its own parent latched.
+  if (parent->IsFull()) {
+    auto *new_parent = Split(parent, transaction);
+    InsertIntoParent(parent, new_parent->KeyAt(0), new_parent, transaction);
+  }
+}
+
 /*
  * Update root page if necessary
  * NOTE: size of root page can be less than min size and this method is only
@@ -177,7 +642,19 @@ void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
  * happend
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) -> bool { return false; }
+auto BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) -> bool {
+  if (!old_root_node->IsLeafPage() && old_root_node->GetSize() == 1) {
+    root_page_id_ = reinterpret_cast<InternalPage *>(old_root_node)->RemoveAndReturnOnlyChild();
+    UpdateRootPageId();
+    return true;
+  }
+  if (old_root_node->IsLeafPage() && old_root_node->GetSize() == 0) {
+    root_page_id_ = INVALID_PAGE_ID;
+    UpdateRootPageId();
+    return true;
+  }
+  return false;
+}
 
 /*****************************************************************************
  * INDEX ITERATOR
@@ -188,7 +665,9 @@ auto BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) -> bool { return f
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE(); }
+auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, FindLeafPage(KeyType(), true), 0);
+}
 
 /*
  * Input parameter is low key, find the leaf page that contains the input key
@@ -196,7 +675,11 @@ auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE()
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE(); }
+auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
+  auto guard = FindLeafPage(key);
+  int index = guard ? guard.template As<LeafPage>()->KeyIndex(key, comparator_) : 0;
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, std::move(guard), index);
+}
 
 /*
  * Input parameter is void, construct an index iterator representing the end
@@ -211,11 +694,167 @@ auto BPLUSTREE_TYPE::End() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE();
  *****************************************************************************/
 /*
  * Find leaf page containing particular key, if leftMost flag == true, find
- * the left most leaf page
+ * the left most leaf page. The leaf is read latched, the guard is empty if the
+ * tree is empty.
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) -> Page * {
-  throw Exception(ExceptionType::NOT_IMPLEMENTED, "Implement this for test");
+auto BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) -> ReadPageGuard {
+  root_latch_.RLock();
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    root_latch_.RUnlock();
+    return {};
+  }
+  auto guard = buffer_pool_manager_->FetchPageRead(root_page_id_);
+  root_latch_.RUnlock();
+  while (guard && !guard.template As<BPlusTreePage>()->IsLeafPage()) {
+    auto *internal = guard.template As<InternalPage>();
+    // Moving the child guard in releases the parent only after the child is latched
+    guard = buffer_pool_manager_->FetchPageRead(leftMost ? internal->ValueAt(0) : internal->Lookup(key, comparator_));
+  }
+  if (!guard) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch a page of the tree");
+  }
+  return guard;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafOptimistic(const KeyType &key, bool *is_root) -> WritePageGuard {
+  root_latch_.RLock();
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    root_latch_.RUnlock();
+    return {};
+  }
+  auto page = buffer_pool_manager_->FetchPageBasic(root_page_id_);
+  if (!page) {
+    root_latch_.RUnlock();
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch the root page");
+  }
+  // The type of a page never changes while it is in the tree, so it can be checked before latching the page
+  *is_root = page.template As<BPlusTreePage>()->IsLeafPage();
+  if (*is_root) {
+    auto leaf = page.UpgradeWrite();
+    root_latch_.RUnlock();
+    return leaf;
+  }
+  auto parent = page.UpgradeRead();
+  root_latch_.RUnlock();
+  while (true) {
+    auto child = buffer_pool_manager_->FetchPageBasic(parent.template As<InternalPage>()->Lookup(key, comparator_));
+    if (!child) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch a page of the tree");
+    }
+    if (child.template As<BPlusTreePage>()->IsLeafPage()) {
+      return child.UpgradeWrite();
+    }
+    parent = child.UpgradeRead();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::FindLeafPessimistic(const KeyType &key, Operation operation, Transaction *transaction) {
+  Page *page = buffer_pool_manager_->FetchPage(root_page_id_);
+  bool is_root = true;
+  while (true) {
+    if (page == nullptr) {
+      ReleasePageSet(transaction, false);
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch a page of the tree");
+    }
+    page->WLatch();
+    auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (IsSafe(node, operation, is_root)) {
+      ReleasePageSet(transaction, false);
+    }
+    transaction->AddIntoPageSet(page);
+    if (node->IsLeafPage()) {
+      return;
+    }
+    page = buffer_pool_manager_->FetchPage(reinterpret_cast<InternalPage *>(node)->Lookup(key, comparator_));
+    is_root = false;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::IsSafe(const BPlusTreePage *node, Operation operation, bool is_root) const -> bool {
+  // Adding a pair, or replacing a separator by a longer one, takes at most the max entry size
+  bool has_room = node->GetFreeSpace() >= 2 * node->GetMaxEntrySize();
+  if (operation == Operation::INSERT) {
+    // Leaves split once they reach their max size, internal pages once they exceed it
+    return has_room &&
+           (node->IsLeafPage() ? node->GetSize() + 1 < node->GetMaxSize() : node->GetSize() < node->GetMaxSize());
+  }
+  if (!node->IsLeafPage() && !has_room) {
+    return false;
+  }
+  if (is_root) {
+    // The root only changes once it runs out of keys, or of children but one
+    return node->GetSize() > (node->IsLeafPage() ? 1 : 2);
+  }
+  return node->GetSize() > node->GetMinSize() ||
+         node->GetUsedSpace() - node->GetMaxEntrySize() >= node->GetCapacity() / 2;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::ShortestSeparator(const KeyType &left, const KeyType &right) const -> KeyType {
+  // Only the data of variable-length columns is cut, cutting their offsets or lengths would leave them unreadable
+  auto right_bytes = BPlusTreePage::KeyBytes(right);
+  size_t size = std::min<size_t>(comparator_.GetMinPrefixSize(right), right_bytes.size());
+  KeyType separator{};
+  auto *data = reinterpret_cast<char *>(&separator);
+  memcpy(data, right_bytes.data(), size);
+  while (size < right_bytes.size() && (comparator_(left, separator) >= 0 || comparator_(separator, right) > 0)) {
+    data[size] = right_bytes[size];
+    size++;
+  }
+  return separator;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindParentPage(page_id_t page_id, Transaction *transaction) const -> Page * {
+  auto &pages = *transaction->GetPageSet();
+  for (auto it = pages.begin(); it != pages.end(); ++it) {
+    if (*it != nullptr && (*it)->GetPageId() == page_id) {
+      BUSTUB_ASSERT(it != pages.begin(), "the parent of the page was released");
+      return *std::prev(it);
+    }
+  }
+  UNREACHABLE("the page is not in the page set");
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::NewNodePage(page_id_t *page_id, Transaction *transaction) -> Page * {
+  Page *page = buffer_pool_manager_->NewPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate a new page");
+  }
+  page->WLatch();
+  transaction->AddIntoPageSet(page);
+  return page;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleasePageSet(Transaction *transaction, bool is_dirty) {
+  auto pages = transaction->GetPageSet();
+  for (Page *page : *pages) {
+    if (page == nullptr) {
+      root_latch_.WUnlock();
+      continue;
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), is_dirty);
+  }
+  pages->clear();
+
+  auto deleted_pages = transaction->GetDeletedPageSet();
+  if (deleted_pages->empty()) {
+    return;
+  }
+  // An iterator may still have a merged page pinned, such pages are retried whenever pages are deleted again
+  std::scoped_lock lock(garbage_latch_);
+  garbage_pages_.insert(garbage_pages_.end(), deleted_pages->begin(), deleted_pages->end());
+  deleted_pages->clear();
+  garbage_pages_.erase(std::remove_if(garbage_pages_.begin(), garbage_pages_.end(),
+                                      [this](page_id_t page_id) { return buffer_pool_manager_->DeletePage(page_id); }),
+                       garbage_pages_.end());
 }
 
 /*
@@ -228,15 +867,16 @@ auto BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) -> Page * {
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-  auto *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
-  if (insert_record != 0) {
-    // create a new record<index_name + root_page_id> in header_page
-    header_page->InsertRecord(index_name_, root_page_id_);
-  } else {
+  auto guard = buffer_pool_manager_->FetchPageWrite(header_page_id_);
+  if (!guard) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch the header page");
+  }
+  auto *header_page = guard.template AsMut<HeaderPage>();
+  // A tree emptied and started over still has its record, which is updated then
+  if (insert_record == 0 || !header_page->InsertRecord(index_name_, root_page_id_)) {
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
   }
-  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
 }
 
 /*
@@ -338,12 +978,6 @@ void BPLUSTREE_TYPE::ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::o
       out << leaf_prefix << leaf->GetPageId() << " -> " << leaf_prefix << leaf->GetNextPageId() << ";\n";
       out << "{rank=same " << leaf_prefix << leaf->GetPageId() << " " << leaf_prefix << leaf->GetNextPageId() << "};\n";
     }
-
-    // Print parent links if there is a parent
-    if (leaf->GetParentPageId() != INVALID_PAGE_ID) {
-      out << internal_prefix << leaf->GetParentPageId() << ":p" << leaf->GetPageId() << " -> " << leaf_prefix
-          << leaf->GetPageId() << ";\n";
-    }
   } else {
     auto *inner = reinterpret_cast<InternalPage *>(page);
     // Print node name
@@ -370,14 +1004,12 @@ void BPLUSTREE_TYPE::ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::o
     out << "</TR>";
     // Print table end
     out << "</TABLE>>];\n";
-    // Print Parent link
-    if (inner->GetParentPageId() != INVALID_PAGE_ID) {
-      out << internal_prefix << inner->GetParentPageId() << ":p" << inner->GetPageId() << " -> " << internal_prefix
-          << inner->GetPageId() << ";\n";
-    }
     // Print leaves
     for (int i = 0; i < inner->GetSize(); i++) {
       auto child_page = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(inner->ValueAt(i))->GetData());
+      // Print the link to the child, pages do not know their parent
+      out << internal_prefix << inner->GetPageId() << ":p" << child_page->GetPageId() << " -> "
+          << (child_page->IsLeafPage() ? leaf_prefix : internal_prefix) << child_page->GetPageId() << ";\n";
       ToGraph(child_page, bpm, out);
       if (i > 0) {
         auto sibling_page = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(inner->ValueAt(i - 1))->GetData());
@@ -404,8 +1036,7 @@ INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::ToString(BPlusTreePage *page, BufferPoolManager *bpm) const {
   if (page->IsLeafPage()) {
     auto *leaf = reinterpret_cast<LeafPage *>(page);
-    std::cout << "Leaf Page: " << leaf->GetPageId() << " parent: " << leaf->GetParentPageId()
-              << " next: " << leaf->GetNextPageId() << std::endl;
+    std::cout << "Leaf Page: " << leaf->GetPageId() << " next: " << leaf->GetNextPageId() << std::endl;
     for (int i = 0; i < leaf->GetSize(); i++) {
       std::cout << leaf->KeyAt(i) << ",";
     }
@@ -413,7 +1044,7 @@ void BPLUSTREE_TYPE::ToString(BPlusTreePage *page, BufferPoolManager *bpm) const
     std::cout << std::endl;
   } else {
     auto *internal = reinterpret_cast<InternalPage *>(page);
-    std::cout << "Internal Page: " << internal->GetPageId() << " parent: " << internal->GetParentPageId() << std::endl;
+    std::cout << "Internal Page: " << internal->GetPageId() << std::endl;
     for (int i = 0; i < internal->GetSize(); i++) {
       std::cout << internal->KeyAt(i) << ": " << internal->ValueAt(i) << ",";
     }
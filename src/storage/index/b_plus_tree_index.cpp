@@ -9,9 +9,29 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+
 #include "storage/index/b_plus_tree_index.h"
+#include "storage/index/external_sorter.h"
+#include "storage/page/header_page.h"
 
 namespace bustub {
+
+namespace {
+
+/** Allocate the header page of a new index, which holds no records yet */
+auto NewHeaderPage(BufferPoolManager *buffer_pool_manager) -> page_id_t {
+  page_id_t page_id;
+  auto guard = buffer_pool_manager->NewPageGuarded(&page_id);
+  if (!guard) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate the header page of the index");
+  }
+  guard.AsMut<HeaderPage>()->Init();
+  return page_id;
+}
+
+}  // namespace
+
 /*
  * Constructor
  */
@@ -19,7 +39,9 @@ INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager)
     : Index(std::move(metadata)),
       comparator_(GetMetadata()->GetKeySchema()),
-      container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_) {}
+      header_page_id_(NewHeaderPage(buffer_pool_manager)),
+      container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_, LEAF_PAGE_SIZE, INTERNAL_PAGE_SIZE - 1,
+                 header_page_id_) {}
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) {
@@ -48,6 +70,61 @@ void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, T
   container_.GetValue(index_key, result, transaction);
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanRange(const Tuple *low, bool low_inclusive, const Tuple *high, bool high_inclusive,
+                                     ScanDirection direction, std::vector<RID> *result, Transaction *transaction) {
+  KeyType low_key;
+  KeyType high_key;
+  if (low != nullptr) {
+    low_key.SetFromKey(*low);
+  }
+  if (high != nullptr) {
+    high_key.SetFromKey(*high);
+  }
+
+  // The leaves are only chained forwards, a backward scan collects the range forwards and reverses it
+  size_t begin = result->size();
+  auto end = container_.End();
+  for (auto it = low == nullptr ? container_.Begin() : container_.Begin(low_key); it != end; ++it) {
+    const auto &[key, rid] = *it;
+    if (low != nullptr && !low_inclusive && comparator_(key, low_key) == 0) {
+      continue;
+    }
+    if (high != nullptr) {
+      int cmp = comparator_(key, high_key);
+      if (cmp > 0 || (cmp == 0 && !high_inclusive)) {
+        break;
+      }
+    }
+    result->push_back(rid);
+  }
+  if (direction == ScanDirection::BACKWARD) {
+    std::reverse(result->begin() + begin, result->end());
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::BulkLoad(const std::function<bool(Tuple *, RID *)> &next, Transaction *transaction,
+                                    double fill_factor) {
+  auto less = [this](const MappingType &a, const MappingType &b) { return comparator_(a.first, b.first) < 0; };
+  ExternalSorter<MappingType, decltype(less)> sorter(less);
+  Tuple key;
+  RID rid;
+  while (next(&key, &rid)) {
+    KeyType index_key;
+    index_key.SetFromKey(key);
+    sorter.Add({index_key, rid});
+  }
+  sorter.Sort();
+
+  if (!container_.BulkLoad([&sorter](MappingType *entry) { return sorter.Next(entry); }, fill_factor)) {
+    MappingType entry;
+    while (sorter.Next(&entry)) {
+      container_.Insert(entry.first, entry.second, transaction);
+    }
+  }
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_INDEX_TYPE::GetBeginIterator() -> INDEXITERATOR_TYPE { return container_.Begin(); }
 
@@ -2,29 +2,67 @@
  * index_iterator.cpp
  */
 #include <cassert>
+#include <utility>
 
+#include "common/exception.h"
 #include "storage/index/index_iterator.h"
 
 namespace bustub {
 
-/*
- * NOTE: you can change the destructor/constructor method here
- * set your own input parameters
- */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::IndexIterator() = default;
+INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *bpm, ReadPageGuard guard, int index)
+    : bpm_(bpm), guard_(std::move(guard)), index_(index) {
+  if (guard_) {
+    PrefetchNextLeaves();
+    SkipToValidPosition();
+  }
+}
 
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::~IndexIterator() = default;  // NOLINT
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::IsEnd() -> bool { throw std::runtime_error("unimplemented"); }
+auto INDEXITERATOR_TYPE::IsEnd() -> bool { return !guard_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::operator*() -> const MappingType & {
+  item_ = guard_.template As<LeafPage>()->GetItem(index_);
+  return item_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
+  index_++;
+  SkipToValidPosition();
+  return *this;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::operator*() -> const MappingType & { throw std::runtime_error("unimplemented"); }
+void INDEXITERATOR_TYPE::SkipToValidPosition() {
+  // Leaves emptied by a merge still link to the next leaf, they are skipped over
+  while (guard_ && index_ >= guard_.template As<LeafPage>()->GetSize()) {
+    page_id_t next_page_id = guard_.template As<LeafPage>()->GetNextPageId();
+    index_ = 0;
+    if (next_page_id == INVALID_PAGE_ID) {
+      guard_.Drop();
+      return;
+    }
+    // Pin the next leaf so that it stays around, but only latch it once the current one is released
+    auto next = bpm_->FetchPageBasic(next_page_id);
+    guard_.Drop();
+    if (!next) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch the next leaf page");
+    }
+    guard_ = next.UpgradeRead();
+    PrefetchNextLeaves();
+  }
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & { throw std::runtime_error("unimplemented"); }
+void INDEXITERATOR_TYPE::PrefetchNextLeaves() {
+  bpm_->PrefetchRange(guard_.template As<LeafPage>()->GetNextPageId(), SCAN_PREFETCH_DISTANCE,
+                      LeafPage::GetNextPageIdOffset());
+}
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 
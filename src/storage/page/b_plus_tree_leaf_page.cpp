@@ -9,7 +9,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <sstream>
+#include <string>
 
 #include "common/exception.h"
 #include "common/rid.h"
@@ -23,28 +25,49 @@ namespace bustub {
 
 /**
  * Init method after creating a new leaf page
- * Including set page type, set current size to zero, set page id/parent id, set
- * next page id and set max size
+ * Including set page type, set current size to zero, set page id, set next
+ * page id and set max size
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, int max_size, bool compress_key_prefix) {
+  SetPageType(IndexPageType::LEAF_PAGE);
+  SetPageId(page_id);
+  SetMaxSize(max_size);
+  SetLSN();
+  InitCells(MAX_ENTRY_SIZE, compress_key_prefix);
+  next_page_id_ = INVALID_PAGE_ID;
+}
 
 /**
  * Helper methods to set/get next page id
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetNextPageId() const -> page_id_t { return INVALID_PAGE_ID; }
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetNextPageId() const -> page_id_t { return next_page_id_; }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
 
 /**
- * Helper method to find the first index i so that array[i].first >= key
- * NOTE: This method is only used when generating index iterator
+ * Helper method to find the first index i so that the key at i >= key
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const KeyType &key, const KeyComparator &comparator) const -> int {
-  return 0;
+  if constexpr (sizeof(KeyType) <= sizeof(int64_t)) {
+    if (int key_size = comparator.GetIntegerKeySize(); key_size != 0) {
+      return IntegerKeyBound<KeyType>(0, GetSize(), IntegerKey(key, key_size), false, sizeof(ValueType), key_size);
+    }
+  }
+  int left = 0;
+  int right = GetSize();
+  while (left < right) {
+    int mid = left + (right - left) / 2;
+    if (comparator(KeyAt(mid), key) < 0) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  return left;
 }
 
 /*
@@ -53,9 +76,7 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const KeyType &key, const KeyComparato
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const -> KeyType {
-  // replace with your own code
-  KeyType key{};
-  return key;
+  return KeyAtCell<KeyType>(index, sizeof(ValueType));
 }
 
 /*
@@ -63,9 +84,8 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const -> KeyType {
  * "index"(a.k.a array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) -> const MappingType & {
-  // replace with your own code
-  return array_[0];
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) const -> MappingType {
+  return {KeyAt(index), ValueAtCell<ValueType>(index)};
 }
 
 /*****************************************************************************
@@ -73,12 +93,17 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) -> const MappingType & {
  *****************************************************************************/
 /*
  * Insert key & value pair into leaf page ordered by key
- * @return  page size after insertion
+ * @return  page size after insertion, unchanged if the key exists already
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator)
     -> int {
-  return 0;
+  int index = KeyIndex(key, comparator);
+  if (index < GetSize() && comparator(KeyAt(index), key) == 0) {
+    return GetSize();
+  }
+  InsertCell(index, key, value);
+  return GetSize();
 }
 
 /*****************************************************************************
@@ -86,15 +111,25 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key, const ValueType &val
  *****************************************************************************/
 /*
  * Remove half of key & value pairs from this page to "recipient" page
+ * Both pages are rewritten, each choosing the key prefix of its own half.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(BPlusTreeLeafPage *recipient) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(BPlusTreeLeafPage *recipient) {
+  int keep = GetSplitIndex(GetSize() / 2);
+  std::string key_prefix(GetKeyPrefix());
+  recipient->ResetCells(ReadCells<KeyType, ValueType>(keep, GetSize()), {key_prefix});
+  ResetCells(ReadCells<KeyType, ValueType>(0, keep));
+}
 
 /*
  * Copy starting from items, and copy {size} number of elements into me.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(MappingType *items, int size) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(const MappingType *items, int size) {
+  auto all_items = ReadCells<KeyType, ValueType>(0, GetSize());
+  all_items.insert(all_items.end(), items, items + size);
+  ResetCells(all_items);
+}
 
 /*****************************************************************************
  * LOOKUP
@@ -107,7 +142,12 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(MappingType *items, int size) {}
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType *value, const KeyComparator &comparator) const
     -> bool {
-  return false;
+  int index = KeyIndex(key, comparator);
+  if (index == GetSize() || comparator(KeyAt(index), key) != 0) {
+    return false;
+  }
+  *value = ValueAtCell<ValueType>(index);
+  return true;
 }
 
 /*****************************************************************************
@@ -121,7 +161,12 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType *value, co
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(const KeyType &key, const KeyComparator &comparator) -> int {
-  return 0;
+  int index = KeyIndex(key, comparator);
+  if (index == GetSize() || comparator(KeyAt(index), key) != 0) {
+    return GetSize();
+  }
+  RemoveCell(index);
+  return GetSize();
 }
 
 /*****************************************************************************
@@ -132,7 +177,14 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(const KeyType &key, const
  * to update the next_page id in the sibling page
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient) {
+  auto items = recipient->template ReadCells<KeyType, ValueType>(0, recipient->GetSize());
+  auto moved = ReadCells<KeyType, ValueType>(0, GetSize());
+  items.insert(items.end(), moved.begin(), moved.end());
+  recipient->ResetCells(items, {std::string(GetKeyPrefix())});
+  recipient->SetNextPageId(GetNextPageId());
+  ResetCells(std::vector<MappingType>{});
+}
 
 /*****************************************************************************
  * REDISTRIBUTE
@@ -141,25 +193,19 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient) {}
  * Remove the first key & value pair from this page to "recipient" page.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient) {}
-
-/*
- * Copy the item into the end of my item list. (Append item to my array)
- */
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyLastFrom(const MappingType &item) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient) {
+  recipient->InsertCell(recipient->GetSize(), KeyAt(0), ValueAtCell<ValueType>(0));
+  RemoveCell(0);
+}
 
 /*
  * Remove the last key & value pair from this page to "recipient" page.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient) {}
-
-/*
- * Insert item at the front of my items. Move items accordingly.
- */
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFirstFrom(const MappingType &item) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient) {
+  recipient->InsertCell(0, KeyAt(GetSize() - 1), ValueAtCell<ValueType>(GetSize() - 1));
+  RemoveCell(GetSize() - 1);
+}
 
 template class BPlusTreeLeafPage<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
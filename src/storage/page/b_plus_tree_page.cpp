@@ -9,6 +9,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+
 #include "storage/page/b_plus_tree_page.h"
 
 namespace bustub {
@@ -17,45 +19,191 @@ namespace bustub {
  * Helper methods to get/set page type
  * Page type enum class is defined in b_plus_tree_page.h
  */
-auto BPlusTreePage::IsLeafPage() const -> bool { return false; }
-auto BPlusTreePage::IsRootPage() const -> bool { return false; }
-void BPlusTreePage::SetPageType(IndexPageType page_type) {}
+auto BPlusTreePage::IsLeafPage() const -> bool { return page_type_ == IndexPageType::LEAF_PAGE; }
+void BPlusTreePage::SetPageType(IndexPageType page_type) { page_type_ = page_type; }
 
 /*
- * Helper methods to get/set size (number of key/value pairs stored in that
- * page)
+ * Helper method to get size (number of key/value pairs stored in that page)
  */
-auto BPlusTreePage::GetSize() const -> int { return 0; }
-void BPlusTreePage::SetSize(int size) {}
-void BPlusTreePage::IncreaseSize(int amount) {}
+auto BPlusTreePage::GetSize() const -> int { return size_; }
 
 /*
  * Helper methods to get/set max size (capacity) of the page
  */
-auto BPlusTreePage::GetMaxSize() const -> int { return 0; }
-void BPlusTreePage::SetMaxSize(int size) {}
+auto BPlusTreePage::GetMaxSize() const -> int { return max_size_; }
+void BPlusTreePage::SetMaxSize(int size) { max_size_ = size; }
 
 /*
  * Helper method to get min page size
- * Generally, min page size == max page size / 2
- */
-auto BPlusTreePage::GetMinSize() const -> int { return 0; }
-
-/*
- * Helper methods to get/set parent page id
+ * A leaf splits once it is full, into two halves of at least max_size / 2 pairs. An internal page splits once it
+ * overflows, into two halves of at least (max_size + 1) / 2 children.
  */
-auto BPlusTreePage::GetParentPageId() const -> page_id_t { return 0; }
-void BPlusTreePage::SetParentPageId(page_id_t parent_page_id) {}
+auto BPlusTreePage::GetMinSize() const -> int { return IsLeafPage() ? max_size_ / 2 : (max_size_ + 1) / 2; }
 
 /*
  * Helper methods to get/set self page id
  */
-auto BPlusTreePage::GetPageId() const -> page_id_t { return 0; }
-void BPlusTreePage::SetPageId(page_id_t page_id) {}
+auto BPlusTreePage::GetPageId() const -> page_id_t { return page_id_; }
+void BPlusTreePage::SetPageId(page_id_t page_id) { page_id_ = page_id; }
 
 /*
  * Helper methods to set lsn
  */
 void BPlusTreePage::SetLSN(lsn_t lsn) { lsn_ = lsn; }
 
+/*
+ * Helper methods for the space taken by the entries
+ */
+auto BPlusTreePage::GetMaxEntrySize() const -> int { return max_entry_size_; }
+auto BPlusTreePage::GetCapacity() const -> int { return PAGE_SIZE - PAGE_CHECKSUM_SIZE - GetHeaderSize(); }
+auto BPlusTreePage::GetUsedSpace() const -> int { return GetCapacity() - GetFreeSpace(); }
+auto BPlusTreePage::GetFreeSpace() const -> int {
+  return cells_begin_ - GetHeaderSize() - size_ * B_PLUS_TREE_SLOT_SIZE + dead_bytes_;
+}
+
+auto BPlusTreePage::GetExpandedSpace() const -> int {
+  int space = GetUsedSpace() - key_prefix_size_;
+  for (int i = 0; i < size_; i++) {
+    space += IsPrefixedAt(i) ? key_prefix_size_ : 0;
+  }
+  return space;
+}
+
+auto BPlusTreePage::IsFull() const -> bool { return size_ > GetMaxEntries() || GetFreeSpace() < max_entry_size_; }
+
+auto BPlusTreePage::IsUnderflow() const -> bool {
+  return size_ < GetMinSize() && GetUsedSpace() < GetCapacity() / 2;
+}
+
+/*
+ * Helper methods for the cells of the entries
+ */
+void BPlusTreePage::InitCells(int max_entry_size, bool compress_key_prefix) {
+  max_entry_size_ = max_entry_size;
+  flags_ = compress_key_prefix ? KEY_PREFIX_COMPRESSION : 0;
+  ClearCells({});
+}
+
+auto BPlusTreePage::GetSplitIndex(int half_size) const -> int {
+  if (size_ > GetMaxEntries()) {
+    return half_size;
+  }
+  // Split the bytes of the entries in half, leaving each half at least an entry
+  int total = 0;
+  for (int i = 0; i < size_; i++) {
+    total += B_PLUS_TREE_SLOT_SIZE + CellSizeAt(i);
+  }
+  int index = 0;
+  for (int bytes = 0; index < size_ - 1 && 2 * bytes < total; index++) {
+    bytes += B_PLUS_TREE_SLOT_SIZE + CellSizeAt(index);
+  }
+  return std::max(index, 1);
+}
+
+auto BPlusTreePage::HasKeyPrefixCompression() const -> bool { return (flags_ & KEY_PREFIX_COMPRESSION) != 0; }
+
+auto BPlusTreePage::GetKeyPrefix() const -> std::string_view {
+  return {reinterpret_cast<const char *>(this) + PAGE_SIZE - PAGE_CHECKSUM_SIZE - key_prefix_size_,
+          key_prefix_size_};
+}
+
+auto BPlusTreePage::ChooseKeyPrefix(const std::vector<std::string_view> &keys, std::vector<std::string> candidates)
+    -> std::string {
+  if (keys.empty()) {
+    return {};
+  }
+  std::string_view common = keys[0];
+  for (auto key : keys) {
+    auto mismatch = std::mismatch(common.begin(), common.end(), key.begin(), key.end()).first;
+    common = common.substr(0, mismatch - common.begin());
+  }
+  candidates.emplace_back(common);
+  // A prefix saves its size on every key starting with it, but is stored once
+  std::string best;
+  int64_t best_saving = 0;
+  for (auto &candidate : candidates) {
+    int64_t saving = -static_cast<int64_t>(candidate.size());
+    for (auto key : keys) {
+      if (key.substr(0, candidate.size()) == candidate) {
+        saving += candidate.size();
+      }
+    }
+    if (saving > best_saving) {
+      best_saving = saving;
+      best = std::move(candidate);
+    }
+  }
+  return best;
+}
+
+auto BPlusTreePage::GetHeaderSize() const -> int {
+  return IsLeafPage() ? LEAF_PAGE_HEADER_SIZE : INTERNAL_PAGE_HEADER_SIZE;
+}
+
+auto BPlusTreePage::GetSlots() -> Slot * {
+  return reinterpret_cast<Slot *>(reinterpret_cast<char *>(this) + GetHeaderSize());
+}
+
+auto BPlusTreePage::GetSlots() const -> const Slot * {
+  return reinterpret_cast<const Slot *>(reinterpret_cast<const char *>(this) + GetHeaderSize());
+}
+
+auto BPlusTreePage::CellAt(int index) const -> const char * {
+  return reinterpret_cast<const char *>(this) + GetSlots()[index].offset_;
+}
+
+auto BPlusTreePage::CellSizeAt(int index) const -> int { return GetSlots()[index].size_ & ~SLOT_PREFIXED; }
+
+auto BPlusTreePage::IsPrefixedAt(int index) const -> bool { return (GetSlots()[index].size_ & SLOT_PREFIXED) != 0; }
+
+auto BPlusTreePage::GetMaxEntries() const -> int { return IsLeafPage() ? max_size_ - 1 : max_size_; }
+
+auto BPlusTreePage::AllocateCell(int index, size_t size, bool prefixed) -> char * {
+  BUSTUB_ASSERT(GetFreeSpace() >= static_cast<int>(B_PLUS_TREE_SLOT_SIZE + size), "the entry does not fit");
+  if (cells_begin_ - GetHeaderSize() - (size_ + 1) * B_PLUS_TREE_SLOT_SIZE < static_cast<int>(size)) {
+    Compact();
+  }
+  Slot *slots = GetSlots();
+  std::move_backward(slots + index, slots + size_, slots + size_ + 1);
+  cells_begin_ -= size;
+  slots[index] = {cells_begin_, static_cast<uint16_t>(size | (prefixed ? SLOT_PREFIXED : 0))};
+  size_++;
+  return reinterpret_cast<char *>(this) + cells_begin_;
+}
+
+void BPlusTreePage::RemoveCell(int index) {
+  Slot *slots = GetSlots();
+  if (slots[index].offset_ == cells_begin_) {
+    cells_begin_ += CellSizeAt(index);
+  } else {
+    dead_bytes_ += CellSizeAt(index);
+  }
+  std::move(slots + index + 1, slots + size_, slots + index);
+  size_--;
+}
+
+void BPlusTreePage::ClearCells(std::string_view key_prefix) {
+  // The new prefix may be a copy of the old one, which it overlaps
+  char *end = reinterpret_cast<char *>(this) + PAGE_SIZE - PAGE_CHECKSUM_SIZE;
+  memmove(end - key_prefix.size(), key_prefix.data(), key_prefix.size());
+  key_prefix_size_ = key_prefix.size();
+  cells_begin_ = PAGE_SIZE - PAGE_CHECKSUM_SIZE - key_prefix_size_;
+  dead_bytes_ = 0;
+  size_ = 0;
+}
+
+void BPlusTreePage::Compact() {
+  char copy[PAGE_SIZE];
+  memcpy(copy, this, PAGE_SIZE);
+  Slot *slots = GetSlots();
+  cells_begin_ = PAGE_SIZE - PAGE_CHECKSUM_SIZE - key_prefix_size_;
+  for (int i = 0; i < size_; i++) {
+    int size = CellSizeAt(i);
+    cells_begin_ -= size;
+    memcpy(reinterpret_cast<char *>(this) + cells_begin_, copy + slots[i].offset_, size);
+    slots[i].offset_ = cells_begin_;
+  }
+  dead_bytes_ = 0;
+}
+
 }  // namespace bustub
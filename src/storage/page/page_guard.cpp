@@ -0,0 +1,95 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.cpp
+//
+// Identification: src/storage/page/page_guard.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/page_guard.h"
+
+#include <utility>
+
+#include "buffer/buffer_pool_manager.h"
+
+namespace bustub {
+
+BasicPageGuard::BasicPageGuard(BasicPageGuard &&that) noexcept
+    : bpm_(that.bpm_), page_(std::exchange(that.page_, nullptr)), is_dirty_(std::exchange(that.is_dirty_, false)) {}
+
+auto BasicPageGuard::operator=(BasicPageGuard &&that) noexcept -> BasicPageGuard & {
+  if (this != &that) {
+    Drop();
+    bpm_ = that.bpm_;
+    page_ = std::exchange(that.page_, nullptr);
+    is_dirty_ = std::exchange(that.is_dirty_, false);
+  }
+  return *this;
+}
+
+void BasicPageGuard::Drop() {
+  if (page_ == nullptr) {
+    return;
+  }
+  bpm_->UnpinPage(page_->GetPageId(), is_dirty_);
+  page_ = nullptr;
+  is_dirty_ = false;
+}
+
+auto BasicPageGuard::UpgradeRead() -> ReadPageGuard {
+  ReadPageGuard guard;
+  if (page_ != nullptr) {
+    page_->RLatch();
+    guard.guard_ = std::move(*this);
+  }
+  return guard;
+}
+
+auto BasicPageGuard::UpgradeWrite() -> WritePageGuard {
+  WritePageGuard guard;
+  if (page_ != nullptr) {
+    page_->WLatch();
+    guard.guard_ = std::move(*this);
+  }
+  return guard;
+}
+
+auto ReadPageGuard::operator=(ReadPageGuard &&that) noexcept -> ReadPageGuard & {
+  if (this != &that) {
+    Drop();
+    guard_ = std::move(that.guard_);
+  }
+  return *this;
+}
+
+void ReadPageGuard::Drop() {
+  if (guard_.page_ == nullptr) {
+    return;
+  }
+  // Unlatch first: once unpinned, the frame may be handed to another page
+  guard_.page_->RUnlatch();
+  guard_.Drop();
+}
+
+auto WritePageGuard::operator=(WritePageGuard &&that) noexcept -> WritePageGuard & {
+  if (this != &that) {
+    Drop();
+    guard_ = std::move(that.guard_);
+  }
+  return *this;
+}
+
+void WritePageGuard::Drop() {
+  if (guard_.page_ == nullptr) {
+    return;
+  }
+  // Unlatch first: once unpinned, the frame may be handed to another page
+  guard_.page_->WUnlatch();
+  guard_.Drop();
+}
+
+}  // namespace bustub
@@ -16,8 +16,8 @@
 
 namespace bustub {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferAccessStrategy *strategy)
+    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn), strategy_(strategy) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
     table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
   }
@@ -35,19 +35,19 @@ auto TableIterator::operator->() -> Tuple * {
 
 auto TableIterator::operator++() -> TableIterator & {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
-  cur_page->RLatch();
-  assert(cur_page != nullptr);  // all pages are pinned
+  auto cur_guard = buffer_pool_manager->FetchPageRead(tuple_->rid_.GetPageId(), strategy_);
+  assert(cur_guard);  // all pages are pinned
 
   RID next_tuple_rid;
-  if (!cur_page->GetNextTupleRid(tuple_->rid_,
-                                 &next_tuple_rid)) {  // end of this page
-    while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
-      cur_page->RUnlatch();
-      buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
-      cur_page = next_page;
-      cur_page->RLatch();
+  if (!cur_guard.As<TablePage>()->GetNextTupleRid(tuple_->rid_,
+                                                 &next_tuple_rid)) {  // end of this page
+    while (cur_guard.As<TablePage>()->GetNextPageId() != INVALID_PAGE_ID) {
+      // The next page is latched before the current one is released
+      cur_guard = buffer_pool_manager->FetchPageRead(cur_guard.As<TablePage>()->GetNextPageId(), strategy_);
+      auto cur_page = cur_guard.As<TablePage>();
+      // Keep reading ahead while the tuples of this page are being consumed
+      buffer_pool_manager->PrefetchRange(cur_page->GetNextPageId(), SCAN_PREFETCH_DISTANCE,
+                                         TablePage::GetNextPageIdOffset());
       if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
         break;
       }
@@ -59,8 +59,6 @@ auto TableIterator::operator++() -> TableIterator & {
     table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
   }
   // release until copy the tuple
-  cur_page->RUnlatch();
-  buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
   return *this;
 }
 
@@ -11,9 +11,18 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/buffer_pool_manager_instance.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
 
@@ -47,7 +56,9 @@ TEST(BufferPoolManagerInstanceTest, BinaryDataTest) {
 
   // Insert terminal characters both in the middle and at end
   random_binary_data[PAGE_SIZE / 2] = '\0';
-  random_binary_data[PAGE_SIZE - 1] = '\0';
+  random_binary_data[PAGE_SIZE - PAGE_CHECKSUM_SIZE - 1] = '\0';
+  // The checksum trailer belongs to the disk manager, it reads as zeros
+  memset(random_binary_data + PAGE_SIZE - PAGE_CHECKSUM_SIZE, 0, PAGE_CHECKSUM_SIZE);
 
   // Scenario: Once we have a page, we should be able to read and write content.
   std::memcpy(page0->GetData(), random_binary_data, PAGE_SIZE);
@@ -141,4 +152,642 @@ TEST(BufferPoolManagerInstanceTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+// Hits on resident pages race with misses that evict them, every fetched page must carry its own content
+TEST(BufferPoolManagerInstanceTest, ConcurrentFetchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const int num_pages = 25;
+  const int num_threads = 8;
+  const int num_rounds = 2000;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    ASSERT_EQ(i, page_id_temp);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([bpm, tid] {
+      std::default_random_engine rng(tid);
+      // Mostly hit a small hot set, sometimes miss on the rest of the pages
+      std::uniform_int_distribution<int> hot_dist(0, 3);
+      std::uniform_int_distribution<int> cold_dist(0, num_pages - 1);
+      for (int round = 0; round < num_rounds; ++round) {
+        auto page_id = round % 8 == 0 ? cold_dist(rng) : hot_dist(rng);
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        char expected[PAGE_SIZE];
+        snprintf(expected, PAGE_SIZE, "page %d", page_id);
+        page->RLatch();
+        EXPECT_EQ(page_id, page->GetPageId());
+        EXPECT_EQ(0, strcmp(page->GetData(), expected));
+        page->RUnlatch();
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Scenario: every pin has been released, so the whole pool can be reused for new pages.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id_temp;
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, BackgroundWriterTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const auto old_interval = bg_writer_interval;
+  bg_writer_interval = std::chrono::milliseconds(5);
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  bpm->RunBackgroundWriter(0.0, 0.5);
+
+  // Scenario: dirty every frame and leave it unpinned, the background writer should clean all of them.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  for (int i = 0; i < 1000 && bpm->GetNumBackgroundFlushes() < buffer_pool_size; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  EXPECT_EQ(buffer_pool_size, bpm->GetNumBackgroundFlushes());
+  bpm->StopBackgroundWriter();
+
+  // Scenario: evicting the cleaned pages does not need any foreground flush, and their content made it to disk.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id_temp;
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+  EXPECT_EQ(buffer_pool_size, bpm->GetNumEvictions());
+  EXPECT_EQ(0, bpm->GetNumForegroundFlushes());
+  for (int i = 0; i < static_cast<int>(buffer_pool_size); ++i) {
+    char expected[PAGE_SIZE];
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+
+  // Scenario: new pages never fail while the background writer keeps cleaning, the frames it writes out are not
+  // pinned.
+  bpm->RunBackgroundWriter(0.0, 0.0);
+  for (int i = 0; i < 2000; ++i) {
+    page_id_t page_id_temp;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  bpm->StopBackgroundWriter();
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+  bg_writer_interval = old_interval;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ClockReplacerTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, ReplacerType::CLOCK);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+
+  // Scenario: unpinned pages get evicted by the clock, pinned ones stay resident.
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, true));
+  }
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(nullptr, bpm->FetchPage(0));
+
+  // Scenario: evicted pages can be read back.
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  auto *page0 = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, strcmp(page0->GetData(), "page 0"));
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ScanResistanceTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const int num_hot_pages = 3;
+  const int num_pages = 40;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, ReplacerType::LRU_K);
+
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: a few pages are looked up over and over again.
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < num_hot_pages; ++i) {
+      ASSERT_NE(nullptr, bpm->FetchPage(i));
+      EXPECT_EQ(true, bpm->UnpinPage(i, false));
+    }
+  }
+
+  // Scenario: a sequential scan reads every other page, fetching each one once per tuple.
+  for (int i = num_hot_pages; i < num_pages; ++i) {
+    for (int tuple = 0; tuple < 4; ++tuple) {
+      ASSERT_NE(nullptr, bpm->FetchPage(i));
+      EXPECT_EQ(true, bpm->UnpinPage(i, false));
+    }
+  }
+
+  // The hot pages are still resident.
+  for (int i = 0; i < num_hot_pages; ++i) {
+    auto *pages = bpm->GetPages();
+    EXPECT_TRUE(std::any_of(pages, pages + buffer_pool_size, [i](Page &page) { return page.GetPageId() == i; }));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, AccessStrategyTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const int num_hot_pages = 5;
+  const int num_pages = 40;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: a bulk load creates pages through a ring of two frames.
+  BufferAccessStrategy load_strategy(2);
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    ASSERT_TRUE(bpm->NewPageGuarded(&page_id_temp, &load_strategy));
+  }
+  EXPECT_EQ(num_pages - 2, bpm->GetNumRingRecycles());
+
+  for (int i = 0; i < num_hot_pages; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+
+  // Scenario: a sequential scan reads the remaining pages through a ring of two frames. It must not evict the hot
+  // pages, even though they were used less recently.
+  BufferAccessStrategy scan_strategy(2);
+  for (int i = num_hot_pages; i < num_pages; ++i) {
+    ASSERT_TRUE(bpm->FetchPageBasic(i, &scan_strategy));
+  }
+  for (int i = 0; i < num_hot_pages; ++i) {
+    auto *pages = bpm->GetPages();
+    EXPECT_TRUE(std::any_of(pages, pages + buffer_pool_size, [i](Page &page) { return page.GetPageId() == i; }));
+  }
+
+  // Scenario: pages pinned by the scan cannot be recycled, the ring falls back to the replacer.
+  {
+    auto first = bpm->FetchPageBasic(num_hot_pages, &scan_strategy);
+    auto second = bpm->FetchPageBasic(num_hot_pages + 1, &scan_strategy);
+    auto third = bpm->FetchPageBasic(num_hot_pages + 2, &scan_strategy);
+    ASSERT_TRUE(first && second && third);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PrefetchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const int num_pages = 20;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: the pages form a chain, each one stores the id of the next one at its beginning.
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    page_id_t next_page_id = i + 1 < num_pages ? i + 1 : INVALID_PAGE_ID;
+    memcpy(page->GetData(), &next_page_id, sizeof(page_id_t));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: reading ahead follows the chain in the background.
+  bpm->PrefetchRange(0, 4, 0);
+  for (int i = 0; i < 1000 && bpm->GetNumPrefetches() < 4; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(4, bpm->GetNumPrefetches());
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  EXPECT_EQ(4, bpm->GetStats().hits_);
+
+  // Scenario: fetching pages while they are being read ahead waits for their content.
+  bpm->PrefetchRange(4, num_pages, 0);
+  for (int i = 0; i < num_pages; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    page_id_t next_page_id;
+    memcpy(&next_page_id, page->GetData(), sizeof(page_id_t));
+    EXPECT_EQ(i + 1 < num_pages ? i + 1 : INVALID_PAGE_ID, next_page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, BatchFetchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const int num_pages = 20;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: every page stores its own id. Only the last buffer_pool_size pages stay resident.
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    memcpy(page->GetData(), &page_id_temp, sizeof(page_id_t));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: misses on consecutive pages are read with a single disk request, hits are not read at all.
+  std::vector<page_id_t> page_ids{5, 0, 1, 2, 6, 19, 2};
+  std::vector<Page *> pages;
+  auto num_reads = disk_manager->GetNumReads();
+  EXPECT_EQ(true, bpm->FetchPages(page_ids, &pages));
+  EXPECT_EQ(num_reads + 2, disk_manager->GetNumReads());
+  ASSERT_EQ(page_ids.size(), pages.size());
+  for (size_t i = 0; i < page_ids.size(); ++i) {
+    ASSERT_NE(nullptr, pages[i]);
+    EXPECT_EQ(page_ids[i], pages[i]->GetPageId());
+    page_id_t stored_page_id;
+    memcpy(&stored_page_id, pages[i]->GetData(), sizeof(page_id_t));
+    EXPECT_EQ(page_ids[i], stored_page_id);
+  }
+  // Scenario: duplicates share the frame and are pinned once per occurrence.
+  EXPECT_EQ(pages[3], pages[6]);
+  EXPECT_EQ(2, pages[3]->GetPinCount());
+
+  EXPECT_EQ(true, bpm->UnpinPages(page_ids, false));
+  EXPECT_EQ(false, bpm->UnpinPages(page_ids, false));
+
+  // Scenario: once every frame is pinned, the pages which do not fit are left out.
+  std::vector<page_id_t> too_many_page_ids;
+  for (int i = 0; i < static_cast<int>(buffer_pool_size) + 1; ++i) {
+    too_many_page_ids.push_back(i);
+  }
+  EXPECT_EQ(false, bpm->FetchPages(too_many_page_ids, &pages));
+  EXPECT_EQ(1, std::count(pages.begin(), pages.end(), nullptr));
+  std::vector<page_id_t> fetched_page_ids;
+  for (size_t i = 0; i < pages.size(); ++i) {
+    if (pages[i] != nullptr) {
+      fetched_page_ids.push_back(too_many_page_ids[i]);
+    }
+  }
+  EXPECT_EQ(true, bpm->UnpinPages(fetched_page_ids, false));
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PageReuseTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  page_id_t page_id;
+  for (int i = 0; i < 8; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: deleting an id that was never allocated does not hand it out ahead of its turn.
+  EXPECT_TRUE(bpm->DeletePage(20));
+
+  // Scenario: deleted pages are reused before new ones, whether they are in the buffer pool or not.
+  EXPECT_TRUE(bpm->DeletePage(6));
+  EXPECT_TRUE(bpm->DeletePage(1));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(1, page_id);
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  bpm->FlushAllPages();
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+
+  // Scenario: after a restart, the free pages are reused first, then new pages continue after the file.
+  disk_manager = new DiskManager(db_name);
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(6, page_id);
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(8, page_id);
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.free");
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, CorruptedPageTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  page_id_t page_id;
+  for (int i = 0; i < 4; ++i) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  bpm->FlushAllPages();
+  delete bpm;
+
+  int fd = open(db_name.c_str(), O_WRONLY);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(1, pwrite(fd, "x", 1, 2 * PAGE_SIZE));
+  close(fd);
+
+  // Scenario: a corrupted page cannot be fetched, alone or in a batch, and its frame is not lost.
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  EXPECT_EQ(nullptr, bpm->FetchPage(2));
+  std::vector<Page *> pages;
+  EXPECT_FALSE(bpm->FetchPages({0, 1, 2, 3}, &pages));
+  EXPECT_EQ(nullptr, pages[2]);
+  for (page_id_t i : {0, 1, 3}) {
+    ASSERT_NE(nullptr, pages[i]);
+    EXPECT_EQ("page " + std::to_string(i), pages[i]->GetData());
+  }
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_TRUE(bpm->UnpinPages({0, 1, 3, page_id}, false));
+  EXPECT_EQ(3, disk_manager->GetNumChecksumFailures());
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, StatsTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 3;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: a new page cannot be created while every frame is pinned.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  EXPECT_EQ(true, bpm->UnpinPage(0, true));
+  for (int i = 0; i < static_cast<int>(buffer_pool_size); ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, true));
+  }
+
+  // Scenario: the new page evicts dirty page 0, fetching page 0 again misses and evicts dirty page 1.
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+
+  auto stats = bpm->GetStats();
+  EXPECT_EQ(2, stats.fetches_);
+  EXPECT_EQ(1, stats.hits_);
+  EXPECT_EQ(1, stats.misses_);
+  EXPECT_DOUBLE_EQ(0.5, stats.HitRate());
+  EXPECT_EQ(2, stats.evictions_);
+  EXPECT_EQ(2, stats.dirty_evictions_);
+  EXPECT_EQ(1, stats.pin_failures_);
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, WarmUpTest) {
+  const std::string db_name = "test.db";
+  const std::string warm_up_file_name = "test.warmup";
+  const size_t buffer_pool_size = 5;
+  const int num_pages = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  // LRU, so that the saved recency order is exact
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, ReplacerType::LRU);
+
+  // Scenario: pages 5 to 9 stay resident, page 7 is the most recently used one.
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  ASSERT_NE(nullptr, bpm->FetchPage(7));
+  EXPECT_EQ(true, bpm->UnpinPage(7, false));
+  ASSERT_EQ(true, bpm->SaveResidentPages(warm_up_file_name));
+  bpm->FlushAllPages();
+  delete bpm;
+
+  std::ifstream warm_up_file(warm_up_file_name);
+  std::vector<page_id_t> saved_page_ids;
+  page_id_t saved_page_id;
+  while (warm_up_file >> saved_page_id) {
+    saved_page_ids.push_back(saved_page_id);
+  }
+  EXPECT_EQ((std::vector<page_id_t>{7, 9, 8, 6, 5}), saved_page_ids);
+
+  // Scenario: a smaller buffer pool warms up with the most recently used pages which fit.
+  bpm = new BufferPoolManagerInstance(3, disk_manager);
+  EXPECT_EQ(false, bpm->WarmUp("missing.warmup"));
+  ASSERT_EQ(true, bpm->WarmUp(warm_up_file_name));
+  for (int i = 0; i < 1000 && bpm->GetNumPrefetches() < 3; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(3, bpm->GetNumPrefetches());
+  for (page_id_t page_id : {7, 8, 9}) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_id), page->GetData());
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(3, bpm->GetStats().hits_);
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove(warm_up_file_name.c_str());
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ArenaAllocationTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+
+  // Scenario: heap frames are carved out of one aligned block as well.
+  {
+    BufferPoolManagerInstance heap_bpm(buffer_pool_size, disk_manager);
+    char *data = heap_bpm.GetPages()[0].GetData();
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(data) % DiskManager::DIRECT_IO_ALIGNMENT);
+    for (size_t i = 0; i < buffer_pool_size; ++i) {
+      EXPECT_EQ(data + i * PAGE_SIZE, heap_bpm.GetPages()[i].GetData());
+    }
+  }
+
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, ReplacerType::LRU,
+                                            FrameAllocation::ARENA);
+
+  // Scenario: the page data starts at a huge page boundary, every frame's data is aligned for O_DIRECT.
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(bpm->GetPages()[0].GetData()) % (2 * 1024 * 1024));
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(bpm->GetPages()[i].GetData()) % DiskManager::DIRECT_IO_ALIGNMENT);
+  }
+
+  // Scenario: pages written out of arena frames can be read back after being evicted.
+  for (int i = 0; i < static_cast<int>(buffer_pool_size) * 2; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, page_id_temp);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  for (int i = 0; i < static_cast<int>(buffer_pool_size) * 2; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), page->GetData());
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+// Run with --gtest_also_run_disabled_tests. 10M frames would take 40 GB of memory, hence the sizes stop at 1M.
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, DISABLED_NewPageLatencyBenchmark) {
+  const std::string db_name = "test.db";
+  const int num_calls = 100000;
+
+  for (size_t buffer_pool_size : {10, 1000, 100000, 1000000}) {
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+    page_id_t page_id_temp;
+    for (size_t i = 0; i < buffer_pool_size; ++i) {
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    }
+
+    // Every frame is pinned, NewPage has to fail
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_calls; ++i) {
+      EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+    }
+    auto fail_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+    // A single frame is evictable at a time, NewPage has to find it
+    EXPECT_EQ(true, bpm->UnpinPage(0, false));
+    page_id_t unpinned_page_id = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_calls; ++i) {
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+      EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+      unpinned_page_id = page_id_temp;
+    }
+    auto evict_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    EXPECT_NE(0, unpinned_page_id);
+
+    std::cout << "pool_size " << buffer_pool_size << ": failing NewPage " << fail_ns.count() / num_calls
+              << " ns/op, evicting NewPage " << evict_ns.count() / num_calls << " ns/op" << std::endl;
+
+    delete bpm;
+    disk_manager->ShutDown();
+    remove("test.db");
+    delete disk_manager;
+  }
+}
+
 }  // namespace bustub
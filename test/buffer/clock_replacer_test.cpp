@@ -10,16 +10,19 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <memory>
 #include <thread>  // NOLINT
 #include <vector>
 
 #include "buffer/clock_replacer.h"
+#include "buffer/lru_replacer.h"
 #include "gtest/gtest.h"
 
 namespace bustub {
 
-TEST(ClockReplacerTest, DISABLED_SampleTest) {
+TEST(ClockReplacerTest, SampleTest) {
   ClockReplacer clock_replacer(7);
 
   // Scenario: unpin six elements, i.e. add them to the replacer.
@@ -59,4 +62,83 @@ TEST(ClockReplacerTest, DISABLED_SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+TEST(ClockReplacerTest, ConcurrencyTest) {
+  const int num_threads = 8;
+  const int frames_per_thread = 16;
+  ClockReplacer clock_replacer(num_threads * frames_per_thread);
+
+  // Scenario: every thread pins and unpins its own frames, leaving the odd ones unpinned.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&clock_replacer, tid] {
+      for (int round = 0; round < 1000; ++round) {
+        for (int i = 0; i < frames_per_thread; ++i) {
+          frame_id_t frame_id = tid * frames_per_thread + i;
+          clock_replacer.Unpin(frame_id);
+          if (round < 999 || i % 2 == 0) {
+            clock_replacer.Pin(frame_id);
+          }
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * frames_per_thread / 2, clock_replacer.Size());
+
+  // Scenario: concurrent victims hand out every unpinned frame exactly once.
+  std::vector<int> victimized(num_threads * frames_per_thread, 0);
+  threads.clear();
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&clock_replacer, &victimized] {
+      frame_id_t frame_id;
+      while (clock_replacer.Victim(&frame_id)) {
+        victimized[frame_id]++;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (size_t i = 0; i < victimized.size(); ++i) {
+    EXPECT_EQ(i % 2 == 1 ? 1 : 0, victimized[i]);
+  }
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
+// Pin/Unpin throughput of ClockReplacer against LRUReplacer, run with --gtest_also_run_disabled_tests
+TEST(ClockReplacerTest, DISABLED_ThroughputBenchmark) {
+  const int frames_per_thread = 64;
+  const int num_rounds = 20000;
+
+  auto run = [&](Replacer *replacer, int num_threads) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < num_threads; ++tid) {
+      threads.emplace_back([replacer, tid] {
+        for (int round = 0; round < num_rounds; ++round) {
+          frame_id_t frame_id = tid * frames_per_thread + round % frames_per_thread;
+          replacer->Unpin(frame_id);
+          replacer->Pin(frame_id);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return 2.0 * num_threads * num_rounds / elapsed.count();
+  };
+
+  printf("%8s %16s %16s\n", "threads", "lru ops/s", "clock ops/s");
+  for (int num_threads = 1; num_threads <= 64; num_threads *= 2) {
+    auto lru_replacer = std::make_unique<LRUReplacer>(num_threads * frames_per_thread);
+    auto clock_replacer = std::make_unique<ClockReplacer>(num_threads * frames_per_thread);
+    auto lru_ops = run(lru_replacer.get(), num_threads);
+    auto clock_ops = run(clock_replacer.get(), num_threads);
+    printf("%8d %16.0f %16.0f\n", num_threads, lru_ops, clock_ops);
+  }
+}
+
 }  // namespace bustub
@@ -0,0 +1,99 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer_test.cpp
+//
+// Identification: test/buffer/lru_k_replacer_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/lru_k_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_k_replacer(7, 2, 0);
+
+  // Scenario: unpin six elements, i.e. add them to the replacer.
+  lru_k_replacer.Unpin(1);
+  lru_k_replacer.Unpin(2);
+  lru_k_replacer.Unpin(3);
+  lru_k_replacer.Unpin(4);
+  lru_k_replacer.Unpin(5);
+  lru_k_replacer.Unpin(6);
+  lru_k_replacer.Unpin(1);
+  EXPECT_EQ(6, lru_k_replacer.Size());
+
+  // Scenario: access 1 a second time, it now has a finite backward 2-distance and goes after all the others.
+  lru_k_replacer.Pin(1);
+  lru_k_replacer.Unpin(1);
+  int value;
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(2, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(3, value);
+
+  // Scenario: pin elements in the replacer.
+  // Note that 3 has already been victimized, so pinning 3 should have no effect.
+  lru_k_replacer.Pin(3);
+  lru_k_replacer.Pin(4);
+  EXPECT_EQ(3, lru_k_replacer.Size());
+
+  // Scenario: unpin 4, which has been accessed twice now but more recently than 1.
+  lru_k_replacer.Unpin(4);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(5, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(6, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(1, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(4, value);
+  EXPECT_EQ(false, lru_k_replacer.Victim(&value));
+}
+
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+  LRUKReplacer lru_k_replacer(10, 2, 1);
+
+  // Scenario: frames 0 and 1 are hot, they get re-referenced in between other accesses.
+  for (int round = 0; round < 2; ++round) {
+    for (frame_id_t frame_id = 0; frame_id < 2; ++frame_id) {
+      lru_k_replacer.Pin(frame_id);
+      lru_k_replacer.Unpin(frame_id);
+    }
+  }
+
+  // Scenario: a scan touches frames 2-9 several times in a row each, like it does once per tuple.
+  for (frame_id_t frame_id = 2; frame_id < 10; ++frame_id) {
+    for (int tuple = 0; tuple < 5; ++tuple) {
+      lru_k_replacer.Pin(frame_id);
+      lru_k_replacer.Unpin(frame_id);
+    }
+  }
+  EXPECT_EQ(10, lru_k_replacer.Size());
+
+  // The scanned frames are all evicted before the hot ones, even though the hot ones were accessed first.
+  std::vector<frame_id_t> peeked;
+  lru_k_replacer.PeekVictims(3, &peeked);
+  EXPECT_EQ((std::vector<frame_id_t>{2, 3, 4}), peeked);
+  for (frame_id_t expected = 2; expected < 10; ++expected) {
+    frame_id_t frame_id;
+    ASSERT_EQ(true, lru_k_replacer.Victim(&frame_id));
+    EXPECT_EQ(expected, frame_id);
+  }
+  frame_id_t frame_id;
+  lru_k_replacer.Victim(&frame_id);
+  EXPECT_EQ(0, frame_id);
+  lru_k_replacer.Victim(&frame_id);
+  EXPECT_EQ(1, frame_id);
+}
+
+}  // namespace bustub
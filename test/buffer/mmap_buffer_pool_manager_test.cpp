@@ -0,0 +1,124 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// mmap_buffer_pool_manager_test.cpp
+//
+// Identification: test/buffer/mmap_buffer_pool_manager_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/mmap_buffer_pool_manager.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "concurrency/transaction.h"
+#include "gtest/gtest.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(MmapBufferPoolManagerTest, ReadOnlyTest) {
+  const std::string db_name = "test.db";
+  const int num_pages = 10;
+  remove(db_name.c_str());
+
+  {
+    DiskManager disk_manager(db_name);
+    BufferPoolManagerInstance bpm(num_pages, &disk_manager);
+    page_id_t page_id;
+    for (int i = 0; i < num_pages; ++i) {
+      auto guard = bpm.NewPageGuarded(&page_id);
+      snprintf(guard.GetDataMut(), PAGE_SIZE, "page %d", page_id);
+    }
+    bpm.FlushAllPages();
+    disk_manager.ShutDown();
+  }
+
+  MmapBufferPoolManager bpm(db_name);
+  EXPECT_EQ(num_pages, bpm.GetPoolSize());
+
+  // Scenario: pages are views of the mapping, fetching a page twice hands out the same data without copying it.
+  char expected[PAGE_SIZE];
+  for (int i = 0; i < num_pages; ++i) {
+    auto guard = bpm.FetchPageRead(i);
+    ASSERT_TRUE(guard);
+    memset(expected, 0, PAGE_SIZE);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    // The view leaves the checksum trailer in place
+    EXPECT_EQ(0, memcmp(expected, guard.GetData(), PAGE_SIZE - PAGE_CHECKSUM_SIZE));
+    auto *page = bpm.FetchPage(i);
+    EXPECT_EQ(guard.GetData(), page->GetData());
+    EXPECT_EQ(2, page->GetPinCount());
+    EXPECT_TRUE(bpm.UnpinPage(i, false));
+  }
+  EXPECT_EQ(1, bpm.FetchPage(0)->GetPinCount());
+  EXPECT_TRUE(bpm.UnpinPage(0, false));
+  EXPECT_FALSE(bpm.UnpinPage(0, false));
+
+  // Scenario: pages past the end of the file do not exist, and no page can be created or deleted.
+  EXPECT_EQ(nullptr, bpm.FetchPage(num_pages));
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, bpm.NewPage(&page_id));
+  EXPECT_FALSE(bpm.DeletePage(0));
+
+  // Scenario: batches are served from the mapping as well, every fetch is a hit.
+  std::vector<Page *> pages;
+  EXPECT_TRUE(bpm.FetchPages({1, 2, 3}, &pages));
+  EXPECT_TRUE(bpm.UnpinPages({1, 2, 3}, false));
+  EXPECT_FALSE(bpm.FetchPages({4, num_pages}, &pages));
+  EXPECT_EQ(nullptr, pages[1]);
+  EXPECT_TRUE(bpm.UnpinPage(4, false));
+  auto stats = bpm.GetStats();
+  EXPECT_EQ(2 * num_pages + 5, stats.fetches_);
+  EXPECT_EQ(stats.fetches_, stats.hits_);
+
+  remove(db_name.c_str());
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(MmapBufferPoolManagerTest, TableScanTest) {
+  const std::string db_name = "test.db";
+  // Enough tuples to fill a few pages, whatever the page size
+  const int num_tuples = PAGE_SIZE / 4;
+  remove(db_name.c_str());
+
+  Schema schema({Column("a", TypeId::INTEGER)});
+  Transaction txn(0);
+  page_id_t first_page_id;
+  {
+    DiskManager disk_manager(db_name);
+    BufferPoolManagerInstance bpm(50, &disk_manager);
+    TableHeap table(&bpm, nullptr, nullptr, &txn);
+    for (int i = 0; i < num_tuples; ++i) {
+      RID rid;
+      ASSERT_TRUE(table.InsertTuple(Tuple({ValueFactory::GetIntegerValue(i)}, &schema), &rid, &txn));
+    }
+    first_page_id = table.GetFirstPageId();
+    bpm.FlushAllPages();
+    disk_manager.ShutDown();
+  }
+
+  // Scenario: a table written by a buffer pool is scanned from the mapping of a read replica.
+  MmapBufferPoolManager bpm(db_name);
+  EXPECT_GT(bpm.GetPoolSize(), 1);
+  TableHeap table(&bpm, nullptr, nullptr, first_page_id);
+  int i = 0;
+  for (auto it = table.Begin(&txn); it != table.End(); ++it) {
+    EXPECT_EQ(i++, it->GetValue(&schema, 0).GetAs<int32_t>());
+  }
+  EXPECT_EQ(num_tuples, i);
+
+  remove(db_name.c_str());
+  remove("test.log");
+}
+
+}  // namespace bustub
@@ -13,7 +13,10 @@
 #include "buffer/parallel_buffer_pool_manager.h"
 #include <cstdio>
 #include <random>
+#include <set>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
 
@@ -48,7 +51,9 @@ TEST(ParallelBufferPoolManagerTest, BinaryDataTest) {
 
   // Insert terminal characters both in the middle and at end
   random_binary_data[PAGE_SIZE / 2] = '\0';
-  random_binary_data[PAGE_SIZE - 1] = '\0';
+  random_binary_data[PAGE_SIZE - PAGE_CHECKSUM_SIZE - 1] = '\0';
+  // The checksum trailer belongs to the disk manager, it reads as zeros
+  memset(random_binary_data + PAGE_SIZE - PAGE_CHECKSUM_SIZE, 0, PAGE_CHECKSUM_SIZE);
 
   // Scenario: Once we have a page, we should be able to read and write content.
   std::memcpy(page0->GetData(), random_binary_data, PAGE_SIZE);
@@ -151,4 +156,72 @@ TEST(ParallelBufferPoolManagerTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, HashRoutingTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t num_instances = 4;
+  const int num_threads = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager, nullptr,
+                                            ReplacerType::LRU, PageRouting::HASH);
+
+  // Scenario: concurrent NewPage calls fill up every instance and never hand out the same page id twice.
+  std::vector<std::vector<page_id_t>> page_ids(num_threads);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&, tid] {
+      page_id_t page_id_temp;
+      while (auto *page = bpm->NewPage(&page_id_temp)) {
+        snprintf(page->GetData(), PAGE_SIZE, "%d", page_id_temp);
+        page_ids[tid].push_back(page_id_temp);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::set<page_id_t> all_page_ids;
+  for (auto &ids : page_ids) {
+    all_page_ids.insert(ids.begin(), ids.end());
+  }
+  EXPECT_EQ(buffer_pool_size * num_instances, all_page_ids.size());
+  for (size_t i = 0; i < num_instances; ++i) {
+    EXPECT_DOUBLE_EQ(1.0, bpm->GetInstanceOccupancy(i));
+  }
+
+  // Scenario: pages are found in the instance their id is routed to.
+  for (auto page_id : all_page_ids) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  for (auto page_id : all_page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_id), page->GetData());
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  for (size_t i = 0; i < num_instances; ++i) {
+    EXPECT_DOUBLE_EQ(1.0, bpm->GetInstanceHitRate(i));
+  }
+
+  // Scenario: the counters of the instances add up. Each instance a failing NewPage tried counts a pin failure.
+  auto stats = bpm->GetStats();
+  EXPECT_EQ(all_page_ids.size(), stats.fetches_);
+  EXPECT_EQ(all_page_ids.size(), stats.hits_);
+  EXPECT_EQ(0, stats.misses_);
+  EXPECT_LE(num_threads * num_instances, stats.pin_failures_);
+  uint64_t pin_failures = 0;
+  for (size_t i = 0; i < num_instances; ++i) {
+    pin_failures += bpm->GetInstanceStats(i).pin_failures_;
+  }
+  EXPECT_EQ(pin_failures, stats.pin_failures_);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
@@ -12,6 +12,7 @@
 
 #include <string>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
@@ -688,4 +689,52 @@ TEST(CatalogTest, DISABLED_IndexInteraction3) {
   remove("catalog_test.log");
 }
 
+// A B+ tree index over a populated table is bulk loaded with every tuple
+TEST(CatalogTest, CreateBPlusTreeIndex) {
+  auto disk_manager = std::make_unique<DiskManager>("catalog_test.db");
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(64, disk_manager.get());
+  auto catalog = std::make_unique<Catalog>(bpm.get(), nullptr, nullptr);
+  Transaction txn{0};
+
+  const std::string table_name{"foobar"};
+
+  std::vector<Column> columns{};
+  columns.emplace_back("A", TypeId::BIGINT);
+  columns.emplace_back("B", TypeId::BOOLEAN);
+  Schema schema{columns};
+  auto *table_info = catalog->CreateTable(&txn, table_name, schema);
+  EXPECT_NE(Catalog::NULL_TABLE_INFO, table_info);
+
+  // Insert the keys out of order
+  const int num_tuples = 1000;
+  std::vector<std::pair<Tuple, RID>> tuples;
+  for (int i = 0; i < num_tuples; i++) {
+    std::vector<Value> values{};
+    values.emplace_back(ValueFactory::GetBigIntValue(i * 7919 % num_tuples));
+    values.emplace_back(ValueFactory::GetBooleanValue(i % 2 == 0));
+    Tuple tuple(values, &schema);
+    RID rid;
+    EXPECT_TRUE(table_info->table_->InsertTuple(tuple, &rid, &txn));
+    tuples.emplace_back(tuple, rid);
+  }
+
+  std::vector<Column> key_columns{Column{"A", TypeId::BIGINT}};
+  Schema key_schema{key_columns};
+  auto *index_info = catalog->CreateIndex<BigintKeyType, BigintValueType, BigintComparatorType>(
+      &txn, "index1", table_name, schema, key_schema, {0}, BIGINT_SIZE, BigintHashFunctionType{},
+      IndexType::BPlusTreeIndex);
+  EXPECT_NE(Catalog::NULL_INDEX_INFO, index_info);
+
+  for (auto &[tuple, rid] : tuples) {
+    std::vector<RID> index_rid{};
+    index_info->index_->ScanKey(tuple.KeyFromTuple(schema, key_schema, index_info->index_->GetKeyAttrs()), &index_rid,
+                                &txn);
+    ASSERT_EQ(1, index_rid.size());
+    EXPECT_EQ(rid.Get(), index_rid[0].Get());
+  }
+
+  remove("catalog_test.db");
+  remove("catalog_test.log");
+}
+
 }  // namespace bustub
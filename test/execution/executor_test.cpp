@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <memory>
 #include <numeric>
 #include <string>
@@ -31,6 +32,7 @@
 #include "execution/plans/delete_plan.h"
 #include "execution/plans/distinct_plan.h"
 #include "execution/plans/hash_join_plan.h"
+#include "execution/plans/index_scan_plan.h"
 #include "execution/plans/limit_plan.h"
 #include "execution/plans/seq_scan_plan.h"
 #include "execution/plans/update_plan.h"
@@ -46,6 +48,7 @@
  * particular, the tests in this file include:
  *
  * - Sequential Scan
+ * - Index Scan
  * - Insert (Raw)
  * - Insert (Select)
  * - Update
@@ -110,6 +113,64 @@ TEST_F(ExecutorTest, SimpleSeqScanTest) {
   }
 }
 
+// SELECT col_a, col_b FROM test_1 WHERE col_a BETWEEN 100 AND 200 AND col_b < 5, through an index on col_a
+TEST_F(ExecutorTest, SimpleIndexScanTest) {
+  // Construct the index
+  TableInfo *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  const Schema &schema = table_info->schema_;
+  auto key_schema = ParseCreateStatement("a bigint");
+  auto *index_info = GetExecutorContext()->GetCatalog()->CreateIndex<KeyType, ValueType, ComparatorType>(
+      GetTxn(), "index1", "test_1", schema, *key_schema, {0}, 8, HashFunctionType{}, IndexType::BPlusTreeIndex);
+
+  // Construct query plan, the range covers col_a and the predicate what is left
+  auto *col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto *col_b = MakeColumnValueExpression(schema, 0, "colB");
+  auto *const5 = MakeConstantValueExpression(ValueFactory::GetIntegerValue(5));
+  auto *predicate = MakeComparisonExpression(col_b, const5, ComparisonType::LessThan);
+  auto *out_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+  IndexScanPlanNode plan{out_schema,
+                         predicate,
+                         index_info->index_oid_,
+                         {ValueFactory::GetIntegerValue(100)},
+                         true,
+                         {ValueFactory::GetIntegerValue(200)},
+                         true};
+
+  // Execute
+  std::vector<Tuple> result_set{};
+  GetExecutionEngine()->Execute(&plan, &result_set, GetTxn(), GetExecutorContext());
+
+  // Verify against a sequential scan with the same predicate
+  SeqScanPlanNode scan_plan{out_schema, predicate, table_info->oid_};
+  std::vector<Tuple> scan_result_set{};
+  GetExecutionEngine()->Execute(&scan_plan, &scan_result_set, GetTxn(), GetExecutorContext());
+  std::vector<int32_t> expected;
+  for (const auto &tuple : scan_result_set) {
+    auto col_a_val = tuple.GetValue(out_schema, out_schema->GetColIdx("colA")).GetAs<int32_t>();
+    if (col_a_val >= 100 && col_a_val <= 200) {
+      expected.push_back(col_a_val);
+    }
+  }
+  std::sort(expected.begin(), expected.end());
+  ASSERT_EQ(result_set.size(), expected.size());
+  for (size_t i = 0; i < result_set.size(); i++) {
+    ASSERT_EQ(result_set[i].GetValue(out_schema, out_schema->GetColIdx("colA")).GetAs<int32_t>(), expected[i]);
+    ASSERT_TRUE(result_set[i].GetValue(out_schema, out_schema->GetColIdx("colB")).GetAs<int32_t>() < 5);
+  }
+
+  // SELECT col_a, col_b FROM test_1 WHERE col_a > 990 ORDER BY col_a DESC
+  IndexScanPlanNode desc_plan{
+      out_schema, nullptr, index_info->index_oid_, {ValueFactory::GetIntegerValue(990)}, false, {}, true,
+      ScanDirection::BACKWARD};
+  result_set.clear();
+  GetExecutionEngine()->Execute(&desc_plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(result_set.size(), TEST1_SIZE - 991);
+  for (size_t i = 0; i < result_set.size(); i++) {
+    ASSERT_EQ(result_set[i].GetValue(out_schema, out_schema->GetColIdx("colA")).GetAs<int32_t>(),
+              static_cast<int32_t>(TEST1_SIZE - 1 - i));
+  }
+}
+
 // INSERT INTO empty_table2 VALUES (100, 10), (101, 11), (102, 12)
 TEST_F(ExecutorTest, SimpleRawInsertTest) {
   // Create Values to insert
@@ -10,9 +10,11 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <chrono>  // NOLINT
 #include <cstdio>
 #include <functional>
+#include <random>
 #include <thread>  // NOLINT
 
 #include "buffer/buffer_pool_manager_instance.h"
@@ -100,7 +102,7 @@ void DeleteHelperSplit(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> *tree
   delete transaction;
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest1) {
+TEST(BPlusTreeConcurrentTest, InsertTest1) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -146,13 +148,13 @@ TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest1) {
   EXPECT_EQ(current_key, keys.size() + 1);
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   remove("test.db");
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest2) {
+TEST(BPlusTreeConcurrentTest, InsertTest2) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -197,13 +199,13 @@ TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest2) {
   EXPECT_EQ(current_key, keys.size() + 1);
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   remove("test.db");
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest1) {
+TEST(BPlusTreeConcurrentTest, DeleteTest1) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -239,13 +241,13 @@ TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest1) {
   EXPECT_EQ(size, 1);
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   remove("test.db");
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest2) {
+TEST(BPlusTreeConcurrentTest, DeleteTest2) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -282,13 +284,13 @@ TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest2) {
   EXPECT_EQ(size, 4);
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   remove("test.db");
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_MixTest) {
+TEST(BPlusTreeConcurrentTest, MixTest) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -327,10 +329,140 @@ TEST(BPlusTreeConcurrentTest, DISABLED_MixTest) {
   EXPECT_EQ(size, 5);
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
   delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// Small pages make the threads split, merge and redistribute pages all the time, with a deep tree
+TEST(BPlusTreeConcurrentTest, SmallPagesMixTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(256, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 4);
+  GenericKey<8> index_key;
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  const int num_threads = 8;
+  std::vector<int64_t> keys;
+  for (int64_t key = 1; key <= 2000; key++) {
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  LaunchParallelTest(num_threads, InsertHelperSplit, &tree, keys, num_threads);
+
+  // Remove the odd keys while scanning and inserting keys past the end
+  std::vector<int64_t> remove_keys;
+  for (auto key : keys) {
+    if (key % 2 == 1) {
+      remove_keys.push_back(key);
+    }
+  }
+  std::vector<int64_t> new_keys;
+  for (int64_t key = 2001; key <= 2500; key++) {
+    new_keys.push_back(key);
+  }
+  std::thread scanner([&tree] {
+    for (int i = 0; i < 10; i++) {
+      int64_t previous_key = 0;
+      for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+        int64_t key = (*iterator).second.GetSlotNum();
+        EXPECT_LT(previous_key, key);
+        previous_key = key;
+      }
+    }
+  });
+  std::thread inserter(InsertHelper, &tree, new_keys, 0);
+  LaunchParallelTest(num_threads, DeleteHelperSplit, &tree, remove_keys, num_threads);
+  scanner.join();
+  inserter.join();
+
+  std::vector<RID> rids;
+  for (int64_t key = 1; key <= 2500; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(key > 2000 || key % 2 == 0, tree.GetValue(index_key, &rids)) << key;
+  }
+  int64_t current_key = 2;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ(current_key, (*iterator).second.GetSlotNum());
+    current_key += current_key < 2000 ? 2 : 1;
+  }
+  EXPECT_EQ(2501, current_key);
+
+  // Empty the tree, and start it over
+  for (int64_t key = 1; key <= 2500; key++) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key);
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+  EXPECT_TRUE(tree.Begin() == tree.End());
+  index_key.SetFromInteger(42);
+  EXPECT_TRUE(tree.Insert(index_key, RID(0, 42)));
+  EXPECT_FALSE(tree.Insert(index_key, RID(0, 42)));
+  EXPECT_FALSE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete bpm;
+  delete disk_manager;
   remove("test.db");
   remove("test.log");
 }
 
+// Run with --gtest_also_run_disabled_tests. Throughput of a read mostly workload, 90% lookups and 10% inserts, with
+// 1 to 32 threads.
+TEST(BPlusTreeConcurrentTest, DISABLED_ScalingBenchmark) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  const int64_t num_keys = 100000;
+  const int ops_per_thread = 200000;
+
+  for (int num_threads = 1; num_threads <= 32; num_threads *= 2) {
+    auto *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManagerInstance(4096, disk_manager);
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
+    page_id_t page_id;
+    bpm->NewPage(&page_id);
+    GenericKey<8> index_key;
+    for (int64_t key = 0; key < num_keys; key += 2) {
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, RID(0, key));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    LaunchParallelTest(num_threads, [&tree, ops_per_thread](uint64_t thread_itr) {
+      std::mt19937_64 rng(thread_itr);
+      GenericKey<8> key;
+      std::vector<RID> rids;
+      for (int i = 0; i < ops_per_thread; i++) {
+        auto value = static_cast<int64_t>(rng() % num_keys);
+        key.SetFromInteger(value);
+        if (i % 10 == 0) {
+          tree.Insert(key, RID(0, value));
+        } else {
+          rids.clear();
+          tree.GetValue(key, &rids);
+        }
+      }
+    });
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    std::cout << num_threads << " threads: " << num_threads * ops_per_thread / std::max<int64_t>(elapsed.count(), 1)
+              << " ops/ms" << std::endl;
+
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+    delete bpm;
+    delete disk_manager;
+    remove("test.db");
+    remove("test.log");
+  }
+}
+
 }  // namespace bustub
@@ -12,6 +12,9 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <numeric>
+#include <random>
+#include <string>
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "gtest/gtest.h"
@@ -20,7 +23,7 @@
 
 namespace bustub {
 
-TEST(BPlusTreeTests, DISABLED_InsertTest1) {
+TEST(BPlusTreeTests, InsertTest1) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -72,13 +75,13 @@ TEST(BPlusTreeTests, DISABLED_InsertTest1) {
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete transaction;
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
   remove("test.db");
   remove("test.log");
 }
 
-TEST(BPlusTreeTests, DISABLED_InsertTest2) {
+TEST(BPlusTreeTests, InsertTest2) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -140,9 +143,258 @@ TEST(BPlusTreeTests, DISABLED_InsertTest2) {
 
   bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete transaction;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, BulkLoadTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 5);
+  GenericKey<8> index_key;
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // Load the even keys, each twice, which keeps the first
+  int64_t num_keys = 1000;
+  int64_t next_key = 0;
+  auto next = [&](std::pair<GenericKey<8>, RID> *item) {
+    if (next_key >= num_keys) {
+      return false;
+    }
+    item->first.SetFromInteger(next_key / 2 * 2);
+    item->second = RID(static_cast<int32_t>(next_key % 2), next_key / 2 * 2);
+    next_key++;
+    return true;
+  };
+  EXPECT_TRUE(tree.BulkLoad(next, 0.75));
+  EXPECT_FALSE(tree.BulkLoad(next));
+
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < num_keys; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    ASSERT_EQ(key % 2 == 0, tree.GetValue(index_key, &rids));
+    if (key % 2 == 0) {
+      EXPECT_EQ(0, rids[0].GetPageId());
+      EXPECT_EQ(key, rids[0].GetSlotNum());
+    }
+  }
+
+  // The loaded tree keeps splitting and merging as usual
+  for (int64_t key = 1; key < num_keys; key += 2) {
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.Insert(index_key, RID(0, key)));
+  }
+  for (int64_t key = 0; key < num_keys; key += 3) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key);
+  }
+  int64_t current_key = 1;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ(current_key, (*iterator).second.GetSlotNum());
+    current_key += current_key % 3 == 2 ? 2 : 1;
+  }
+  EXPECT_EQ(num_keys, current_key);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, BulkLoadFailureTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 5);
+  GenericKey<8> index_key;
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // The input fails after a few pages were written, which leaves the tree empty and unlatched
+  int64_t num_keys = 100;
+  int64_t next_key = 0;
+  auto next = [&](std::pair<GenericKey<8>, RID> *item) {
+    if (next_key >= num_keys) {
+      throw Exception(ExceptionType::INVALID, "the input failed");
+    }
+    item->first.SetFromInteger(next_key);
+    item->second = RID(0, next_key);
+    next_key++;
+    return true;
+  };
+  EXPECT_THROW(tree.BulkLoad(next), Exception);
+  EXPECT_TRUE(tree.IsEmpty());
+
+  // A retry loads the tree as usual and the tree takes inserts again
+  auto retry = [&](std::pair<GenericKey<8>, RID> *item) {
+    if (next_key >= 2 * num_keys) {
+      return false;
+    }
+    item->first.SetFromInteger(next_key);
+    item->second = RID(0, next_key);
+    next_key++;
+    return true;
+  };
+  EXPECT_TRUE(tree.BulkLoad(retry));
+  std::vector<RID> rids;
+  index_key.SetFromInteger(0);
+  EXPECT_FALSE(tree.GetValue(index_key, &rids));
+  index_key.SetFromInteger(num_keys);
+  EXPECT_TRUE(tree.GetValue(index_key, &rids));
+  index_key.SetFromInteger(0);
+  EXPECT_TRUE(tree.Insert(index_key, RID(0, 0)));
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
   delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, IntegerKeyTest) {
+  // create KeyComparator and index schema, integer keys are searched without deserializing them
+  auto key_schema = ParseCreateStatement("a integer");
+  GenericComparator<8> comparator(key_schema.get());
+  ASSERT_EQ(4, comparator.GetIntegerKeySize());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 8, 8);
+  GenericKey<8> index_key;
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  auto set_key = [&](int32_t key) {
+    Tuple tuple({Value(TypeId::INTEGER, key)}, key_schema.get());
+    index_key.SetFromKey(tuple);
+  };
+  std::vector<int32_t> keys;
+  for (int32_t key = -1000; key < 1000; key += 2) {
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  for (auto key : keys) {
+    set_key(key);
+    EXPECT_TRUE(tree.Insert(index_key, RID(key, 0)));
+  }
+
+  std::vector<RID> rids;
+  for (int32_t key = -1001; key < 1000; key++) {
+    rids.clear();
+    set_key(key);
+    ASSERT_EQ(key % 2 == 0, tree.GetValue(index_key, &rids));
+    if (key % 2 == 0) {
+      EXPECT_EQ(key, rids[0].GetPageId());
+    }
+  }
+  set_key(-1);
+  int32_t current_key = 0;
+  for (auto iterator = tree.Begin(index_key); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ(current_key, (*iterator).second.GetPageId());
+    current_key += 2;
+  }
+  EXPECT_EQ(1000, current_key);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, VarcharKeyTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a varchar(40)");
+  GenericComparator<64> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<64>, RID, GenericComparator<64>> tree("foo_pk", bpm, comparator);
+  GenericKey<64> index_key;
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // Keys sharing a long prefix, which each leaf stores only once
+  auto set_key = [&](int64_t key) {
+    auto digits = std::to_string(key);
+    Tuple tuple({Value(TypeId::VARCHAR, "customer/" + std::string(9 - digits.size(), '0') + digits)},
+                key_schema.get());
+    index_key.SetFromKey(tuple);
+  };
+  int64_t num_keys = 5000;
+  std::vector<int64_t> keys(num_keys);
+  std::iota(keys.begin(), keys.end(), 0);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  for (auto key : keys) {
+    set_key(key);
+    EXPECT_TRUE(tree.Insert(index_key, RID(0, key)));
+  }
+
+  // A fixed size leaf would hold no more than 56 of these keys
+  page_id_t next_page_id;
+  bpm->NewPage(&next_page_id);
+  bpm->UnpinPage(next_page_id, false);
+  EXPECT_LT(next_page_id, num_keys / 100);
+
+  for (int64_t key = 0; key < num_keys; key += 2) {
+    set_key(key);
+    tree.Remove(index_key);
+  }
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < num_keys; key++) {
+    rids.clear();
+    set_key(key);
+    ASSERT_EQ(key % 2 == 1, tree.GetValue(index_key, &rids));
+    if (key % 2 == 1) {
+      EXPECT_EQ(key, rids[0].GetSlotNum());
+    }
+  }
+  int64_t current_key = 1;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ(current_key, (*iterator).second.GetSlotNum());
+    current_key += 2;
+  }
+  EXPECT_EQ(num_keys + 1, current_key);
+
+  for (auto key : keys) {
+    set_key(key);
+    tree.Remove(index_key);
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
   delete bpm;
+  delete disk_manager;
   remove("test.db");
   remove("test.log");
 }
+
 }  // namespace bustub
@@ -10,10 +10,24 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
 #include <cstring>
+#include <future>  // NOLINT
+#include <iostream>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "common/exception.h"
+#include "common/util/crc32c_util.h"
 #include "gtest/gtest.h"
+#include "storage/disk/async_disk_manager.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
@@ -24,12 +38,14 @@ class DiskManagerTest : public ::testing::Test {
   void SetUp() override {
     remove("test.db");
     remove("test.log");
+    remove("test.free");
   }
 
   // This function is called after every test.
   void TearDown() override {
     remove("test.db");
     remove("test.log");
+    remove("test.free");
   };
 };
 
@@ -55,6 +71,400 @@ TEST_F(DiskManagerTest, ReadWritePageTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ReadPagesTest) {
+  for (bool direct_io : {false, true}) {
+    remove("test.db");
+    auto dm = DiskManager("test.db", direct_io);
+    // Odd offsets, so that O_DIRECT has to go through the bounce buffer
+    std::vector<char> data(4 * PAGE_SIZE + 1);
+    std::vector<char> buf(4 * PAGE_SIZE + 1);
+    for (int i = 0; i < 3; ++i) {
+      snprintf(&data[1 + i * PAGE_SIZE], PAGE_SIZE, "page %d", i);
+      dm.WritePage(i, &data[1 + i * PAGE_SIZE]);
+    }
+
+    // Scenario: a run of pages is read with one request, pages past the end of file read as zeros.
+    std::memset(buf.data(), 1, buf.size());
+    char *pages[4];
+    for (int i = 0; i < 4; ++i) {
+      pages[i] = &buf[1 + i * PAGE_SIZE];
+    }
+    auto num_reads = dm.GetNumReads();
+    dm.ReadPages(0, 4, pages);
+    EXPECT_EQ(num_reads + 1, dm.GetNumReads());
+    EXPECT_EQ(std::memcmp(&buf[1], &data[1], 4 * PAGE_SIZE), 0);
+
+    // Scenario: concurrent readers do not share a file cursor.
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < 3; ++tid) {
+      threads.emplace_back([&dm, &data, tid] {
+        char page[PAGE_SIZE + 1];
+        for (int j = 0; j < 100; ++j) {
+          dm.ReadPage(tid, &page[1]);
+          EXPECT_EQ(std::memcmp(&page[1], &data[1 + tid * PAGE_SIZE], PAGE_SIZE), 0);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, AsyncReadWriteTest) {
+  const int num_pages = 32;
+  for (bool use_io_uring : {true, false}) {
+    remove("test.db");
+    auto dm = DiskManager("test.db");
+    std::vector<char> data(num_pages * PAGE_SIZE);
+    std::vector<char> buf(num_pages * PAGE_SIZE, 1);
+    {
+      // A queue shallower than the batch, so that issuing has to wait for completions
+      AsyncDiskManager async_dm(&dm, 4, use_io_uring);
+      if (use_io_uring && !async_dm.UsesIoUring()) {
+        continue;
+      }
+
+      // Scenario: a batch of writes completes its futures once submitted.
+      std::vector<std::future<bool>> writes;
+      for (int i = 0; i < num_pages; ++i) {
+        snprintf(&data[i * PAGE_SIZE], PAGE_SIZE, "page %d", i);
+        writes.push_back(async_dm.WritePageAsync(i, &data[i * PAGE_SIZE]));
+      }
+      async_dm.Submit();
+      for (auto &write : writes) {
+        EXPECT_TRUE(write.get());
+      }
+      EXPECT_EQ(num_pages, dm.GetNumWrites());
+
+      // Scenario: reads run their callbacks, the page past the end of file reads as zeros.
+      std::atomic<int> num_completed = 0;
+      for (int i = 0; i < num_pages; ++i) {
+        async_dm.ReadPageAsync(i, &buf[i * PAGE_SIZE], [&](bool success) {
+          EXPECT_TRUE(success);
+          num_completed++;
+        });
+      }
+      char zeros[PAGE_SIZE];
+      std::memset(zeros, 1, PAGE_SIZE);
+      auto past_end = async_dm.ReadPageAsync(num_pages, zeros);
+      async_dm.Drain();
+      EXPECT_EQ(num_pages, num_completed);
+      EXPECT_EQ(std::memcmp(buf.data(), data.data(), buf.size()), 0);
+      EXPECT_TRUE(past_end.get());
+      for (char c : zeros) {
+        EXPECT_EQ(0, c);
+      }
+    }
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, AsyncSubmitFailureTest) {
+  const int num_pages = 8;
+  auto dm = DiskManager("test.db");
+  std::vector<char> data(num_pages * PAGE_SIZE);
+  std::vector<char> buf(num_pages * PAGE_SIZE);
+  {
+    AsyncDiskManager async_dm(&dm, num_pages);
+    if (async_dm.UsesIoUring()) {
+      // Scenario: the kernel rejects a submission. The queued requests still complete, on the disk manager.
+      std::atomic<int> num_completed = 0;
+      std::vector<std::future<bool>> writes;
+      for (int i = 0; i < num_pages / 2; ++i) {
+        snprintf(&data[i * PAGE_SIZE], PAGE_SIZE, "page %d", i);
+        writes.push_back(async_dm.WritePageAsync(i, &data[i * PAGE_SIZE], [&](bool success) {
+          EXPECT_TRUE(success);
+          num_completed++;
+        }));
+      }
+      async_dm.InjectSubmitFailures(1);
+      async_dm.Submit();
+      for (auto &write : writes) {
+        EXPECT_TRUE(write.get());
+      }
+      EXPECT_EQ(num_pages / 2, num_completed);
+      EXPECT_FALSE(async_dm.UsesIoUring());
+
+      // Scenario: requests after the failure run synchronously, draining does not wait for the failed ring.
+      for (int i = num_pages / 2; i < num_pages; ++i) {
+        snprintf(&data[i * PAGE_SIZE], PAGE_SIZE, "page %d", i);
+        EXPECT_TRUE(async_dm.WritePageAsync(i, &data[i * PAGE_SIZE]).get());
+      }
+      for (int i = 0; i < num_pages; ++i) {
+        EXPECT_TRUE(async_dm.ReadPageAsync(i, &buf[i * PAGE_SIZE]).get());
+      }
+      async_dm.Drain();
+      EXPECT_EQ(std::memcmp(buf.data(), data.data(), buf.size()), 0);
+
+      // Scenario: the destructor stops the completion thread even though the ring rejects its wake-up request.
+      async_dm.InjectSubmitFailures(1);
+    }
+  }
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, AsyncWaitFailureTest) {
+  const int num_pages = 8;
+  auto dm = DiskManager("test.db");
+  std::vector<char> data(num_pages * PAGE_SIZE);
+  std::vector<char> buf(num_pages * PAGE_SIZE);
+  {
+    AsyncDiskManager async_dm(&dm, num_pages);
+    if (async_dm.UsesIoUring()) {
+      // Scenario: the ring breaks while requests are in flight. They still complete, on the disk manager.
+      std::atomic<int> num_completed = 0;
+      std::vector<std::future<bool>> writes;
+      for (int i = 0; i < num_pages; ++i) {
+        snprintf(&data[i * PAGE_SIZE], PAGE_SIZE, "page %d", i);
+        writes.push_back(async_dm.WritePageAsync(i, &data[i * PAGE_SIZE], [&](bool success) {
+          EXPECT_TRUE(success);
+          num_completed++;
+        }));
+      }
+      async_dm.InjectWaitFailure();
+      async_dm.Submit();
+      async_dm.Drain();
+      for (auto &write : writes) {
+        EXPECT_TRUE(write.get());
+      }
+      EXPECT_EQ(num_pages, num_completed);
+      EXPECT_FALSE(async_dm.UsesIoUring());
+
+      // Scenario: requests after the failure run synchronously.
+      for (int i = 0; i < num_pages; ++i) {
+        EXPECT_TRUE(async_dm.ReadPageAsync(i, &buf[i * PAGE_SIZE]).get());
+      }
+      EXPECT_EQ(std::memcmp(buf.data(), data.data(), buf.size()), 0);
+    }
+  }
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, FreePageTest) {
+  char data[PAGE_SIZE] = {0};
+  char buf[PAGE_SIZE] = {0};
+  {
+    auto dm = DiskManager("test.db");
+    for (int i = 0; i < 10; ++i) {
+      snprintf(data, sizeof(data), "page %d", i);
+      dm.WritePage(i, data);
+    }
+    EXPECT_EQ(10, dm.GetNumPages());
+
+    // Scenario: deallocated pages are handed out lowest first, to callers which can use them.
+    auto any = [](page_id_t) { return true; };
+    auto odd = [](page_id_t page_id) { return page_id % 2 == 1; };
+    EXPECT_EQ(INVALID_PAGE_ID, dm.AllocateFreePage(any));
+    dm.DeallocatePage(4);
+    dm.DeallocatePage(2);
+    dm.DeallocatePage(2);
+    dm.DeallocatePage(7);
+    EXPECT_EQ(3, dm.GetNumFreePages());
+    EXPECT_EQ(7, dm.AllocateFreePage(odd));
+    EXPECT_EQ(INVALID_PAGE_ID, dm.AllocateFreePage(odd));
+    EXPECT_EQ(2, dm.AllocateFreePage(any));
+    dm.DeallocatePage(2);
+    dm.DeallocatePage(9);
+    dm.DeallocatePage(12);  // past the end of file, never written
+    dm.ShutDown();
+  }
+
+  // Scenario: the free-page map survives a restart, pages past the end of file are new pages again.
+  auto dm = DiskManager("test.db");
+  EXPECT_EQ(3, dm.GetNumFreePages());
+
+  // Scenario: compaction cuts off the free tail and moves the last live page into the first hole.
+  std::vector<std::pair<page_id_t, page_id_t>> moves;
+  EXPECT_EQ(3, dm.Compact([&](page_id_t from, page_id_t to) { moves.emplace_back(from, to); }));
+  ASSERT_EQ(2, moves.size());
+  EXPECT_EQ(std::make_pair(8, 2), moves[0]);
+  EXPECT_EQ(std::make_pair(7, 4), moves[1]);
+  EXPECT_EQ(7, dm.GetNumPages());
+  EXPECT_EQ(0, dm.GetNumFreePages());
+  dm.ReadPage(2, buf);
+  EXPECT_STREQ("page 8", buf);
+  dm.ReadPage(4, buf);
+  EXPECT_STREQ("page 7", buf);
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ChecksumTest) {
+  EXPECT_EQ(0xE3069283, Crc32cUtil::Checksum("123456789", 9));
+
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  auto dm = DiskManager("test.db");
+  for (int i = 0; i < 4; ++i) {
+    snprintf(data, PAGE_SIZE, "page %d", i);
+    dm.WritePage(i, data);
+  }
+  // Pages read back as they were written, their checksum trailer reads as zeros
+  EXPECT_TRUE(dm.ReadPage(3, buf));
+  EXPECT_EQ(0, std::memcmp(buf, data, PAGE_SIZE));
+
+  // Scenario: a page corrupted on disk fails to read, on its own and within a run.
+  int fd = open("test.db", O_RDWR);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(1, pwrite(fd, "x", 1, PAGE_SIZE + 100));
+  EXPECT_FALSE(dm.ReadPage(1, buf));
+  EXPECT_EQ(1, dm.GetNumChecksumFailures());
+  char pages[3][PAGE_SIZE];
+  char *run[3] = {pages[0], pages[1], pages[2]};
+  EXPECT_FALSE(dm.ReadPages(0, 3, run));
+  EXPECT_STREQ("page 0", pages[0]);
+  EXPECT_STREQ("page 2", pages[2]);
+  {
+    AsyncDiskManager async_dm(&dm);
+    auto corrupted = async_dm.ReadPageAsync(1, pages[1]);
+    auto intact = async_dm.ReadPageAsync(2, pages[2]);
+    async_dm.Submit();
+    EXPECT_FALSE(corrupted.get());
+    EXPECT_TRUE(intact.get());
+  }
+  EXPECT_EQ(3, dm.GetNumChecksumFailures());
+
+  // Scenario: a write torn at the end of the file, only its first sector made it to disk.
+  ASSERT_EQ(0, ftruncate(fd, 3 * PAGE_SIZE + 512));
+  close(fd);
+  EXPECT_FALSE(dm.ReadPage(3, buf));
+
+  // Scenario: pages which were never written are valid, and rewriting a corrupted page fixes it.
+  EXPECT_TRUE(dm.ReadPage(10, buf));
+  snprintf(data, PAGE_SIZE, "page %d", 1);
+  dm.WritePage(1, data);
+  EXPECT_TRUE(dm.ReadPage(1, buf));
+  EXPECT_STREQ("page 1", buf);
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, CompressionTest) {
+  const int num_pages = 64;
+  auto file_size = [](const char *file_name) -> off_t {
+    struct stat stat_buf;
+    return stat(file_name, &stat_buf) == 0 ? stat_buf.st_size : -1;
+  };
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  // Table-like pages: tuples packed at the end, free space in the middle
+  constexpr size_t tuple_size = 48;
+  auto make_page = [&](int page, int version) {
+    memset(data, 0, PAGE_SIZE);
+    for (int slot = 0; slot < 40; ++slot) {
+      snprintf(data + PAGE_SIZE - PAGE_CHECKSUM_SIZE - tuple_size * (slot + 1), tuple_size,
+               "row %d-%d, customer #%d, v%d", page, slot, page * 40 + slot, version);
+    }
+  };
+  {
+    auto dm = DiskManager("test.db", false, true);
+    EXPECT_TRUE(dm.UsesCompression());
+    for (int i = 0; i < num_pages; ++i) {
+      make_page(i, 1);
+      dm.WritePage(i, data);
+    }
+    EXPECT_EQ(num_pages, dm.GetNumPages());
+    EXPECT_LT(file_size("test.db"), num_pages * PAGE_SIZE / 2);
+    make_page(7, 2);
+    dm.WritePage(7, data);
+
+    // Pages read back as they were written, through the synchronous and asynchronous paths alike
+    EXPECT_TRUE(dm.ReadPage(7, buf));
+    EXPECT_EQ(0, std::memcmp(buf, data, PAGE_SIZE));
+    AsyncDiskManager async_dm(&dm);
+    make_page(9, 1);
+    EXPECT_TRUE(async_dm.ReadPageAsync(9, buf).get());
+    EXPECT_EQ(0, std::memcmp(buf, data, PAGE_SIZE));
+    EXPECT_TRUE(dm.ReadPage(num_pages + 10, buf));
+    EXPECT_EQ(0, buf[0]);
+    dm.ShutDown();
+  }
+
+  // Scenario: a reopened file finds the latest version of every page, even when asked for an uncompressed one.
+  {
+    auto dm = DiskManager("test.db", true, false);
+    EXPECT_TRUE(dm.UsesCompression());
+    EXPECT_FALSE(dm.UsesDirectIO());
+    EXPECT_EQ(num_pages, dm.GetNumPages());
+    make_page(7, 2);
+    EXPECT_TRUE(dm.ReadPage(7, buf));
+    EXPECT_EQ(0, std::memcmp(buf, data, PAGE_SIZE));
+
+    // Scenario: the last extent is torn, the page reads as its previous version once the file is opened again.
+    make_page(3, 2);
+    dm.WritePage(3, data);
+    int fd = open("test.db", O_RDWR);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(0, ftruncate(fd, file_size("test.db") - 10));
+    close(fd);
+    EXPECT_FALSE(dm.ReadPage(3, buf));
+    EXPECT_EQ(1, dm.GetNumChecksumFailures());
+    dm.ShutDown();
+  }
+  auto dm = DiskManager("test.db", false, true);
+  make_page(3, 1);
+  EXPECT_TRUE(dm.ReadPage(3, buf));
+  EXPECT_EQ(0, std::memcmp(buf, data, PAGE_SIZE));
+
+  // Scenario: compaction drops overwritten and deallocated pages from the file.
+  for (int i = 0; i < num_pages; ++i) {
+    make_page(i, 3);
+    dm.WritePage(i, data);
+  }
+  for (int i = num_pages / 2; i < num_pages; ++i) {
+    dm.DeallocatePage(i);
+  }
+  auto size = file_size("test.db");
+  auto reclaimed = dm.Compact([](page_id_t, page_id_t) { FAIL(); });
+  EXPECT_EQ((size - file_size("test.db")) / PAGE_SIZE, reclaimed);
+  EXPECT_LT(file_size("test.db"), size / 3);
+  EXPECT_EQ(num_pages / 2, dm.GetNumPages());
+  EXPECT_EQ(0, dm.GetNumFreePages());
+  make_page(5, 3);
+  EXPECT_TRUE(dm.ReadPage(5, buf));
+  EXPECT_EQ(0, std::memcmp(buf, data, PAGE_SIZE));
+  dm.WritePage(num_pages, data);
+  EXPECT_TRUE(dm.ReadPage(num_pages, buf));
+  EXPECT_EQ(0, std::memcmp(buf, data, PAGE_SIZE));
+  dm.ShutDown();
+
+  // Scenario: an existing uncompressed file stays uncompressed.
+  remove("test.db");
+  {
+    auto raw = DiskManager("test.db");
+    raw.WritePage(0, data);
+    raw.ShutDown();
+  }
+  auto reopened = DiskManager("test.db", false, true);
+  EXPECT_FALSE(reopened.UsesCompression());
+  EXPECT_TRUE(reopened.ReadPage(0, buf));
+  EXPECT_EQ(0, std::memcmp(buf, data, PAGE_SIZE));
+  reopened.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, PageSizeTest) {
+  {
+    auto dm = DiskManager("test.db", false, true);
+    dm.ShutDown();
+  }
+  // Scenario: a compressed file created by a build with another page size is refused.
+  int fd = open("test.db", O_RDWR);
+  ASSERT_GE(fd, 0);
+  EXPECT_EQ(PAGE_SIZE, CompressedPageStore::GetFilePageSize(fd));
+  uint32_t page_size = PAGE_SIZE * 2;
+  ASSERT_EQ(sizeof(page_size), pwrite(fd, &page_size, sizeof(page_size), 12));
+  close(fd);
+  EXPECT_THROW(DiskManager("test.db"), Exception);
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ReadWriteLogTest) {
   char buf[16] = {0};
@@ -72,6 +482,40 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
   dm.ShutDown();
 }
 
+// Run with --gtest_also_run_disabled_tests. Compares the time spent on checksums with the time of the page I/O.
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DISABLED_ChecksumOverheadBenchmark) {
+  const int num_pages = 10000;
+  std::vector<char> data(PAGE_SIZE, 'x');
+  auto dm = DiskManager("test.db");
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_pages; ++i) {
+    dm.WritePage(i, data.data());
+  }
+  for (int i = 0; i < num_pages; ++i) {
+    dm.ReadPage(i, data.data());
+  }
+  auto io_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+  // Every page is checksummed once when it is written and once when it is read. The I/O above hits the page
+  // cache, so the printed overhead is against buffered I/O (10-15% at -O2), not against device latency.
+  uint32_t checksum = 0;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 2 * num_pages; ++i) {
+    memcpy(data.data(), &i, sizeof(i));
+    checksum += Crc32cUtil::Checksum(data.data(), PAGE_SIZE - PAGE_CHECKSUM_SIZE);
+  }
+  auto checksum_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  EXPECT_NE(0, checksum);
+
+  std::cout << "page I/O " << io_ns.count() / (2 * num_pages) << " ns/page, checksums "
+            << checksum_ns.count() / (2 * num_pages) << " ns/page ("
+            << (Crc32cUtil::IsHardwareAccelerated() ? "hardware" : "software") << "), overhead vs. page-cache I/O "
+            << 100.0 * checksum_ns.count() / io_ns.count() << "%" << std::endl;
+  dm.ShutDown();
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
 
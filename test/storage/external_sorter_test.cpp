@@ -0,0 +1,67 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_sorter_test.cpp
+//
+// Identification: test/storage/external_sorter_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/index/external_sorter.h"
+
+namespace bustub {
+
+using Item = std::pair<int32_t, int32_t>;
+
+namespace {
+
+auto SortItems(size_t run_bytes, const std::vector<Item> &items, size_t *num_runs) -> std::vector<Item> {
+  auto less = [](const Item &a, const Item &b) { return a.first < b.first; };
+  ExternalSorter<Item, decltype(less)> sorter(less, run_bytes);
+  for (const auto &item : items) {
+    sorter.Add(item);
+  }
+  sorter.Sort();
+  *num_runs = sorter.GetNumRuns();
+  std::vector<Item> sorted;
+  Item item;
+  while (sorter.Next(&item)) {
+    sorted.push_back(item);
+  }
+  return sorted;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(ExternalSorterTest, SortTest) {
+  // Keys repeat, the second half of each pair records the order the items were added in
+  std::mt19937 generator(15445);
+  std::vector<Item> items;
+  for (int32_t i = 0; i < 100000; i++) {
+    items.emplace_back(static_cast<int32_t>(generator() % 1000), i);
+  }
+  auto expected = items;
+  std::stable_sort(expected.begin(), expected.end(), [](const Item &a, const Item &b) { return a.first < b.first; });
+
+  size_t num_runs;
+  EXPECT_EQ(expected, SortItems(EXTERNAL_SORT_RUN_BYTES, items, &num_runs));
+  EXPECT_EQ(0, num_runs);
+
+  // Runs of 1000 items are spilled and merged back
+  EXPECT_EQ(expected, SortItems(1000 * sizeof(Item), items, &num_runs));
+  EXPECT_EQ(100, num_runs);
+
+  EXPECT_TRUE(SortItems(1000 * sizeof(Item), {}, &num_runs).empty());
+  EXPECT_EQ(0, num_runs);
+}
+
+}  // namespace bustub
@@ -0,0 +1,97 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard_test.cpp
+//
+// Identification: test/storage/page_guard_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/page/page_guard.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, BasicTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id;
+  {
+    auto guard = bpm->NewPageGuarded(&page_id);
+    ASSERT_TRUE(guard);
+    EXPECT_EQ(1, guard.GetPage()->GetPinCount());
+    snprintf(guard.GetDataMut(), PAGE_SIZE, "Hello");
+  }
+  // Scenario: the guard unpinned the page when it went out of scope, as dirty.
+  auto *page = bpm->FetchPage(page_id);
+  EXPECT_EQ(1, page->GetPinCount());
+  EXPECT_TRUE(page->IsDirty());
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+
+  // Scenario: moving hands the pin over, the moved-from guard does not unpin anything.
+  {
+    auto guard = bpm->FetchPageBasic(page_id);
+    BasicPageGuard other = std::move(guard);
+    EXPECT_FALSE(guard);  // NOLINT
+    EXPECT_EQ(1, page->GetPinCount());
+    other = bpm->FetchPageBasic(page_id);
+    EXPECT_EQ(1, page->GetPinCount());
+    other.Drop();
+    EXPECT_EQ(0, page->GetPinCount());
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+
+  // Scenario: a write guard holds the write latch until it is dropped.
+  {
+    auto guard = bpm->FetchPageWrite(page_id);
+    EXPECT_EQ(0, strcmp(guard.GetData(), "Hello"));
+    guard.Drop();
+    auto read_guard_1 = bpm->FetchPageRead(page_id);
+    auto read_guard_2 = bpm->FetchPageRead(page_id);
+    EXPECT_EQ(2, page->GetPinCount());
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+
+  // Scenario: upgrading a basic guard takes the latch and keeps the single pin.
+  {
+    auto guard = bpm->FetchPageBasic(page_id);
+    auto write_guard = guard.UpgradeWrite();
+    EXPECT_FALSE(guard);  // NOLINT
+    EXPECT_TRUE(write_guard);
+    EXPECT_EQ(1, page->GetPinCount());
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+
+  // Scenario: fetching fails once every frame is pinned, the guard is empty then.
+  {
+    BasicPageGuard guards[buffer_pool_size];
+    page_id_t new_page_id;
+    for (auto &guard : guards) {
+      guard = bpm->NewPageGuarded(&new_page_id);
+      EXPECT_TRUE(guard);
+    }
+    EXPECT_FALSE(bpm->NewPageGuarded(&new_page_id));
+  }
+  EXPECT_TRUE(bpm->NewPageGuarded(&page_id));
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -14,6 +14,7 @@
 #include <cstdio>
 #include <iostream>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
@@ -21,6 +22,7 @@
 #include "logging/common.h"
 #include "storage/table/table_heap.h"
 #include "storage/table/tuple.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 // NOLINTNEXTLINE
@@ -71,4 +73,49 @@ TEST(TupleTest, DISABLED_TableHeapTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(TupleTest, BulkInsertTest) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::INTEGER}}};
+  const size_t num_pages = 2 * BUFFER_RING_SIZE + 1;
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManagerInstance(50, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction);
+
+  // A bulk insert keeps appending to the tail page. It must not read the evicted pages of its ring back in to look
+  // for space in them.
+  BufferAccessStrategy strategy;
+  auto num_reads = disk_manager->GetNumReads();
+  std::unordered_set<page_id_t> page_ids;
+  int num_tuples = 0;
+  while (page_ids.size() < num_pages) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(Tuple({ValueFactory::GetIntegerValue(num_tuples)}, &schema), &rid, transaction,
+                                   &strategy));
+    page_ids.insert(rid.GetPageId());
+    ++num_tuples;
+  }
+  EXPECT_EQ(num_reads, disk_manager->GetNumReads());
+
+  int num_scanned = 0;
+  for (auto itr = table->Begin(transaction); itr != table->End(); ++itr) {
+    EXPECT_EQ(num_scanned, itr->GetValue(&schema, 0).GetAs<int32_t>());
+    ++num_scanned;
+  }
+  EXPECT_EQ(num_tuples, num_scanned);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
 }  // namespace bustub